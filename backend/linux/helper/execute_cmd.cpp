@@ -10,7 +10,7 @@ unsigned long ExecuteCmd::execute(const std::string &cmd, const std::string &cwd
     cmdDescr->bFinished = false;
     cmdDescr->bSuccess = false;
     cmdDescr->cmdId = curCmdId_;
-    executingCmds_.push_back(cmdDescr);
+    executingCmds_[curCmdId_] = cmdDescr;
     mutex_.unlock();
 
     if (!cwd.empty()) {
@@ -25,16 +25,14 @@ unsigned long ExecuteCmd::execute(const std::string &cmd, const std::string &cwd
 void ExecuteCmd::getStatus(unsigned long cmdId, bool &bFinished, std::string &log)
 {
     mutex_.lock();
-    for (auto it = executingCmds_.begin(); it != executingCmds_.end(); ++it) {
-        if ((*it)->cmdId == cmdId) {
-            bFinished = (*it)->bFinished;
-            log = (*it)->log;
+    auto it = executingCmds_.find(cmdId);
+    if (it != executingCmds_.end()) {
+        bFinished = it->second->bFinished;
+        log = it->second->log;
 
-            if ((*it)->bFinished) {
-                delete (*it);
-                executingCmds_.erase(it);
-            }
-            break;
+        if (it->second->bFinished) {
+            delete it->second;
+            executingCmds_.erase(it);
         }
     }
     mutex_.unlock();
@@ -44,7 +42,7 @@ void ExecuteCmd::clearCmds()
 {
     mutex_.lock();
     for (auto it = executingCmds_.begin(); it != executingCmds_.end(); ++it) {
-        delete (*it);
+        delete it->second;
     }
     executingCmds_.clear();
     mutex_.unlock();
@@ -78,17 +76,15 @@ void ExecuteCmd::runCmd(unsigned long cmdId, std::string cmd, bool deleteOnFinis
 void ExecuteCmd::cmdFinished(unsigned long cmdId, bool bSuccess, std::string log, bool del)
 {
     mutex_.lock();
-    for (auto it = executingCmds_.begin(); it != executingCmds_.end(); ++it) {
-        if ((*it)->cmdId == cmdId) {
-            if (del) {
-                delete(*it);
-                executingCmds_.erase(it);
-            } else {
-                (*it)->bFinished = true;
-                (*it)->bSuccess = bSuccess;
-                (*it)->log = log;
-            }
-            break;
+    auto it = executingCmds_.find(cmdId);
+    if (it != executingCmds_.end()) {
+        if (del) {
+            delete it->second;
+            executingCmds_.erase(it);
+        } else {
+            it->second->bFinished = true;
+            it->second->bSuccess = bSuccess;
+            it->second->log = log;
         }
     }
     mutex_.unlock();
@@ -97,15 +93,7 @@ void ExecuteCmd::cmdFinished(unsigned long cmdId, bool bSuccess, std::string log
 bool ExecuteCmd::isCmdExist(unsigned long cmdId)
 {
     mutex_.lock();
-    bool bFound = false;
-    for (auto it = executingCmds_.begin(); it != executingCmds_.end(); ++it)
-    {
-        if ((*it)->cmdId == cmdId)
-        {
-            bFound = true;
-            break;
-        }
-    }
+    bool bFound = executingCmds_.find(cmdId) != executingCmds_.end();
     mutex_.unlock();
     return bFound;
 }
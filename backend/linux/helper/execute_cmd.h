@@ -2,7 +2,7 @@
 
 #include <stdio.h>
 #include <string>
-#include <list>
+#include <map>
 #include <mutex>
 
 class ExecuteCmd
@@ -35,6 +35,7 @@ private:
         bool bSuccess;
     };
 
-    std::list<CmdDescr *> executingCmds_;
+    // by cmdId, the status of the WireGuard daemon is looked up on every status request of the client app
+    std::map<unsigned long, CmdDescr *> executingCmds_;
     std::mutex mutex_;
 };
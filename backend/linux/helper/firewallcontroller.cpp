@@ -9,7 +9,8 @@
 #include "split_tunneling/cgroups.h"
 #include "utils.h"
 
-FirewallController::FirewallController() : connected_(false), splitTunnelEnabled_(false), splitTunnelExclude_(true)
+FirewallController::FirewallController() : connected_(false), splitTunnelEnabled_(false), splitTunnelExclude_(true),
+    allowIpSet_("windscribe_allow"), splitTunnelIpSet_("windscribe_split_tunnel"), isSplitTunnelIpSet_(false)
 {
     // If firewall on boot is enabled, restore boot rules
     if (Utils::isFileExists("/etc/windscribe/boot_rules.v4")) {
@@ -78,6 +79,11 @@ void FirewallController::getRules(bool ipv6, std::string *outRules)
     *outRules = buffer.str();
 }
 
+bool FirewallController::setAllowIps(const std::vector<std::string> &ips)
+{
+    return allowIpSet_.create() && allowIpSet_.update(ips);
+}
+
 bool FirewallController::enabled(const std::string &tag)
 {
     return Utils::executeCommand("iptables", {"--check", "INPUT", "-j", "windscribe_input", "-m", "comment", "--comment", tag.c_str()}) == 0;
@@ -87,6 +93,9 @@ void FirewallController::disable()
 {
     Utils::executeCommand("rm", {"-f", "/etc/windscribe/rules.v4"});
     Utils::executeCommand("rm", {"-f", "/etc/windscribe/rules.v6"});
+
+    // the client app has removed the rules referencing the set by now
+    allowIpSet_.destroy();
 }
 
 void FirewallController::setSplitTunnelingEnabled(bool isConnected, bool isEnabled, bool isExclude, const std::string &defaultAdapter, const std::string &defaultAdapterIp)
@@ -105,6 +114,13 @@ void FirewallController::setSplitTunnelingEnabled(bool isConnected, bool isEnabl
 
 void FirewallController::removeExclusiveIpRules()
 {
+    if (isSplitTunnelIpSet_) {
+        Utils::executeCommand("iptables", {"-D", "windscribe_input", "-m", "set", "--match-set", splitTunnelIpSet_.name(), "src", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+        Utils::executeCommand("iptables", {"-D", "windscribe_output", "-m", "set", "--match-set", splitTunnelIpSet_.name(), "dst", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+        splitTunnelIpSet_.update({});
+        return;
+    }
+
     for (auto ip : splitTunnelIps_) {
         Utils::executeCommand("iptables", {"-D", "windscribe_input", "-s", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
         Utils::executeCommand("iptables", {"-D", "windscribe_output", "-d", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
@@ -119,9 +135,9 @@ void FirewallController::removeInclusiveIpRules()
 
 void FirewallController::removeExclusiveAppRules()
 {
-    Utils::executeCommand("iptables", {"-D", "OUTPUT", "-t", "mangle", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
+    Utils::executeCommand("iptables", {"-D", "OUTPUT", "-t", "mangle", "-m", "cgroup", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
     if (!prevAdapter_.empty()) {
-        Utils::executeCommand("iptables", {"-D", "POSTROUTING", "-t", "nat", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-o", prevAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
+        Utils::executeCommand("iptables", {"-D", "POSTROUTING", "-t", "nat", "-m", "cgroup", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-o", prevAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
     }
 
     Utils::executeCommand("iptables", {"-D", "windscribe_input", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
@@ -130,9 +146,9 @@ void FirewallController::removeExclusiveAppRules()
 
 void FirewallController::removeInclusiveAppRules()
 {
-    Utils::executeCommand("iptables", {"-D", "OUTPUT", "-t", "mangle", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
+    Utils::executeCommand("iptables", {"-D", "OUTPUT", "-t", "mangle", "-m", "cgroup", "!", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag});
     if (!prevAdapter_.empty()) {
-        Utils::executeCommand("iptables", {"-D", "POSTROUTING", "-t", "nat", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-o", prevAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
+        Utils::executeCommand("iptables", {"-D", "POSTROUTING", "-t", "nat", "-m", "cgroup", "!", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-o", prevAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag});
     }
 }
 
@@ -163,19 +179,19 @@ void FirewallController::setSplitTunnelAppExceptions()
     if (splitTunnelExclude_) {
         removeInclusiveAppRules();
 
-        addRule({"POSTROUTING",  "-t", "nat", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-o", defaultAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag}, true);
-        addRule({"OUTPUT", "-t", "mangle", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag}, true);
+        addRule({"POSTROUTING",  "-t", "nat", "-m", "cgroup", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-o", defaultAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag}, true);
+        addRule({"OUTPUT", "-t", "mangle", "-m", "cgroup", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag}, true);
 
         // allow packets from excluded apps, if firewall is on
         if (enabled()) {
-            addRule({"windscribe_input", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
-            addRule({"windscribe_output", "-m", "cgroup", "--cgroup", CGroups::instance().netClassId(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+            addRule({"windscribe_input", "-m", "cgroup", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+            addRule({"windscribe_output", "-m", "cgroup", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
         }
     } else {
         removeExclusiveAppRules();
 
-        addRule({"POSTROUTING", "-t", "nat", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-o", defaultAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag}, true);
-        addRule({"OUTPUT", "-t", "mangle", "-m", "cgroup", "!", "--cgroup", CGroups::instance().netClassId(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag}, true);
+        addRule({"POSTROUTING", "-t", "nat", "-m", "cgroup", "!", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-o", defaultAdapter_.c_str(), "-j", "MASQUERADE", "-m", "comment", "--comment", kTag}, true);
+        addRule({"OUTPUT", "-t", "mangle", "-m", "cgroup", "!", CGroups::instance().matchOption(), CGroups::instance().matchValue(), "-j", "MARK", "--set-mark", CGroups::instance().mark(), "-m", "comment", "--comment", kTag}, true);
 
         // For inclusive, allow all packets
         if (enabled()) {
@@ -198,7 +214,22 @@ void FirewallController::setSplitTunnelIpExceptions(const std::vector<std::strin
     if (splitTunnelExclude_) {
         removeInclusiveIpRules();
 
-        // For exclusive, remove rules for addresses no longer in "ips"
+        // For exclusive, the addresses go to the ipset referenced by a pair of rules, if the kernel supports it
+        if (!isSplitTunnelIpSet_ && splitTunnelIpSet_.create()) {
+            // remove the rules per address added while the set was unavailable
+            removeExclusiveIpRules();
+            isSplitTunnelIpSet_ = true;
+        }
+
+        if (isSplitTunnelIpSet_) {
+            splitTunnelIpSet_.update(ips);
+            addRule({"windscribe_input", "-m", "set", "--match-set", splitTunnelIpSet_.name(), "src", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+            addRule({"windscribe_output", "-m", "set", "--match-set", splitTunnelIpSet_.name(), "dst", "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
+            splitTunnelIps_ = ips;
+            return;
+        }
+
+        // Otherwise remove rules for addresses no longer in "ips"
         for (auto ip : splitTunnelIps_) {
             if (std::find(ips.begin(), ips.end(), ip) == ips.end()) {
                 Utils::executeCommand("iptables", {"-D", "windscribe_input", "-s", ip.c_str(), "-j", "ACCEPT", "-m", "comment", "--comment", kTag});
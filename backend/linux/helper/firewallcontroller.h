@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 
+#include "ipset.h"
+
 class FirewallController
 {
 public:
@@ -18,6 +20,9 @@ public:
     void disable();
     bool enabled(const std::string &tag = kTag);
     void getRules(bool ipv6, std::string *outRules);
+    // Fills the set referenced by the rules of the client app instead of a pair of rules per address.
+    // Returns false if the kernel has no ipset support, the rules must list the addresses then.
+    bool setAllowIps(const std::vector<std::string> &ips);
 
     void setSplitTunnelingEnabled(
         bool isConnected,
@@ -39,6 +44,9 @@ private:
     std::string defaultAdapterIp_;
     std::string prevAdapter_;
     std::string netclassid_;
+    IpSet allowIpSet_;
+    IpSet splitTunnelIpSet_;
+    bool isSplitTunnelIpSet_;
 
     void removeExclusiveIpRules();
     void removeInclusiveIpRules();
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <grp.h>
 #include <sstream>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <spdlog/spdlog.h>
 
@@ -13,7 +14,7 @@ bool HelperSecurity::verifySignature()
 {
 #if defined(USE_SIGNATURE_CHECK)
     ExecutableSignature sigCheck;
-    bool result = sigCheck.verify("/opt/windscribe/Windscribe");
+    bool result = sigCheck.verify(kAppPath);
 
     if (!result) {
         spdlog::warn("Signature verification failed for Windscribe: {}", sigCheck.lastError());
@@ -23,3 +24,44 @@ bool HelperSecurity::verifySignature()
     return true;
 #endif
 }
+
+bool HelperSecurity::verifyPeer(pid_t pid)
+{
+#if defined(USE_SIGNATURE_CHECK)
+    // The signature is checked on the installed app, so the peer must be running that very file.
+    struct stat peerSt;
+    const std::string exeLink = "/proc/" + std::to_string(pid) + "/exe";
+    if (stat(exeLink.c_str(), &peerSt) != 0) {
+        spdlog::warn("Could not get the executable of the process {} ({})", pid, errno);
+        return false;
+    }
+    struct stat appSt;
+    if (stat(kAppPath, &appSt) != 0) {
+        spdlog::warn("Could not stat {} ({})", kAppPath, errno);
+        return false;
+    }
+    if (peerSt.st_dev != appSt.st_dev || peerSt.st_ino != appSt.st_ino) {
+        spdlog::warn("The process {} is not running {}", pid, kAppPath);
+        return false;
+    }
+
+    // the change time is updated by any modification of the file, in place or not
+    if (isVerified_ && appSt.st_dev == verifiedDev_ && appSt.st_ino == verifiedIno_ &&
+        appSt.st_ctim.tv_sec == verifiedCtime_.tv_sec && appSt.st_ctim.tv_nsec == verifiedCtime_.tv_nsec) {
+        return true;
+    }
+
+    if (!verifySignature()) {
+        return false;
+    }
+
+    isVerified_ = true;
+    verifiedDev_ = appSt.st_dev;
+    verifiedIno_ = appSt.st_ino;
+    verifiedCtime_ = appSt.st_ctim;
+    return true;
+#else
+    (void)pid;
+    return true;
+#endif
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <map>
+#include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 class HelperSecurity
@@ -14,4 +15,16 @@ public:
 
     // Check if process has the correct signature.
     bool verifySignature();
+
+    // Check the process connected to the helper: it must run the installed app, and the app must have the correct signature.
+    // The signature result is cached for the app file, so it is not verified again when the app reconnects.
+    bool verifyPeer(pid_t pid);
+
+private:
+    static constexpr const char *kAppPath = "/opt/windscribe/Windscribe";
+
+    bool isVerified_ = false;
+    dev_t verifiedDev_ = 0;
+    ino_t verifiedIno_ = 0;
+    struct timespec verifiedCtime_ = {};
 };
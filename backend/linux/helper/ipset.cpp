@@ -0,0 +1,232 @@
+#include "ipset.h"
+
+#include <arpa/inet.h>
+#include <functional>
+#include <linux/netfilter.h>
+#include <linux/netfilter/ipset/ip_set.h>
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netlink.h>
+#include <spdlog/spdlog.h>
+#include <stdlib.h>
+
+namespace {
+// the kernels still accept the first revision of hash:net, the newer ones add options we do not use
+const std::uint8_t kHashNetRevision = 0;
+
+const char *nlaData(const nlattr *attr)
+{
+    return reinterpret_cast<const char *>(attr) + NLA_HDRLEN;
+}
+
+int nlaPayload(const nlattr *attr)
+{
+    return attr->nla_len - NLA_HDRLEN;
+}
+
+void forEachAttr(const char *data, int len, const std::function<void(const nlattr *)> &callback)
+{
+    while (len >= NLA_HDRLEN) {
+        const auto *attr = reinterpret_cast<const nlattr *>(data);
+        if (attr->nla_len < NLA_HDRLEN || attr->nla_len > len) {
+            return;
+        }
+        callback(attr);
+        const int alignedLen = NLA_ALIGN(attr->nla_len);
+        data += alignedLen;
+        len -= alignedLen;
+    }
+}
+}
+
+IpSet::IpSet(const std::string &name) : name_(name), socket_(NETLINK_NETFILTER), isCreated_(false)
+{
+}
+
+IpSet::~IpSet()
+{
+}
+
+bool IpSet::create()
+{
+    if (isCreated_) {
+        return true;
+    }
+
+    NetlinkMessage message = makeMessage(IPSET_CMD_CREATE);
+    message.addAttr(IPSET_ATTR_TYPENAME, std::string("hash:net"));
+    message.addAttr(IPSET_ATTR_REVISION, kHashNetRevision);
+    message.addAttr(IPSET_ATTR_FAMILY, std::uint8_t(NFPROTO_IPV4));
+    if (!sendMessages({message})) {
+        spdlog::warn("Could not create ipset {}", name_);
+        return false;
+    }
+
+    // The set may remain from a previous run of the helper, with the firewall rules still referencing it.
+    // Its entries are kept, so the rules go on matching the same addresses until the next update.
+    if (!readEntries(entries_)) {
+        if (!sendMessages({makeMessage(IPSET_CMD_FLUSH)})) {
+            return false;
+        }
+        entries_.clear();
+    }
+
+    spdlog::debug("Created ipset {} ({} entries)", name_, entries_.size());
+    isCreated_ = true;
+    return true;
+}
+
+bool IpSet::destroy()
+{
+    if (!isCreated_) {
+        return true;
+    }
+
+    if (!sendMessages({makeMessage(IPSET_CMD_DESTROY)})) {
+        spdlog::warn("Could not destroy ipset {}", name_);
+        return false;
+    }
+
+    spdlog::debug("Destroyed ipset {}", name_);
+    entries_.clear();
+    isCreated_ = false;
+    return true;
+}
+
+bool IpSet::update(const std::vector<std::string> &entries)
+{
+    if (!isCreated_) {
+        return false;
+    }
+
+    std::set<std::string> newEntries(entries.begin(), entries.end());
+    std::vector<NetlinkMessage> messages;
+
+    for (const auto &entry : entries_) {
+        if (newEntries.find(entry) == newEntries.end()) {
+            makeEntryMessage(IPSET_CMD_DEL, entry, messages);
+        }
+    }
+    for (const auto &entry : newEntries) {
+        if (entries_.find(entry) == entries_.end()) {
+            makeEntryMessage(IPSET_CMD_ADD, entry, messages);
+        }
+    }
+
+    if (messages.empty()) {
+        return true;
+    }
+
+    spdlog::debug("Updating ipset {}: {} entries, {} changes", name_, newEntries.size(), messages.size());
+    if (!sendMessages(messages)) {
+        // the actual content is unknown now, so the next update rebuilds the set
+        sendMessages({makeMessage(IPSET_CMD_FLUSH)});
+        entries_.clear();
+        return false;
+    }
+
+    entries_ = std::move(newEntries);
+    return true;
+}
+
+bool IpSet::readEntries(std::set<std::string> &outEntries)
+{
+    outEntries.clear();
+
+    struct nfgenmsg nfg;
+    nfg.nfgen_family = NFPROTO_IPV4;
+    nfg.version = NFNETLINK_V0;
+    nfg.res_id = 0;
+    NetlinkMessage request((NFNL_SUBSYS_IPSET << 8) | IPSET_CMD_LIST, NLM_F_REQUEST | NLM_F_DUMP, &nfg, sizeof(nfg));
+    request.addAttr(IPSET_ATTR_PROTOCOL, std::uint8_t(IPSET_PROTOCOL));
+    request.addAttr(IPSET_ATTR_SETNAME, name_);
+
+    // IPSET_ATTR_ADT holds an IPSET_ATTR_DATA per entry, with the address in IPSET_ATTR_IP and the prefix length in IPSET_ATTR_CIDR
+    return socket_.dump(request, [&](const nlmsghdr *nlh) {
+        const int headerLen = NLMSG_ALIGN(sizeof(struct nfgenmsg));
+        forEachAttr(reinterpret_cast<const char *>(NLMSG_DATA(nlh)) + headerLen, nlh->nlmsg_len - NLMSG_HDRLEN - headerLen,
+                    [&](const nlattr *attr) {
+            if ((attr->nla_type & NLA_TYPE_MASK) != IPSET_ATTR_ADT) {
+                return;
+            }
+            forEachAttr(nlaData(attr), nlaPayload(attr), [&](const nlattr *data) {
+                const struct in_addr *addr = nullptr;
+                int cidr = 32;
+                forEachAttr(nlaData(data), nlaPayload(data), [&](const nlattr *field) {
+                    const int type = field->nla_type & NLA_TYPE_MASK;
+                    if (type == IPSET_ATTR_IP) {
+                        forEachAttr(nlaData(field), nlaPayload(field), [&](const nlattr *ip) {
+                            if ((ip->nla_type & NLA_TYPE_MASK) == IPSET_ATTR_IPADDR_IPV4 && nlaPayload(ip) >= (int)sizeof(struct in_addr)) {
+                                addr = reinterpret_cast<const struct in_addr *>(nlaData(ip));
+                            }
+                        });
+                    } else if (type == IPSET_ATTR_CIDR && nlaPayload(field) >= 1) {
+                        cidr = *reinterpret_cast<const std::uint8_t *>(nlaData(field));
+                    }
+                });
+                if (addr) {
+                    char str[INET_ADDRSTRLEN];
+                    inet_ntop(AF_INET, addr, str, sizeof(str));
+                    outEntries.insert(cidr == 32 ? std::string(str) : std::string(str) + "/" + std::to_string(cidr));
+                }
+            });
+        });
+    });
+}
+
+NetlinkMessage IpSet::makeMessage(int cmd) const
+{
+    struct nfgenmsg nfg;
+    nfg.nfgen_family = NFPROTO_IPV4;
+    nfg.version = NFNETLINK_V0;
+    nfg.res_id = 0;
+
+    // without NLM_F_EXCL the kernel ignores adding an existing entry, deleting a missing one or creating an existing set
+    NetlinkMessage message((NFNL_SUBSYS_IPSET << 8) | cmd, NLM_F_REQUEST | NLM_F_ACK, &nfg, sizeof(nfg));
+    message.addAttr(IPSET_ATTR_PROTOCOL, std::uint8_t(IPSET_PROTOCOL));
+    message.addAttr(IPSET_ATTR_SETNAME, name_);
+    return message;
+}
+
+bool IpSet::makeEntryMessage(int cmd, const std::string &entry, std::vector<NetlinkMessage> &outMessages) const
+{
+    std::string address = entry;
+    int cidr = 32;
+    size_t slash = entry.find('/');
+    if (slash != std::string::npos) {
+        address = entry.substr(0, slash);
+        cidr = atoi(entry.c_str() + slash + 1);
+    }
+
+    struct in_addr addr;
+    if (inet_pton(AF_INET, address.c_str(), &addr) != 1 || cidr < 1 || cidr > 32) {
+        spdlog::warn("Invalid ipset entry: {}", entry);
+        return false;
+    }
+
+    NetlinkMessage message = makeMessage(cmd);
+    size_t data = message.beginNested(IPSET_ATTR_DATA);
+    size_t ip = message.beginNested(IPSET_ATTR_IP);
+    message.addAttr(IPSET_ATTR_IPADDR_IPV4 | NLA_F_NET_BYTEORDER, &addr.s_addr, sizeof(addr.s_addr));
+    message.endNested(ip);
+    message.addAttr(IPSET_ATTR_CIDR, std::uint8_t(cidr));
+    message.endNested(data);
+    outMessages.push_back(std::move(message));
+    return true;
+}
+
+bool IpSet::sendMessages(const std::vector<NetlinkMessage> &messages)
+{
+    std::vector<int> errors;
+    if (!socket_.sendBatch(messages, errors)) {
+        return false;
+    }
+
+    bool result = true;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        if (errors[i] != 0) {
+            spdlog::warn("ipset {} command {} failed ({})", name_, messages[i].type() & 0xff, errors[i]);
+            result = false;
+        }
+    }
+    return result;
+}
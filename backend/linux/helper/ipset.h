@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "netlink_socket.h"
+
+// IPv4 hash:net set of the kernel ipset, managed over the netfilter netlink socket without running the ipset tool.
+// A single iptables rule with "-m set --match-set <name> src|dst" matches all the entries in constant time.
+// The entries are plain addresses or CIDR networks ("1.2.3.4", "10.0.0.0/8").
+// Not thread safe
+class IpSet final
+{
+public:
+    explicit IpSet(const std::string &name);
+    ~IpSet();
+
+    const std::string &name() const { return name_; }
+
+    // Creates the set, an existing set with the same name is reused with its entries. Returns false if the kernel has no ipset support.
+    bool create();
+    // Fails while iptables rules still reference the set
+    bool destroy();
+
+    // Makes the set contain exactly the given entries. Only the difference with the current entries is sent,
+    // with many add/del messages per netlink write.
+    bool update(const std::vector<std::string> &entries);
+
+private:
+    std::string name_;
+    NetlinkSocket socket_;
+    bool isCreated_;
+    std::set<std::string> entries_;
+
+    bool readEntries(std::set<std::string> &outEntries);
+    bool sendMessages(const std::vector<NetlinkMessage> &messages);
+    NetlinkMessage makeMessage(int cmd) const;
+    bool makeEntryMessage(int cmd, const std::string &entry, std::vector<NetlinkMessage> &outMessages) const;
+};
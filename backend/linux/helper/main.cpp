@@ -4,6 +4,7 @@
 #include <spdlog/sinks/rotating_file_sink.h>
 #include "server.h"
 #include "utils.h"
+#include "utils/log/async_sink.h"
 #include "utils/log/spdlog_utils.h"
 
 Server server;
@@ -12,6 +13,7 @@ void handler_sigterm(int signum)
 {
     UNUSED(signum);
     spdlog::info("Windscribe helper terminated");
+    spdlog::default_logger()->flush();
     exit(0);
 }
 
@@ -36,9 +38,10 @@ int main(int argc, const char *argv[])
         }
 	// Create rotation logger with 2 file with unlimited size
         // rotate it on open, the first file is the current log, the 2nd is the previous log
-        auto logger = spdlog::rotating_logger_mt("service", logPath, SIZE_MAX, 1, true);
-        // this will trigger flush on every log message
-        logger->flush_on(spdlog::level::trace);
+        // the file is written in batches by the writer thread of the async sink, errors are written out immediately
+        auto fileSink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(logPath, SIZE_MAX, 1, true);
+        auto logger = std::make_shared<spdlog::logger>("service", std::make_shared<log_utils::AsyncSink>(fileSink));
+        spdlog::initialize_logger(logger);
         spdlog::set_level(spdlog::level::trace);
         spdlog::set_default_logger(logger);
     }
@@ -65,5 +68,6 @@ int main(int argc, const char *argv[])
     server.run();
 
     spdlog::info("Windscribe helper finished");
+    spdlog::shutdown();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,178 @@
+#include "netlink_routes.h"
+
+#include <arpa/inet.h>
+#include <climits>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <spdlog/spdlog.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "netlink_socket.h"
+
+namespace
+{
+std::string routeToString(const NetlinkRoutes::Route &route)
+{
+    std::string str = route.destination;
+    if (!route.gateway.empty()) {
+        str += " via " + route.gateway;
+    }
+    if (!route.interface.empty()) {
+        str += " dev " + route.interface;
+    }
+    return str;
+}
+
+bool makeRouteMessage(bool isAdd, const NetlinkRoutes::Route &route, std::vector<NetlinkMessage> &outMessages)
+{
+    std::string address = route.destination;
+    int prefixLength = 32;
+    size_t slash = address.find('/');
+    if (slash != std::string::npos) {
+        prefixLength = atoi(address.c_str() + slash + 1);
+        address.resize(slash);
+    }
+
+    struct in_addr dst;
+    if (inet_pton(AF_INET, address.c_str(), &dst) != 1 || prefixLength < 0 || prefixLength > 32) {
+        spdlog::warn("Invalid route destination: {}", route.destination);
+        return false;
+    }
+
+    struct in_addr gateway;
+    if (!route.gateway.empty() && inet_pton(AF_INET, route.gateway.c_str(), &gateway) != 1) {
+        spdlog::warn("Invalid route gateway: {}", route.gateway);
+        return false;
+    }
+
+    std::uint32_t ifIndex = 0;
+    if (!route.interface.empty()) {
+        ifIndex = if_nametoindex(route.interface.c_str());
+        if (ifIndex == 0) {
+            spdlog::warn("Interface of the route not found: {}", routeToString(route));
+            return false;
+        }
+    }
+
+    // the same fields as the ip command fills, a delete request leaves the ones to match as wildcards
+    struct rtmsg rtm;
+    memset(&rtm, 0, sizeof(rtm));
+    rtm.rtm_family = AF_INET;
+    rtm.rtm_dst_len = prefixLength;
+    rtm.rtm_table = RT_TABLE_MAIN;
+    if (isAdd) {
+        rtm.rtm_protocol = RTPROT_BOOT;
+        rtm.rtm_scope = route.gateway.empty() ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE;
+        rtm.rtm_type = RTN_UNICAST;
+    } else {
+        rtm.rtm_scope = RT_SCOPE_NOWHERE;
+    }
+
+    std::uint16_t flags = NLM_F_REQUEST | NLM_F_ACK;
+    if (isAdd) {
+        flags |= NLM_F_CREATE | NLM_F_EXCL;
+    }
+    NetlinkMessage message(isAdd ? RTM_NEWROUTE : RTM_DELROUTE, flags, &rtm, sizeof(rtm));
+    message.addAttr(RTA_DST, &dst, sizeof(dst));
+    if (!route.gateway.empty()) {
+        message.addAttr(RTA_GATEWAY, &gateway, sizeof(gateway));
+    }
+    if (ifIndex != 0) {
+        message.addAttr(RTA_OIF, ifIndex);
+    }
+    outMessages.push_back(std::move(message));
+    return true;
+}
+}  // namespace
+
+namespace NetlinkRoutes
+{
+
+bool apply(const std::vector<Route> &toDelete, const std::vector<Route> &toAdd, int *outFailures)
+{
+    std::vector<NetlinkMessage> messages;
+    std::vector<const Route *> routes;
+    int failures = 0;
+
+    for (const auto &route : toDelete) {
+        if (makeRouteMessage(false, route, messages)) {
+            routes.push_back(&route);
+        } else {
+            failures++;
+        }
+    }
+    const size_t deleteCount = routes.size();
+    for (const auto &route : toAdd) {
+        if (makeRouteMessage(true, route, messages)) {
+            routes.push_back(&route);
+        } else {
+            failures++;
+        }
+    }
+
+    if (!messages.empty()) {
+        NetlinkSocket socket(NETLINK_ROUTE);
+        std::vector<int> errors;
+        if (!socket.sendBatch(messages, errors)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < messages.size(); ++i) {
+            if (errors[i] != 0) {
+                spdlog::warn("Failed to {} route {}: {}", i < deleteCount ? "delete" : "add", routeToString(*routes[i]), strerror(errors[i]));
+                failures++;
+            }
+        }
+    }
+
+    if (outFailures) {
+        *outFailures = failures;
+    }
+    return true;
+}
+
+bool getDefaultGateway(std::string &outGateway)
+{
+    outGateway.clear();
+
+    struct rtmsg rtm;
+    memset(&rtm, 0, sizeof(rtm));
+    rtm.rtm_family = AF_INET;
+    NetlinkMessage request(RTM_GETROUTE, NLM_F_REQUEST | NLM_F_DUMP, &rtm, sizeof(rtm));
+
+    std::uint32_t lowestMetric = UINT_MAX;
+    NetlinkSocket socket(NETLINK_ROUTE);
+    return socket.dump(request, [&](const nlmsghdr *nlh) {
+        if (nlh->nlmsg_type != RTM_NEWROUTE) {
+            return;
+        }
+        const auto *route = reinterpret_cast<const struct rtmsg *>(NLMSG_DATA(nlh));
+        if (route->rtm_dst_len != 0 || route->rtm_type != RTN_UNICAST) {
+            return;
+        }
+
+        std::uint32_t table = route->rtm_table;
+        std::uint32_t metric = 0;
+        const struct in_addr *gateway = nullptr;
+        int len = RTM_PAYLOAD(nlh);
+        for (auto *attr = RTM_RTA(route); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+            if (attr->rta_type == RTA_TABLE) {
+                table = *reinterpret_cast<const std::uint32_t *>(RTA_DATA(attr));
+            } else if (attr->rta_type == RTA_PRIORITY) {
+                metric = *reinterpret_cast<const std::uint32_t *>(RTA_DATA(attr));
+            } else if (attr->rta_type == RTA_GATEWAY) {
+                gateway = reinterpret_cast<const struct in_addr *>(RTA_DATA(attr));
+            }
+        }
+
+        if (table == RT_TABLE_MAIN && gateway && metric < lowestMetric) {
+            char str[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, gateway, str, sizeof(str));
+            outGateway = str;
+            lowestMetric = metric;
+        }
+    });
+}
+
+}  // namespace NetlinkRoutes
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// IPv4 routes of the main table programmed over rtnetlink, instead of running "ip route" for every route.
+// The functions return false if rtnetlink is unavailable, the callers fall back to the ip command then.
+namespace NetlinkRoutes
+{
+    struct Route
+    {
+        std::string destination;    // an address or a network, "1.2.3.4" or "1.2.3.0/24"
+        std::string gateway;        // optional
+        std::string interface;      // optional
+    };
+
+    // Deletes and then adds the routes with one batch of requests.
+    // The routes the kernel rejects (an existing route, a missing one) are logged and counted in outFailures,
+    // like the failures of the ip command they replace.
+    bool apply(const std::vector<Route> &toDelete, const std::vector<Route> &toAdd, int *outFailures = nullptr);
+
+    // Gateway of the default route with the lowest metric, empty if there is no default route
+    bool getDefaultGateway(std::string &outGateway);
+}
@@ -0,0 +1,184 @@
+#include "netlink_socket.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <linux/netlink.h>
+#include <spdlog/spdlog.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+NetlinkMessage::NetlinkMessage(std::uint16_t type, std::uint16_t flags, const void *familyHeader, size_t familyHeaderLen)
+{
+    data_.resize(NLMSG_HDRLEN + NLMSG_ALIGN(familyHeaderLen));
+    auto *nlh = reinterpret_cast<struct nlmsghdr *>(data_.data());
+    nlh->nlmsg_type = type;
+    nlh->nlmsg_flags = flags;
+    memcpy(&data_[NLMSG_HDRLEN], familyHeader, familyHeaderLen);
+}
+
+void NetlinkMessage::addAttr(std::uint16_t type, const void *value, size_t len)
+{
+    struct nlattr attr;
+    attr.nla_type = type;
+    attr.nla_len = NLA_HDRLEN + len;
+    size_t offset = data_.size();
+    data_.resize(offset + NLA_ALIGN(attr.nla_len));
+    memcpy(&data_[offset], &attr, sizeof(attr));
+    if (len > 0) {
+        memcpy(&data_[offset + NLA_HDRLEN], value, len);
+    }
+}
+
+size_t NetlinkMessage::beginNested(std::uint16_t type)
+{
+    size_t offset = data_.size();
+    addAttr(type | NLA_F_NESTED, nullptr, 0);
+    return offset;
+}
+
+void NetlinkMessage::endNested(size_t offset)
+{
+    reinterpret_cast<struct nlattr *>(&data_[offset])->nla_len = data_.size() - offset;
+}
+
+std::uint16_t NetlinkMessage::type() const
+{
+    return reinterpret_cast<const struct nlmsghdr *>(data_.data())->nlmsg_type;
+}
+
+NetlinkSocket::NetlinkSocket(int protocol) : protocol_(protocol), socket_(-1), seq_(0)
+{
+}
+
+NetlinkSocket::~NetlinkSocket()
+{
+    if (socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+bool NetlinkSocket::open()
+{
+    if (socket_ >= 0) {
+        return true;
+    }
+
+    socket_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, protocol_);
+    if (socket_ < 0) {
+        spdlog::error("Failed to open netlink socket {} ({})", protocol_, errno);
+        return false;
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind(socket_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+        spdlog::error("Failed to bind netlink socket {} ({})", protocol_, errno);
+        close(socket_);
+        socket_ = -1;
+        return false;
+    }
+    return true;
+}
+
+std::uint32_t NetlinkSocket::appendMessage(const NetlinkMessage &message, std::vector<char> &buf)
+{
+    size_t offset = buf.size();
+    buf.insert(buf.end(), message.data().begin(), message.data().end());
+    auto *nlh = reinterpret_cast<struct nlmsghdr *>(&buf[offset]);
+    nlh->nlmsg_len = message.data().size();
+    nlh->nlmsg_seq = ++seq_;
+    return seq_;
+}
+
+bool NetlinkSocket::sendBatch(const std::vector<NetlinkMessage> &messages, std::vector<int> &outErrors)
+{
+    outErrors.assign(messages.size(), 0);
+    if (!open()) {
+        return false;
+    }
+
+    std::vector<char> buf;
+    std::vector<char> reply(8192);
+
+    for (size_t first = 0; first < messages.size(); first += kMaxMessagesPerWrite) {
+        const size_t count = std::min(kMaxMessagesPerWrite, messages.size() - first);
+        const std::uint32_t firstSeq = seq_ + 1;
+
+        buf.clear();
+        for (size_t i = first; i < first + count; ++i) {
+            appendMessage(messages[i], buf);
+        }
+
+        if (send(socket_, buf.data(), buf.size(), 0) < 0) {
+            spdlog::error("Failed to send netlink messages ({})", errno);
+            return false;
+        }
+
+        // every request is acknowledged, with an error code of 0 on success
+        size_t acks = 0;
+        while (acks < count) {
+            ssize_t len = recv(socket_, reply.data(), reply.size(), 0);
+            if (len < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                spdlog::error("Failed to receive netlink replies ({})", errno);
+                return false;
+            }
+
+            for (auto *nlh = reinterpret_cast<struct nlmsghdr *>(reply.data()); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+                if (nlh->nlmsg_type != NLMSG_ERROR || nlh->nlmsg_seq < firstSeq || nlh->nlmsg_seq > seq_) {
+                    continue;
+                }
+                acks++;
+                const auto *err = reinterpret_cast<const struct nlmsgerr *>(NLMSG_DATA(nlh));
+                outErrors[first + nlh->nlmsg_seq - firstSeq] = -err->error;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool NetlinkSocket::dump(const NetlinkMessage &request, const std::function<void(const nlmsghdr *)> &callback)
+{
+    if (!open()) {
+        return false;
+    }
+
+    std::vector<char> buf;
+    const std::uint32_t seq = appendMessage(request, buf);
+    if (send(socket_, buf.data(), buf.size(), 0) < 0) {
+        spdlog::error("Failed to send netlink dump request ({})", errno);
+        return false;
+    }
+
+    std::vector<char> reply(32768);
+    while (true) {
+        ssize_t len = recv(socket_, reply.data(), reply.size(), 0);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("Failed to receive netlink dump ({})", errno);
+            return false;
+        }
+
+        for (auto *nlh = reinterpret_cast<struct nlmsghdr *>(reply.data()); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_seq != seq) {
+                continue;
+            }
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                return true;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                const auto *err = reinterpret_cast<const struct nlmsgerr *>(NLMSG_DATA(nlh));
+                spdlog::error("Netlink dump failed ({})", -err->error);
+                return false;
+            }
+            callback(nlh);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct nlmsghdr;
+
+// A netlink request: the nlmsghdr, the fixed header of the family (rtmsg, nfgenmsg, ...) and the attributes.
+// The length and the sequence number are filled in when the message is sent.
+class NetlinkMessage
+{
+public:
+    NetlinkMessage(std::uint16_t type, std::uint16_t flags, const void *familyHeader, size_t familyHeaderLen);
+
+    void addAttr(std::uint16_t type, const void *value, size_t len);
+    void addAttr(std::uint16_t type, std::uint8_t value) { addAttr(type, &value, sizeof(value)); }
+    void addAttr(std::uint16_t type, std::uint32_t value) { addAttr(type, &value, sizeof(value)); }
+    void addAttr(std::uint16_t type, const std::string &value) { addAttr(type, value.c_str(), value.size() + 1); }
+
+    // returns the offset to pass to endNested() after the nested attributes are added
+    size_t beginNested(std::uint16_t type);
+    void endNested(size_t offset);
+
+    std::uint16_t type() const;
+    const std::vector<char> &data() const { return data_; }
+
+private:
+    std::vector<char> data_;
+};
+
+// Blocking netlink socket of the given protocol (NETLINK_ROUTE, NETLINK_NETFILTER, ...)
+class NetlinkSocket
+{
+public:
+    explicit NetlinkSocket(int protocol);
+    ~NetlinkSocket();
+
+    bool open();
+
+    // Sends the requests, many per write, and waits for the acknowledgement of each one.
+    // outErrors gets the errno the kernel returned for every request (0 on success).
+    // Returns false if the socket failed, the result of the requests is unknown then.
+    bool sendBatch(const std::vector<NetlinkMessage> &messages, std::vector<int> &outErrors);
+
+    // Sends a NLM_F_DUMP request and passes every message of the reply to the callback
+    bool dump(const NetlinkMessage &request, const std::function<void(const nlmsghdr *)> &callback);
+
+private:
+    // keeps a write well below the default socket buffer size
+    static constexpr size_t kMaxMessagesPerWrite = 256;
+
+    int protocol_;
+    int socket_;
+    std::uint32_t seq_;
+
+    std::uint32_t appendMessage(const NetlinkMessage &message, std::vector<char> &buf);
+};
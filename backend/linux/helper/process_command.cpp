@@ -1,5 +1,7 @@
 #include "process_command.h"
 
+#include <boost/archive/polymorphic_binary_iarchive.hpp>
+#include <boost/archive/polymorphic_text_iarchive.hpp>
 #include <codecvt>
 #include <fcntl.h>
 #include <fstream>
@@ -16,7 +18,7 @@
 #include "utils/executable_signature/executable_signature.h"
 #include "wireguard/wireguardcontroller.h"
 
-CMD_ANSWER processCommand(int cmdId, const std::string packet)
+CMD_ANSWER processCommand(int cmdId, const std::string &packet, bool isBinaryEncoding)
 {
     const auto command = kCommands.find(cmdId);
     if (command == kCommands.end()) {
@@ -25,12 +27,15 @@ CMD_ANSWER processCommand(int cmdId, const std::string packet)
     }
 
     std::istringstream stream(packet);
-    boost::archive::text_iarchive ia(stream, boost::archive::no_header);
-
+    if (isBinaryEncoding) {
+        boost::archive::polymorphic_binary_iarchive ia(stream, boost::archive::no_header);
+        return (command->second)(ia);
+    }
+    boost::archive::polymorphic_text_iarchive ia(stream, boost::archive::no_header);
     return (command->second)(ia);
 }
 
-CMD_ANSWER startOpenvpn(boost::archive::text_iarchive &ia)
+CMD_ANSWER startOpenvpn(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_START_OPENVPN cmd;
@@ -76,7 +81,7 @@ CMD_ANSWER startOpenvpn(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER getCmdStatus(boost::archive::text_iarchive &ia)
+CMD_ANSWER getCmdStatus(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_GET_CMD_STATUS cmd;
@@ -95,7 +100,7 @@ CMD_ANSWER getCmdStatus(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER clearCmds(boost::archive::text_iarchive &ia)
+CMD_ANSWER clearCmds(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_CLEAR_CMDS cmd;
@@ -107,7 +112,7 @@ CMD_ANSWER clearCmds(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER splitTunnelingSettings(boost::archive::text_iarchive &ia)
+CMD_ANSWER splitTunnelingSettings(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_SPLIT_TUNNELING_SETTINGS cmd;
@@ -119,7 +124,7 @@ CMD_ANSWER splitTunnelingSettings(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER sendConnectStatus(boost::archive::text_iarchive &ia)
+CMD_ANSWER sendConnectStatus(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_SEND_CONNECT_STATUS cmd;
@@ -134,7 +139,7 @@ CMD_ANSWER sendConnectStatus(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER startWireGuard(boost::archive::text_iarchive &ia)
+CMD_ANSWER startWireGuard(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
 
@@ -144,7 +149,7 @@ CMD_ANSWER startWireGuard(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER stopWireGuard(boost::archive::text_iarchive &ia)
+CMD_ANSWER stopWireGuard(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     if (WireGuardController::instance().stop()) {
@@ -153,7 +158,7 @@ CMD_ANSWER stopWireGuard(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER configureWireGuard(boost::archive::text_iarchive &ia)
+CMD_ANSWER configureWireGuard(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_CONFIGURE_WIREGUARD cmd;
@@ -202,7 +207,7 @@ CMD_ANSWER configureWireGuard(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER getWireGuardStatus(boost::archive::text_iarchive &ia)
+CMD_ANSWER getWireGuardStatus(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     unsigned int errorCode = 0;
@@ -223,7 +228,7 @@ CMD_ANSWER getWireGuardStatus(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER changeMtu(boost::archive::text_iarchive &ia)
+CMD_ANSWER changeMtu(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_CHANGE_MTU cmd;
@@ -235,7 +240,7 @@ CMD_ANSWER changeMtu(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER setDnsLeakProtectEnabled(boost::archive::text_iarchive &ia)
+CMD_ANSWER setDnsLeakProtectEnabled(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_SET_DNS_LEAK_PROTECT_ENABLED cmd;
@@ -250,7 +255,7 @@ CMD_ANSWER setDnsLeakProtectEnabled(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER clearFirewallRules(boost::archive::text_iarchive &ia)
+CMD_ANSWER clearFirewallRules(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_CLEAR_FIREWALL_RULES cmd;
@@ -261,7 +266,7 @@ CMD_ANSWER clearFirewallRules(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER checkFirewallState(boost::archive::text_iarchive &ia)
+CMD_ANSWER checkFirewallState(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_CHECK_FIREWALL_STATE cmd;
@@ -272,7 +277,7 @@ CMD_ANSWER checkFirewallState(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER setFirewallRules(boost::archive::text_iarchive &ia)
+CMD_ANSWER setFirewallRules(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_SET_FIREWALL_RULES cmd;
@@ -285,7 +290,7 @@ CMD_ANSWER setFirewallRules(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER getFirewallRules(boost::archive::text_iarchive &ia)
+CMD_ANSWER getFirewallRules(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_GET_FIREWALL_RULES cmd;
@@ -296,7 +301,7 @@ CMD_ANSWER getFirewallRules(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER setFirewallOnBoot(boost::archive::text_iarchive &ia)
+CMD_ANSWER setFirewallOnBoot(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_SET_FIREWALL_ON_BOOT cmd;
@@ -309,7 +314,18 @@ CMD_ANSWER setFirewallOnBoot(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER setMacAddress(boost::archive::text_iarchive &ia)
+CMD_ANSWER setFirewallAllowIps(boost::archive::polymorphic_iarchive &ia)
+{
+    CMD_ANSWER answer;
+    CMD_SET_FIREWALL_ALLOW_IPS cmd;
+    ia >> cmd;
+    spdlog::debug("Set firewall allow ips: {}", cmd.ips.size());
+
+    answer.executed = FirewallController::instance().setAllowIps(cmd.ips) ? 1 : 0;
+    return answer;
+}
+
+CMD_ANSWER setMacAddress(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_SET_MAC_ADDRESS cmd;
@@ -353,7 +369,7 @@ CMD_ANSWER setMacAddress(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER taskKill(boost::archive::text_iarchive &ia)
+CMD_ANSWER taskKill(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_TASK_KILL cmd;
@@ -395,7 +411,7 @@ CMD_ANSWER taskKill(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER startCtrld(boost::archive::text_iarchive &ia)
+CMD_ANSWER startCtrld(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_START_CTRLD cmd;
@@ -457,7 +473,7 @@ CMD_ANSWER startCtrld(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER startStunnel(boost::archive::text_iarchive &ia)
+CMD_ANSWER startStunnel(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_START_STUNNEL cmd;
@@ -497,7 +513,7 @@ CMD_ANSWER startStunnel(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER startWstunnel(boost::archive::text_iarchive &ia)
+CMD_ANSWER startWstunnel(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_START_WSTUNNEL cmd;
@@ -533,7 +549,7 @@ CMD_ANSWER startWstunnel(boost::archive::text_iarchive &ia)
     return answer;
 }
 
-CMD_ANSWER resetMacAddresses(boost::archive::text_iarchive &ia)
+CMD_ANSWER resetMacAddresses(boost::archive::polymorphic_iarchive &ia)
 {
     CMD_ANSWER answer;
     CMD_RESET_MAC_ADDRESSES cmd;
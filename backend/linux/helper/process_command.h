@@ -1,7 +1,6 @@
 #pragma once
 
-#include <boost/archive/text_oarchive.hpp>
-#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/polymorphic_iarchive.hpp>
 #include <boost/serialization/vector.hpp>
 #include <map>
 #include <string>
@@ -9,30 +8,31 @@
 #include "helper_commands.h"
 #include "helper_commands_serialize.h"
 
-CMD_ANSWER startOpenvpn(boost::archive::text_iarchive &ia);
-CMD_ANSWER getCmdStatus(boost::archive::text_iarchive &ia);
-CMD_ANSWER clearCmds(boost::archive::text_iarchive &ia);
-CMD_ANSWER splitTunnelingSettings(boost::archive::text_iarchive &ia);
-CMD_ANSWER sendConnectStatus(boost::archive::text_iarchive &ia);
-CMD_ANSWER startWireGuard(boost::archive::text_iarchive &ia);
-CMD_ANSWER stopWireGuard(boost::archive::text_iarchive &ia);
-CMD_ANSWER configureWireGuard(boost::archive::text_iarchive &ia);
-CMD_ANSWER getWireGuardStatus(boost::archive::text_iarchive &ia);
-CMD_ANSWER changeMtu(boost::archive::text_iarchive &ia);
-CMD_ANSWER setDnsLeakProtectEnabled(boost::archive::text_iarchive &ia);
-CMD_ANSWER clearFirewallRules(boost::archive::text_iarchive &ia);
-CMD_ANSWER checkFirewallState(boost::archive::text_iarchive &ia);
-CMD_ANSWER setFirewallRules(boost::archive::text_iarchive &ia);
-CMD_ANSWER getFirewallRules(boost::archive::text_iarchive &ia);
-CMD_ANSWER setFirewallOnBoot(boost::archive::text_iarchive &ia);
-CMD_ANSWER setMacAddress(boost::archive::text_iarchive &ia);
-CMD_ANSWER taskKill(boost::archive::text_iarchive &ia);
-CMD_ANSWER startCtrld(boost::archive::text_iarchive &ia);
-CMD_ANSWER startStunnel(boost::archive::text_iarchive &ia);
-CMD_ANSWER startWstunnel(boost::archive::text_iarchive &ia);
-CMD_ANSWER resetMacAddresses(boost::archive::text_iarchive &ia);
+CMD_ANSWER startOpenvpn(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER getCmdStatus(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER clearCmds(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER splitTunnelingSettings(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER sendConnectStatus(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER startWireGuard(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER stopWireGuard(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER configureWireGuard(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER getWireGuardStatus(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER changeMtu(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER setDnsLeakProtectEnabled(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER clearFirewallRules(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER checkFirewallState(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER setFirewallRules(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER getFirewallRules(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER setFirewallOnBoot(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER setFirewallAllowIps(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER setMacAddress(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER taskKill(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER startCtrld(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER startStunnel(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER startWstunnel(boost::archive::polymorphic_iarchive &ia);
+CMD_ANSWER resetMacAddresses(boost::archive::polymorphic_iarchive &ia);
 
-static const std::map<const int, std::function<CMD_ANSWER(boost::archive::text_iarchive &)>> kCommands = {
+static const std::map<const int, std::function<CMD_ANSWER(boost::archive::polymorphic_iarchive &)>> kCommands = {
     { HELPER_CMD_START_OPENVPN, startOpenvpn },
     { HELPER_CMD_GET_CMD_STATUS, getCmdStatus },
     { HELPER_CMD_CLEAR_CMDS, clearCmds },
@@ -49,6 +49,7 @@ static const std::map<const int, std::function<CMD_ANSWER(boost::archive::text_i
     { HELPER_CMD_SET_FIREWALL_RULES, setFirewallRules },
     { HELPER_CMD_GET_FIREWALL_RULES, getFirewallRules },
     { HELPER_CMD_SET_FIREWALL_ON_BOOT, setFirewallOnBoot },
+    { HELPER_CMD_SET_FIREWALL_ALLOW_IPS, setFirewallAllowIps },
     { HELPER_CMD_SET_MAC_ADDRESS, setMacAddress },
     { HELPER_CMD_TASK_KILL, taskKill },
     { HELPER_CMD_START_CTRLD, startCtrld },
@@ -57,4 +58,5 @@ static const std::map<const int, std::function<CMD_ANSWER(boost::archive::text_i
     { HELPER_CMD_RESET_MAC_ADDRESSES, resetMacAddresses },
 };
 
-CMD_ANSWER processCommand(int cmdId, const std::string packet);
+// The body is decoded from the text archive of the legacy connections or the binary archive of the sessions
+CMD_ANSWER processCommand(int cmdId, const std::string &packet, bool isBinaryEncoding);
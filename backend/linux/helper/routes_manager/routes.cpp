@@ -1,5 +1,6 @@
 #include "routes.h"
 #include <spdlog/spdlog.h>
+#include "../netlink_routes.h"
 #include "../utils.h"
 
 void Routes::add(const std::string &ip, const std::string &gateway, const std::string &mask)
@@ -10,6 +11,11 @@ void Routes::add(const std::string &ip, const std::string &gateway, const std::s
     rd.mask = mask;
     routes_.push_back(rd);
 
+    spdlog::info("add route: {}/{} via {}", ip, mask, gateway);
+    if (NetlinkRoutes::apply({}, {{ip + "/" + mask, gateway, ""}})) {
+        return;
+    }
+
     std::string cmd = "ip route add " + ip + "/" + mask + " via " + gateway;
     spdlog::info("execute: {}", cmd);
     Utils::executeCommand(cmd);
@@ -23,6 +29,11 @@ void Routes::addWithInterface(const std::string &ip, const std::string &interfac
     rd.mask = mask;
     routes_.push_back(rd);
 
+    spdlog::info("add route: {}/{} dev {}", ip, mask, interface);
+    if (NetlinkRoutes::apply({}, {{ip + "/" + mask, "", interface}})) {
+        return;
+    }
+
     std::string cmd = "ip route add " + ip + "/" + mask + " dev " + interface;
     spdlog::info("execute: {}", cmd);
     Utils::executeCommand(cmd);
@@ -31,6 +42,16 @@ void Routes::addWithInterface(const std::string &ip, const std::string &interfac
 
 void Routes::clear()
 {
+    std::vector<NetlinkRoutes::Route> nlDelete;
+    for (auto const &rd : routes_) {
+        spdlog::info("delete route: {}/{}", rd.ip, rd.mask);
+        nlDelete.push_back({rd.ip + "/" + rd.mask, rd.gateway, rd.interface});
+    }
+    if (NetlinkRoutes::apply(nlDelete, {})) {
+        routes_.clear();
+        return;
+    }
+
     for(auto const& rd: routes_)
     {
         if (rd.interface.empty())
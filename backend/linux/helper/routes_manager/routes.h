@@ -4,7 +4,7 @@
 #include <vector>
 
 
-// helper for add and clear routes via system "route" command
+// helper for add and clear routes via rtnetlink, or the system "ip route" command if rtnetlink is unavailable
 class Routes
 {
 public:
@@ -1,11 +1,13 @@
 #include "server.h"
 
 #include <boost/bind.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
-#include <boost/archive/text_iarchive.hpp>
 #include <boost/serialization/vector.hpp>
+#include <array>
 #include <codecvt>
 #include <grp.h>
+#include <sstream>
 #include <stdlib.h>
 #include <string>
 #include <sys/socket.h>
@@ -41,7 +43,7 @@ Server::~Server()
     unlink(SOCK_PATH);
 }
 
-bool Server::readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf, CMD_ANSWER &outCmdAnswer)
+bool Server::readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf, Session *session, CMD_ANSWER &outCmdAnswer)
 {
     // not enough data for read command
     if (buf->size() < sizeof(int)*3) {
@@ -65,31 +67,38 @@ bool Server::readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf,
         return false;
     }
 
-    struct ucred peerCred;
-    socklen_t lenPeerCred = sizeof(peerCred);
-    int retCode = getsockopt(sock->native_handle(), SOL_SOCKET, SO_PEERCRED, &peerCred, &lenPeerCred);
+    // the credentials of a unix socket peer do not change, so the connection is verified once
+    if (!session->isAuthenticated) {
+        struct ucred peerCred;
+        socklen_t lenPeerCred = sizeof(peerCred);
+        int retCode = getsockopt(sock->native_handle(), SOL_SOCKET, SO_PEERCRED, &peerCred, &lenPeerCred);
 
-    if ((retCode != 0) || (lenPeerCred != sizeof(peerCred))) {
-        spdlog::error("getsockopt(SO_PEERCRED) failed ({}).", errno);
-        return false;
-    }
+        if ((retCode != 0) || (lenPeerCred != sizeof(peerCred))) {
+            spdlog::error("getsockopt(SO_PEERCRED) failed ({}).", errno);
+            return false;
+        }
 
-    if (!HelperSecurity::instance().verifySignature()) {
-        return false;
+        if (!HelperSecurity::instance().verifyPeer(peerCred.pid)) {
+            return false;
+        }
+        session->isAuthenticated = true;
     }
 
-    std::vector<char> vector(length);
-    memcpy(&vector[0], bufPtr + headerSize, length);
-    std::string str(vector.begin(), vector.end());
-    std::istringstream stream(str);
-    outCmdAnswer = processCommand(cmdId, str);
+    if (cmdId == HELPER_CMD_START_SESSION) {
+        spdlog::info("client app started a session");
+        session->isBinaryEncoding = true;
+        outCmdAnswer.executed = 1;
+    } else {
+        std::string str(bufPtr + headerSize, length);
+        outCmdAnswer = processCommand(cmdId, str, session->isBinaryEncoding);
+    }
 
     buf->consume(headerSize + length);
 
     return true;
 }
 
-void Server::receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, const boost::system::error_code& ec, std::size_t bytes_transferred)
+void Server::receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, session_ptr session, const boost::system::error_code& ec, std::size_t bytes_transferred)
 {
     UNUSED(bytes_transferred);
 
@@ -97,13 +106,15 @@ void Server::receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::st
         // read and handle commands
         while (true) {
             CMD_ANSWER cmdAnswer;
-            if (!readAndHandleCommand(sock, buf.get(), cmdAnswer)) {
+            // the answer is encoded the same way as its command, this includes the answer to HELPER_CMD_START_SESSION
+            const bool isBinaryEncoding = session->isBinaryEncoding;
+            if (!readAndHandleCommand(sock, buf.get(), session.get(), cmdAnswer)) {
                 // goto receive next commands
                 boost::asio::async_read(*sock, *buf, boost::asio::transfer_at_least(1),
-                                        boost::bind(&Server::receiveCmdHandle, this, sock, buf, _1, _2));
+                                        boost::bind(&Server::receiveCmdHandle, this, sock, buf, session, _1, _2));
                 break;
             } else {
-                if (!sendAnswerCmd(sock, cmdAnswer)) {
+                if (!sendAnswerCmd(sock, cmdAnswer, isBinaryEncoding)) {
                     spdlog::info("client app disconnected");
                     return;
                 }
@@ -120,8 +131,9 @@ void Server::acceptHandler(const boost::system::error_code & ec, socket_ptr sock
         spdlog::info("client app connected");
 
         boost::shared_ptr<boost::asio::streambuf> buf(new boost::asio::streambuf);
+        session_ptr session(new Session);
         boost::asio::async_read(*sock, *buf, boost::asio::transfer_at_least(1),
-                                boost::bind(&Server::receiveCmdHandle, this, sock, buf, _1, _2));
+                                boost::bind(&Server::receiveCmdHandle, this, sock, buf, session, _1, _2));
     }
 
     startAccept();
@@ -133,25 +145,23 @@ void Server::startAccept()
     acceptor_->async_accept(*sock, boost::bind(&Server::acceptHandler, this, boost::asio::placeholders::error, sock));
 }
 
-bool Server::sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer)
+bool Server::sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer, bool isBinaryEncoding)
 {
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmdAnswer;
+    std::ostringstream stream;
+    if (isBinaryEncoding) {
+        boost::archive::binary_oarchive oa(stream, boost::archive::no_header);
+        oa << cmdAnswer;
+    } else {
+        boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+        oa << cmdAnswer;
+    }
     std::string str = stream.str();
     int length = (int)str.length();
-    // send answer to client
+    // send answer to client, the length and the body with one write
+    std::array<boost::asio::const_buffer, 2> buffers = { boost::asio::buffer(&length, sizeof(length)), boost::asio::buffer(str) };
     boost::system::error_code er;
-    boost::asio::write(*sock, boost::asio::buffer(&length, sizeof(length)), boost::asio::transfer_exactly(sizeof(length)), er);
-    if (er.value()) {
-        return false;
-    } else {
-        boost::asio::write(*sock, boost::asio::buffer(str.data(), str.length()), boost::asio::transfer_exactly(str.length()), er);
-        if (er.value()) {
-            return false;
-        }
-    }
-    return true;
+    boost::asio::write(*sock, buffers, boost::asio::transfer_all(), er);
+    return !er.value();
 }
 
 void Server::run()
@@ -25,15 +25,24 @@ public:
     void run();
 
 private:
+    // The state of a client connection. The peer is verified with the first command and stays verified
+    // for the lifetime of the connection.
+    struct Session
+    {
+        bool isAuthenticated = false;
+        bool isBinaryEncoding = false;  // set by HELPER_CMD_START_SESSION
+    };
+    typedef boost::shared_ptr<Session> session_ptr;
+
     boost::asio::io_service service_;
     boost::asio::local::stream_protocol::acceptor *acceptor_;
 
-    bool readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf, CMD_ANSWER &outCmdAnswer);
+    bool readAndHandleCommand(socket_ptr sock, boost::asio::streambuf *buf, Session *session, CMD_ANSWER &outCmdAnswer);
 
-    void receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, const boost::system::error_code& ec, std::size_t bytes_transferred);
+    void receiveCmdHandle(socket_ptr sock, boost::shared_ptr<boost::asio::streambuf> buf, session_ptr session, const boost::system::error_code& ec, std::size_t bytes_transferred);
     void acceptHandler(const boost::system::error_code & ec, socket_ptr sock);
     void startAccept();
 
-    bool sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer);
+    bool sendAnswerCmd(socket_ptr sock, const CMD_ANSWER &cmdAnswer, bool isBinaryEncoding);
 };
 
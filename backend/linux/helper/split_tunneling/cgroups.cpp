@@ -1,16 +1,23 @@
 #include "cgroups.h"
 
+#include <fcntl.h>
 #include <fstream>
+#include <linux/magic.h>
 #include <sstream>
 #include <spdlog/spdlog.h>
+#include <sys/statfs.h>
+#include <unistd.h>
 #include "../utils.h"
 
-CGroups::CGroups()
+CGroups::CGroups() : isUnifiedHierarchy_(false), isCgroupV2_(false), procsFd_(-1), rootProcsFd_(-1)
 {
+    struct statfs fs;
+    isUnifiedHierarchy_ = (statfs(kCgroupV2Root, &fs) == 0 && fs.f_type == CGROUP2_SUPER_MAGIC);
 }
 
 CGroups::~CGroups()
 {
+    closeProcsFiles();
 }
 
 bool CGroups::enable(CMD_SEND_CONNECT_STATUS &connectStatus, bool isAllowLanTraffic, bool isExclude)
@@ -19,46 +26,178 @@ bool CGroups::enable(CMD_SEND_CONNECT_STATUS &connectStatus, bool isAllowLanTraf
 
     std::string out;
 
-    int ret = Utils::executeCommand("/etc/windscribe/cgroups-up",
-                                    { mark_.c_str(),
-                                      connectStatus.defaultAdapter.gatewayIp,
-                                      connectStatus.defaultAdapter.adapterName,
-                                      connectStatus.vpnAdapter.gatewayIp,
-                                      connectStatus.vpnAdapter.adapterName,
-                                      connectStatus.remoteIp,
-                                      netClassId_.c_str(),
-                                      isAllowLanTraffic ? "allow": "disallow",
-                                      isExclude ? "exclusive": "inclusive"},
-                                    &out);
+    // once net_cls could not be mounted, it is not tried again
+    int ret = -1;
+    if (!isCgroupV2_) {
+        ret = runCgroupsUp(connectStatus, isAllowLanTraffic, isExclude, false, out);
+    }
+    if (ret != 0 && isUnifiedHierarchy_) {
+        if (!isCgroupV2_) {
+            spdlog::warn("net_cls not available ({}), using cgroups v2", out);
+        }
+        out.clear();
+        ret = runCgroupsUp(connectStatus, isAllowLanTraffic, isExclude, true, out);
+        if (ret == 0) {
+            std::lock_guard<std::mutex> guard(mutex_);
+            isCgroupV2_ = true;
+        }
+    }
     if (ret != 0) {
         spdlog::error("cgroups-up script failed: {}", out);
         return false;
     }
 
+    openProcsFiles();
     return true;
 }
 
+int CGroups::runCgroupsUp(CMD_SEND_CONNECT_STATUS &connectStatus, bool isAllowLanTraffic, bool isExclude, bool isCgroupV2, std::string &out)
+{
+    return Utils::executeCommand("/etc/windscribe/cgroups-up",
+                                 { mark_.c_str(),
+                                   connectStatus.defaultAdapter.gatewayIp,
+                                   connectStatus.defaultAdapter.adapterName,
+                                   connectStatus.vpnAdapter.gatewayIp,
+                                   connectStatus.vpnAdapter.adapterName,
+                                   connectStatus.remoteIp,
+                                   netClassId_.c_str(),
+                                   isAllowLanTraffic ? "allow": "disallow",
+                                   isExclude ? "exclusive": "inclusive",
+                                   isCgroupV2 ? "v2" : "v1"},
+                                 &out);
+}
+
 void CGroups::disable()
 {
     spdlog::debug("cgroups disable");
 
+    {
+        // cgroups-down moves whatever is left to the root cgroup
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (const auto &it : originalCgroups_) {
+            restoreApp(it.first, it.second);
+        }
+        originalCgroups_.clear();
+    }
+    closeProcsFiles();
     Utils::executeCommand("/etc/windscribe/cgroups-down");
 }
 
-void CGroups::addApp(pid_t pid)
+void CGroups::addApp(pid_t pid, pid_t parentPid)
 {
-    std::ofstream out;
-    out.open((findNetclsRoot() + "/windscribe/cgroup.procs").c_str());
-    out << pid;
-    out.close();
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (isCgroupV2_ && procsFd_ >= 0 && originalCgroups_.find(pid) == originalCgroups_.end()) {
+        // a forked child is already in the windscribe cgroup, it belongs where its parent came from
+        std::string cgroup = readCgroup(pid);
+        if (cgroup == std::string("/") + kCgroupName) {
+            auto it = originalCgroups_.find(parentPid);
+            cgroup = (it != originalCgroups_.end()) ? it->second : std::string();
+        }
+        if (!cgroup.empty()) {
+            originalCgroups_[pid] = cgroup;
+        }
+    }
+    writePid(procsFd_, pid);
 }
 
 void CGroups::removeApp(pid_t pid)
 {
-    std::ofstream out;
-    out.open((findNetclsRoot() + "/cgroup.procs").c_str());
-    out << pid;
-    out.close();
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = originalCgroups_.find(pid);
+    if (it == originalCgroups_.end()) {
+        writePid(rootProcsFd_, pid);
+        return;
+    }
+    restoreApp(pid, it->second);
+    originalCgroups_.erase(it);
+}
+
+void CGroups::forgetApp(pid_t pid)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    originalCgroups_.erase(pid);
+}
+
+void CGroups::openProcsFiles()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (procsFd_ >= 0) {
+        return;
+    }
+
+    const std::string root = findRoot();
+    if (root.empty()) {
+        spdlog::error("cgroups root not found");
+        return;
+    }
+    procsFd_ = open((root + "/" + kCgroupName + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+    rootProcsFd_ = open((root + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+    if (procsFd_ < 0 || rootProcsFd_ < 0) {
+        spdlog::error("Could not open cgroup.procs in {} ({})", root, errno);
+    }
+}
+
+void CGroups::closeProcsFiles()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (procsFd_ >= 0) {
+        close(procsFd_);
+        procsFd_ = -1;
+    }
+    if (rootProcsFd_ >= 0) {
+        close(rootProcsFd_);
+        rootProcsFd_ = -1;
+    }
+}
+
+void CGroups::writePid(int fd, pid_t pid)
+{
+    if (fd < 0) {
+        return;
+    }
+    // cgroup.procs takes one pid per write, a process that already exited fails with ESRCH
+    const std::string str = std::to_string(pid);
+    if (write(fd, str.c_str(), str.size()) < 0 && errno != ESRCH) {
+        spdlog::debug("Could not move process {} ({})", pid, errno);
+    }
+}
+
+std::string CGroups::readCgroup(pid_t pid)
+{
+    // the unified hierarchy is the "0::<path>" line
+    std::ifstream file("/proc/" + std::to_string(pid) + "/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            return line.substr(3);
+        }
+    }
+    return std::string();
+}
+
+void CGroups::restoreApp(pid_t pid, const std::string &cgroup)
+{
+    // the original cgroup may be gone or may not take processes anymore, the root cgroup always does
+    const std::string path = std::string(kCgroupV2Root) + cgroup + "/cgroup.procs";
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        const std::string str = std::to_string(pid);
+        const bool isRestored = write(fd, str.c_str(), str.size()) >= 0 || errno == ESRCH;
+        close(fd);
+        if (isRestored) {
+            return;
+        }
+    }
+    spdlog::debug("Could not move process {} back to {} ({})", pid, cgroup, errno);
+    writePid(rootProcsFd_, pid);
+}
+
+std::string CGroups::findRoot()
+{
+    if (isCgroupV2_) {
+        return kCgroupV2Root;
+    }
+    return findNetclsRoot();
 }
 
 std::string CGroups::findNetclsRoot()
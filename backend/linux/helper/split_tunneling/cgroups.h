@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <string>
 #include "../../../posix_common/helper_commands.h"
 
@@ -15,20 +17,50 @@ public:
     bool enable(CMD_SEND_CONNECT_STATUS &connectStatus, bool isAllowLanTraffic, bool isExclude);
     void disable();
 
-    void addApp(pid_t pid);
+    // Move a process into/out of the windscribe cgroup. The children forked later inherit the cgroup.
+    // With cgroups v2 the process goes back to the cgroup it was in (the one of parentPid for a forked child).
+    void addApp(pid_t pid, pid_t parentPid = 0);
     void removeApp(pid_t pid);
+    // Drop what is known about an exited process.
+    void forgetApp(pid_t pid);
 
     std::string mark() const { return mark_; };
     std::string netClassId() const { return netClassId_; };
 
+    // The option and value of the iptables cgroup match for the windscribe cgroup:
+    // the net_cls class id with cgroups v1, the path in the unified hierarchy with cgroups v2. Valid after enable().
+    std::string matchOption() const { return isCgroupV2_ ? "--path" : "--cgroup"; };
+    std::string matchValue() const { return isCgroupV2_ ? kCgroupName : netClassId_; };
+
 private:
     const std::string mark_ = "0xdecafbad";
     const std::string netClassId_ = "0xcafecafe";
+    static constexpr const char *kCgroupName = "windscribe";
+    static constexpr const char *kCgroupV2Root = "/sys/fs/cgroup";
 
+    // net_cls is used whenever it can be mounted: it re-tags the existing sockets of a process moved into the cgroup,
+    // the v2 path match only sees the cgroup a socket was created in. The unified hierarchy is the fallback.
+    bool isUnifiedHierarchy_;   // the host runs the unified hierarchy only
+    bool isCgroupV2_;           // the windscribe cgroup is in the unified hierarchy
     std::string net_cls_root_;
 
+    // cgroup.procs of the windscribe cgroup and of its parent, open while split tunneling is enabled,
+    // the process monitor writes to them for every started app
+    std::mutex mutex_;
+    int procsFd_;
+    int rootProcsFd_;
+    // cgroups v2: the cgroup each app was in before it was moved, relative to the root
+    std::map<pid_t, std::string> originalCgroups_;
+
     CGroups();
     ~CGroups();
 
     std::string findNetclsRoot();
+    std::string findRoot();
+    int runCgroupsUp(CMD_SEND_CONNECT_STATUS &connectStatus, bool isAllowLanTraffic, bool isExclude, bool isCgroupV2, std::string &out);
+    void openProcsFiles();
+    void closeProcsFiles();
+    void writePid(int fd, pid_t pid);
+    std::string readCgroup(pid_t pid);
+    void restoreApp(pid_t pid, const std::string &cgroup);
 };
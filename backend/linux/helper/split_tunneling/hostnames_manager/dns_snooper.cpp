@@ -0,0 +1,382 @@
+#include "dns_snooper.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <poll.h>
+#include <spdlog/spdlog.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+const std::uint16_t kDnsPort = 53;
+const std::uint16_t kTypeA = 1;
+const std::uint16_t kClassIn = 1;
+
+std::uint16_t read16(const unsigned char *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+std::uint32_t read32(const unsigned char *p)
+{
+    return (std::uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+// Reads the name at offset, following the compression pointers. Advances offset past the name in the record.
+bool readName(const unsigned char *data, size_t len, size_t &offset, std::string &outName)
+{
+    outName.clear();
+    size_t pos = offset;
+    bool isJumped = false;
+    // the pointers can loop in a malformed packet
+    for (int labels = 0; labels < 128; ++labels) {
+        if (pos >= len) {
+            return false;
+        }
+        const std::uint8_t labelLen = data[pos];
+        if (labelLen == 0) {
+            if (!isJumped) {
+                offset = pos + 1;
+            }
+            return true;
+        }
+        if ((labelLen & 0xC0) == 0xC0) {
+            if (pos + 1 >= len) {
+                return false;
+            }
+            if (!isJumped) {
+                offset = pos + 2;
+                isJumped = true;
+            }
+            pos = ((labelLen & 0x3F) << 8) | data[pos + 1];
+            continue;
+        }
+        if (labelLen > 63 || pos + 1 + labelLen > len) {
+            return false;
+        }
+        if (!outName.empty()) {
+            outName += '.';
+        }
+        for (size_t i = pos + 1; i < pos + 1 + labelLen; ++i) {
+            outName += static_cast<char>(tolower(data[i]));
+        }
+        pos += 1 + labelLen;
+    }
+    return false;
+}
+}  // namespace
+
+DnsSnooper::DnsSnooper(std::function<void(const std::set<std::string> &)> addressesChangedCallback) :
+    addressesChangedCallback_(addressesChangedCallback), socket_(-1), thread_(nullptr), doStopThread_(false),
+    isHostnamesChanged_(false)
+{
+}
+
+DnsSnooper::~DnsSnooper()
+{
+    stop();
+}
+
+void DnsSnooper::setHostnames(const std::vector<std::string> &hostnames)
+{
+    std::set<std::string> names;
+    std::vector<std::string> suffixes;
+    for (auto hostname : hostnames) {
+        std::transform(hostname.begin(), hostname.end(), hostname.begin(), ::tolower);
+        if (!hostname.empty() && hostname.back() == '.') {
+            hostname.pop_back();
+        }
+        if (hostname.rfind("*.", 0) == 0) {
+            suffixes.push_back(hostname.substr(1));
+        } else if (!hostname.empty()) {
+            names.insert(hostname);
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (names == hostnames_ && suffixes == wildcardSuffixes_) {
+        return;
+    }
+    hostnames_ = std::move(names);
+    wildcardSuffixes_ = std::move(suffixes);
+    isHostnamesChanged_ = true;
+}
+
+bool DnsSnooper::start()
+{
+    if (thread_) {
+        return true;
+    }
+
+    // the packets of all interfaces, without the link layer header; only the ETH_P_ALL sockets see the sent packets too
+    socket_ = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, htons(ETH_P_ALL));
+    if (socket_ < 0) {
+        spdlog::error("DNS snooper: could not open packet socket ({})", errno);
+        return false;
+    }
+
+    // Only the unfragmented IPv4 UDP packets from or to port 53 are passed to the helper, the filter runs in the kernel.
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, std::uint32_t(SKF_AD_OFF + SKF_AD_PROTOCOL)),    // ethertype
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 10),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),                      // IP protocol
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 8),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),                      // flags and fragment offset
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3FFF, 6, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),                     // IP header length
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 0),                      // UDP source port
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, kDnsPort, 2, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),                      // UDP destination port
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, kDnsPort, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog filter;
+    filter.len = sizeof(code) / sizeof(code[0]);
+    filter.filter = code;
+    if (setsockopt(socket_, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) < 0) {
+        spdlog::error("DNS snooper: could not attach filter ({})", errno);
+        close(socket_);
+        socket_ = -1;
+        return false;
+    }
+
+    addresses_.clear();
+    pendingQueries_.clear();
+    doStopThread_ = false;
+    thread_ = new std::thread(&DnsSnooper::snooperThread, this);
+    spdlog::debug("DNS snooper started");
+    return true;
+}
+
+void DnsSnooper::stop()
+{
+    if (!thread_) {
+        return;
+    }
+
+    doStopThread_ = true;
+    thread_->join();
+    delete thread_;
+    thread_ = nullptr;
+    close(socket_);
+    socket_ = -1;
+    spdlog::debug("DNS snooper stopped");
+}
+
+void DnsSnooper::snooperThread()
+{
+    unsigned char buf[65536];
+    auto lastExpiryCheck = std::chrono::steady_clock::now();
+
+    while (!doStopThread_) {
+        bool isChanged = false;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (isHostnamesChanged_) {
+                isHostnamesChanged_ = false;
+                isChanged = !addresses_.empty();
+                addresses_.clear();
+            }
+        }
+
+        struct pollfd pfd;
+        pfd.fd = socket_;
+        pfd.events = POLLIN;
+        int ret = poll(&pfd, 1, 250);
+        if (ret < 0 && errno != EINTR) {
+            spdlog::error("DNS snooper: poll failed ({})", errno);
+            break;
+        }
+
+        // read everything queued, then report the changes once
+        while (ret > 0) {
+            struct sockaddr_ll addr;
+            socklen_t addrLen = sizeof(addr);
+            ssize_t len = recvfrom(socket_, buf, sizeof(buf), MSG_DONTWAIT, reinterpret_cast<struct sockaddr *>(&addr), &addrLen);
+            if (len <= 0) {
+                break;
+            }
+            // a packet on the loopback is seen twice, when sent (the copy used for the queries) and when received
+            isChanged |= processPacket(buf, len, addr.sll_pkttype == PACKET_OUTGOING);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastExpiryCheck >= std::chrono::seconds(1)) {
+            lastExpiryCheck = now;
+            isChanged |= removeExpired();
+            removeExpiredQueries();
+        }
+
+        if (isChanged) {
+            std::set<std::string> addresses;
+            for (const auto &it : addresses_) {
+                addresses.insert(it.first);
+            }
+            addressesChangedCallback_(addresses);
+        }
+    }
+}
+
+bool DnsSnooper::processPacket(const unsigned char *data, size_t len, bool isOutgoing)
+{
+    // skip the IP and UDP headers, the packets queued before the filter was attached can be anything
+    if (len < 20 || (data[0] >> 4) != 4 || data[9] != IPPROTO_UDP) {
+        return false;
+    }
+    const size_t ipHeaderLen = (data[0] & 0x0F) * 4;
+    if (len < ipHeaderLen + 8 + 12) {
+        return false;
+    }
+    std::uint32_t srcIp, dstIp;
+    memcpy(&srcIp, data + 12, sizeof(srcIp));
+    memcpy(&dstIp, data + 16, sizeof(dstIp));
+    const std::uint16_t srcPort = read16(data + ipHeaderLen);
+    const std::uint16_t dstPort = read16(data + ipHeaderLen + 2);
+    const std::uint16_t id = read16(data + ipHeaderLen + 8);
+    const bool isResponse = data[ipHeaderLen + 8 + 2] & 0x80;
+
+    if (isOutgoing) {
+        if (dstPort == kDnsPort && !isResponse) {
+            if (pendingQueries_.size() >= kMaxPendingQueries) {
+                removeExpiredQueries();
+            }
+            if (pendingQueries_.size() < kMaxPendingQueries) {
+                pendingQueries_[std::make_tuple(dstIp, srcIp, srcPort, id)] = std::chrono::steady_clock::now();
+            }
+        }
+        return false;
+    }
+
+    if (srcPort != kDnsPort) {
+        return false;
+    }
+    auto query = pendingQueries_.find(std::make_tuple(srcIp, dstIp, dstPort, id));
+    if (query == pendingQueries_.end()) {
+        return false;
+    }
+    pendingQueries_.erase(query);
+
+    std::vector<std::pair<std::string, std::uint32_t>> answers;
+    if (!parseAnswer(data + ipHeaderLen + 8, len - ipHeaderLen - 8, answers)) {
+        return false;
+    }
+
+    bool isChanged = false;
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto &answer : answers) {
+        const auto expiry = now + std::chrono::seconds(std::max(answer.second, kMinTtlSec));
+        auto it = addresses_.find(answer.first);
+        if (it == addresses_.end()) {
+            spdlog::debug("DNS snooper: new address {}", answer.first);
+            addresses_[answer.first] = expiry;
+            isChanged = true;
+        } else if (it->second < expiry) {
+            it->second = expiry;
+        }
+    }
+    return isChanged;
+}
+
+bool DnsSnooper::removeExpired()
+{
+    bool isChanged = false;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = addresses_.begin(); it != addresses_.end();) {
+        if (it->second <= now) {
+            spdlog::debug("DNS snooper: address {} expired", it->first);
+            it = addresses_.erase(it);
+            isChanged = true;
+        } else {
+            ++it;
+        }
+    }
+    return isChanged;
+}
+
+void DnsSnooper::removeExpiredQueries()
+{
+    const auto expired = std::chrono::steady_clock::now() - std::chrono::seconds(kQueryTimeoutSec);
+    for (auto it = pendingQueries_.begin(); it != pendingQueries_.end();) {
+        if (it->second <= expired) {
+            it = pendingQueries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool DnsSnooper::parseAnswer(const unsigned char *data, size_t len, std::vector<std::pair<std::string, std::uint32_t>> &outAddresses)
+{
+    outAddresses.clear();
+
+    // header: id, flags, the counts of the questions, answers, authority and additional records
+    if (len < 12) {
+        return false;
+    }
+    const std::uint16_t flags = read16(data + 2);
+    const bool isResponse = flags & 0x8000;
+    const std::uint16_t rcode = flags & 0x000F;
+    if (!isResponse || rcode != 0 || read16(data + 4) != 1) {
+        return false;
+    }
+    const std::uint16_t answerCount = read16(data + 6);
+
+    // the name the application asked for, the answer may be a chain of CNAMEs for a CDN host
+    size_t offset = 12;
+    std::string question;
+    if (!readName(data, len, offset, question) || offset + 4 > len) {
+        return false;
+    }
+    offset += 4;
+    if (!isMatchingHostname(question)) {
+        return false;
+    }
+
+    std::string name;
+    for (std::uint16_t i = 0; i < answerCount; ++i) {
+        if (!readName(data, len, offset, name) || offset + 10 > len) {
+            break;
+        }
+        const std::uint16_t type = read16(data + offset);
+        const std::uint16_t cls = read16(data + offset + 2);
+        const std::uint32_t ttl = read32(data + offset + 4);
+        const std::uint16_t dataLen = read16(data + offset + 8);
+        offset += 10;
+        if (offset + dataLen > len) {
+            break;
+        }
+        // only IPv4 addresses are routed, the AAAA records are skipped
+        if (type == kTypeA && cls == kClassIn && dataLen == 4) {
+            char str[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, data + offset, str, sizeof(str));
+            // a filtering resolver answers 0.0.0.0 for a blocked name
+            if (strcmp(str, "0.0.0.0") != 0) {
+                outAddresses.push_back(std::make_pair(str, ttl));
+            }
+        }
+        offset += dataLen;
+    }
+    return !outAddresses.empty();
+}
+
+bool DnsSnooper::isMatchingHostname(const std::string &hostname)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (hostnames_.find(hostname) != hostnames_.end()) {
+        return true;
+    }
+    for (const auto &suffix : wildcardSuffixes_) {
+        if (hostname.size() > suffix.size() && hostname.compare(hostname.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
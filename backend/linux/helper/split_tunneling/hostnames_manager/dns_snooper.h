@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Watches the DNS answers delivered to the applications (UDP from port 53 on any interface, including the answers
+// of the local ctrld instance on the loopback) and collects the IPv4 addresses of the configured hostnames.
+// Only the answers to the queries sent from this host are used, anybody can send a UDP packet from port 53.
+// The addresses of a CDN host change often, the one-time resolve of the hostnames does not see the ones
+// the applications actually connect to.
+class DnsSnooper
+{
+public:
+    // called from the snooper thread with all the live addresses, every time an address is added or expires
+    explicit DnsSnooper(std::function<void(const std::set<std::string> &)> addressesChangedCallback);
+    ~DnsSnooper();
+    DnsSnooper(const DnsSnooper &) = delete;
+    DnsSnooper &operator=(const DnsSnooper &) = delete;
+
+    // "example.com" matches the name only, "*.example.com" matches the subdomains of example.com
+    void setHostnames(const std::vector<std::string> &hostnames);
+    bool start();
+    void stop();
+
+private:
+    // An address is kept for its TTL but at least this long: the applications and the system resolver cache
+    // the answers for a while, and an established connection would break if its route was removed.
+    static constexpr std::uint32_t kMinTtlSec = 300;
+    // a query is forgotten if not answered in time, and the oldest ones if there are too many
+    static constexpr std::uint32_t kQueryTimeoutSec = 10;
+    static constexpr size_t kMaxPendingQueries = 4096;
+
+    // server address, client address, client port and transaction id, the addresses in network order
+    typedef std::tuple<std::uint32_t, std::uint32_t, std::uint16_t, std::uint16_t> QueryKey;
+
+    std::function<void(const std::set<std::string> &)> addressesChangedCallback_;
+    int socket_;
+    std::thread *thread_;
+    std::atomic<bool> doStopThread_;
+
+    // guards the hostnames, which are changed by the helper commands
+    std::mutex mutex_;
+    std::set<std::string> hostnames_;
+    std::vector<std::string> wildcardSuffixes_;     // ".example.com" for "*.example.com"
+    bool isHostnamesChanged_;   // the addresses of the previous hostnames are dropped by the snooper thread
+
+    // used from the snooper thread only
+    std::map<std::string, std::chrono::steady_clock::time_point> addresses_;
+    std::map<QueryKey, std::chrono::steady_clock::time_point> pendingQueries_;
+
+    void snooperThread();
+    // a query sent from this host is remembered, an answer is processed if it matches one
+    bool processPacket(const unsigned char *data, size_t len, bool isOutgoing);
+    // the IPv4 addresses and TTLs of the A records in a DNS answer (the UDP payload) for one of the hostnames
+    bool parseAnswer(const unsigned char *data, size_t len, std::vector<std::pair<std::string, std::uint32_t>> &outAddresses);
+    bool removeExpired();
+    void removeExpiredQueries();
+    bool isMatchingHostname(const std::string &hostname);
+};
@@ -4,12 +4,15 @@
 #include "../../firewallcontroller.h"
 
 HostnamesManager::HostnamesManager(): isEnabled_(false),
-    dnsResolver_(std::bind(&HostnamesManager::dnsResolverCallback, this, std::placeholders::_1))
+    dnsResolver_(std::bind(&HostnamesManager::dnsResolverCallback, this, std::placeholders::_1)),
+    dnsSnooper_(std::bind(&HostnamesManager::dnsSnooperCallback, this, std::placeholders::_1))
 {
 }
 
 HostnamesManager::~HostnamesManager()
 {
+    // the snooper thread calls back into the members declared after the snooper, which are destroyed first
+    dnsSnooper_.stop();
 }
 
 void HostnamesManager::enable(const std::string &gatewayIp)
@@ -19,13 +22,33 @@ void HostnamesManager::enable(const std::string &gatewayIp)
 
         gatewayIp_ = gatewayIp;
         ipRoutes_.clear();
-        ipRoutes_.setIps(gatewayIp_, ipsLatest_);
-        FirewallController::instance().setSplitTunnelIpExceptions(ipsLatest_);
+        resolvedIps_.clear();
+        updateIps();
         isEnabled_ = true;
     }
 
+    // the wildcard hosts can only be matched in the DNS answers
+    std::vector<std::string> hosts;
+    for (const auto &host : hostsLatest_) {
+        if (host.rfind("*.", 0) != 0) {
+            hosts.push_back(host);
+        }
+    }
+
+    dnsSnooper_.setHostnames(hostsLatest_);
+    if (hostsLatest_.empty()) {
+        dnsSnooper_.stop();
+        std::lock_guard<std::recursive_mutex> guard(mutex_);
+        if (!snoopedIps_.empty()) {
+            snoopedIps_.clear();
+            updateIps();
+        }
+    } else if (!dnsSnooper_.start()) {
+        spdlog::warn("DNS answers are not watched, the hostnames are resolved once");
+    }
+
     dnsResolver_.cancelAll();
-    dnsResolver_.resolveDomains(hostsLatest_);
+    dnsResolver_.resolveDomains(hosts);
 }
 
 void HostnamesManager::disable()
@@ -37,8 +60,16 @@ void HostnamesManager::disable()
             return;
         }
         ipRoutes_.clear();
+        resolvedIps_.clear();
         isEnabled_ = false;
     }
+    // the snooper thread waits for the mutex in the callback, so it's stopped without holding it;
+    // a callback that was waiting has stored its addresses by then, they are dropped after the stop
+    dnsSnooper_.stop();
+    {
+        std::lock_guard<std::recursive_mutex> guard(mutex_);
+        snoopedIps_.clear();
+    }
     dnsResolver_.cancelAll();
     FirewallController::instance().setSplitTunnelIpExceptions(std::vector<std::string>());
 }
@@ -67,16 +98,35 @@ void HostnamesManager::dnsResolverCallback(std::map<std::string, DnsResolver::Ho
                     hostsIps.insert(hostsIps.end(), addr);
                 }
             }
-            hostsIps.insert(hostsIps.end(), it->second.addresses.begin(), it->second.addresses.end());
         } else {
             spdlog::debug("HostnamesManager::dnsResolverCallback(), Failed resolve : {}", it->first);
         }
     }
 
-    hostsIps.insert(hostsIps.end(), ipsLatest_.begin(), ipsLatest_.end());
+    resolvedIps_ = hostsIps;
+    if (isEnabled_) {
+        updateIps();
+    }
+}
+
+void HostnamesManager::dnsSnooperCallback(const std::set<std::string> &addresses)
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex_);
 
+    spdlog::debug("HostnamesManager::dnsSnooperCallback(), {} addresses", addresses.size());
+    snoopedIps_ = addresses;
     if (isEnabled_) {
-        ipRoutes_.setIps(gatewayIp_, hostsIps);
-        FirewallController::instance().setSplitTunnelIpExceptions(hostsIps);
+        updateIps();
     }
 }
+
+void HostnamesManager::updateIps()
+{
+    // the routes and the firewall exceptions are updated with the difference from the previous list only
+    std::vector<std::string> ips = ipsLatest_;
+    ips.insert(ips.end(), resolvedIps_.begin(), resolvedIps_.end());
+    ips.insert(ips.end(), snoopedIps_.begin(), snoopedIps_.end());
+
+    ipRoutes_.setIps(gatewayIp_, ips);
+    FirewallController::instance().setSplitTunnelIpExceptions(ips);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <set>
 #include "dns_resolver.h"
+#include "dns_snooper.h"
 #include "ip_routes.h"
 
 class HostnamesManager
@@ -15,6 +17,7 @@ public:
 
 private:
     DnsResolver dnsResolver_;
+    DnsSnooper dnsSnooper_;
     IpRoutes ipRoutes_;
 
     bool isEnabled_;
@@ -24,8 +27,14 @@ private:
     std::vector<std::string> ipsLatest_;
     std::vector<std::string> hostsLatest_;
 
+    // the addresses of the hosts resolved when enabled, and the ones seen in the DNS answers to the applications since
+    std::vector<std::string> resolvedIps_;
+    std::set<std::string> snoopedIps_;
+
     std::string gatewayIp_;
 
     void dnsResolverCallback(std::map<std::string, DnsResolver::HostInfo> hostInfos);
+    void dnsSnooperCallback(const std::set<std::string> &addresses);
+    void updateIps();
 };
 
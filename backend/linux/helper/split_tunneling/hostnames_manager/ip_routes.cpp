@@ -2,6 +2,7 @@
 
 #include <set>
 #include <spdlog/spdlog.h>
+#include "../../netlink_routes.h"
 #include "../../utils.h"
 
 void IpRoutes::setIps(const std::string &defaultRouteIp, const std::vector<std::string> &ips)
@@ -22,16 +23,16 @@ void IpRoutes::setIps(const std::string &defaultRouteIp, const std::vector<std::
         }
     }
 
-    // delete routes
+    std::vector<RouteDescr> routesDelete;
     for (auto ip = ipsDelete.begin(); ip != ipsDelete.end(); ++ip) {
         auto fr = activeRoutes_.find(*ip);
         if (fr != activeRoutes_.end()) {
-            deleteRoute(fr->second);
+            routesDelete.push_back(fr->second);
             activeRoutes_.erase(fr);
         }
     }
 
-    // add routes
+    std::vector<RouteDescr> routesAdd;
     for (auto ip = ipsSet.begin(); ip != ipsSet.end(); ++ip) {
         auto ar = activeRoutes_.find(*ip);
         if (ar != activeRoutes_.end()) {
@@ -40,21 +41,53 @@ void IpRoutes::setIps(const std::string &defaultRouteIp, const std::vector<std::
             RouteDescr rd;
             rd.ip = *ip;
             rd.defaultRouteIp = defaultRouteIp;
-            addRoute(rd);
+            routesAdd.push_back(rd);
             activeRoutes_[*ip] = rd;
         }
     }
+
+    applyRoutes(routesDelete, routesAdd);
 }
 
 void IpRoutes::clear()
 {
     std::lock_guard<std::recursive_mutex> guard(mutex_);
+    std::vector<RouteDescr> routesDelete;
     for (auto it = activeRoutes_.begin(); it != activeRoutes_.end(); ++it) {
-        deleteRoute(it->second);
+        routesDelete.push_back(it->second);
     }
+    applyRoutes(routesDelete, std::vector<RouteDescr>());
     activeRoutes_.clear();
 }
 
+void IpRoutes::applyRoutes(const std::vector<RouteDescr> &routesDelete, const std::vector<RouteDescr> &routesAdd)
+{
+    if (routesDelete.empty() && routesAdd.empty()) {
+        return;
+    }
+
+    // a resolved hostname list can have hundreds of addresses, so all the changes go to the kernel with one batch
+    std::vector<NetlinkRoutes::Route> nlDelete;
+    std::vector<NetlinkRoutes::Route> nlAdd;
+    for (const auto &rd : routesDelete) {
+        nlDelete.push_back({rd.ip, rd.defaultRouteIp, ""});
+    }
+    for (const auto &rd : routesAdd) {
+        nlAdd.push_back({rd.ip, rd.defaultRouteIp, ""});
+    }
+    if (NetlinkRoutes::apply(nlDelete, nlAdd)) {
+        spdlog::info("Split tunneling routes: {} deleted, {} added", routesDelete.size(), routesAdd.size());
+        return;
+    }
+
+    for (const auto &rd : routesDelete) {
+        deleteRoute(rd);
+    }
+    for (const auto &rd : routesAdd) {
+        addRoute(rd);
+    }
+}
+
 void IpRoutes::addRoute(const RouteDescr &rd)
 {
     std::string cmd = "ip route add " + rd.ip + " via " + rd.defaultRouteIp;
@@ -5,7 +5,7 @@
 #include <mutex>
 #include <map>
 
-// manage Ip route via "route add" and "route delete" commands
+// manage Ip routes via rtnetlink, or the "ip route add" and "ip route del" commands if rtnetlink is unavailable
 class IpRoutes
 {
 public:
@@ -23,6 +23,7 @@ private:
 
     std::map<std::string, RouteDescr> activeRoutes_;
 
+    void applyRoutes(const std::vector<RouteDescr> &routesDelete, const std::vector<RouteDescr> &routesAdd);
     void addRoute(const RouteDescr &rd);
     void deleteRoute(const RouteDescr &rd);
 };
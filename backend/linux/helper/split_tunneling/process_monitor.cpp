@@ -11,6 +11,7 @@
 #include <poll.h>
 #include <sstream>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <spdlog/spdlog.h>
 
@@ -53,21 +54,20 @@ void ProcessMonitor::monitorWorker(void *ctx)
             break;
         }
 
-        std::string cmd;
+        // the events of threads (pid != tgid) are ignored, a thread is always in the cgroup of its process
+        const auto &eventData = nlcn_msg.proc_ev.event_data;
         switch (nlcn_msg.proc_ev.what) {
             case 0x00000001: // PROC_EVENT_FORK:
-                if (compareCmd(nlcn_msg.proc_ev.event_data.fork.child_pid, apps_)) {
-                    CGroups::instance().addApp(nlcn_msg.proc_ev.event_data.fork.child_pid);
+                if (eventData.fork.child_pid == eventData.fork.child_tgid) {
+                    onFork(eventData.fork.parent_tgid, eventData.fork.child_pid);
                 }
                 break;
             case 0x00000002: // PROC_EVENT_EXEC:
-                if (compareCmd(nlcn_msg.proc_ev.event_data.exec.process_pid, apps_)) {
-                    CGroups::instance().addApp(nlcn_msg.proc_ev.event_data.exec.process_pid);
-                }
+                onExec(eventData.exec.process_pid);
                 break;
             case 0x80000000: // PROC_EVENT_EXIT:
-                if (compareCmd(nlcn_msg.proc_ev.event_data.exit.process_pid, apps_)) {
-                    CGroups::instance().removeApp(nlcn_msg.proc_ev.event_data.exit.process_pid);
+                if (eventData.exit.process_pid == eventData.exit.process_tgid) {
+                    onExit(eventData.exit.process_pid);
                 }
                 break;
             default:
@@ -80,6 +80,61 @@ void ProcessMonitor::monitorWorker(void *ctx)
     spdlog::debug("process monitor thread exiting");
 }
 
+void ProcessMonitor::onFork(pid_t parentPid, pid_t childPid)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (pids_.find(parentPid) == pids_.end()) {
+        return;
+    }
+    // The child inherits the cgroup of the parent. It is moved anyway, the fork could have happened
+    // before the parent was moved. No need to look at /proc, the child runs the executable of the parent.
+    pids_.insert(childPid);
+    CGroups::instance().addApp(childPid, parentPid);
+}
+
+void ProcessMonitor::onExec(pid_t pid)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    // a process that executes something else stays in the cgroup, like before
+    if (pids_.find(pid) != pids_.end()) {
+        return;
+    }
+    if (isApp(pid)) {
+        pids_.insert(pid);
+        CGroups::instance().addApp(pid);
+    }
+}
+
+void ProcessMonitor::onExit(pid_t pid)
+{
+    // the kernel removes an exited process from its cgroup
+    std::lock_guard<std::mutex> guard(mutex_);
+    pids_.erase(pid);
+    CGroups::instance().forgetApp(pid);
+}
+
+bool ProcessMonitor::isApp(pid_t pid)
+{
+    struct stat st;
+    if (stat((std::string("/proc/") + std::to_string(pid) + "/exe").c_str(), &st) != 0) {
+        return false;
+    }
+
+    const auto key = std::make_pair(st.st_dev, st.st_ino);
+    const auto it = exeCache_.find(key);
+    if (it != exeCache_.end()) {
+        return it->second;
+    }
+
+    // the executables change rarely, the limit only guards against the inodes of updated binaries piling up
+    if (exeCache_.size() >= kMaxExeCacheSize) {
+        exeCache_.clear();
+    }
+    const bool result = compareCmd(pid, apps_);
+    exeCache_[key] = result;
+    return result;
+}
+
 ProcessMonitor::ProcessMonitor() : isEnabled_(false), thread_(nullptr), sock_(-1), running_(false), functional_(false), testing_(false)
 {
     selfTest();
@@ -92,6 +147,9 @@ ProcessMonitor::~ProcessMonitor()
 
 void ProcessMonitor::setApps(const std::vector<std::string> &apps)
 {
+    std::lock_guard<std::mutex> guard(mutex_);
+    exeCache_.clear();
+
     if (isEnabled_) {
         for (auto app : apps) {
             if (std::find(apps_.begin(), apps_.end(), app) == apps_.end()) {
@@ -132,6 +190,7 @@ bool ProcessMonitor::enable()
         return false;
     }
 
+    std::lock_guard<std::mutex> guard(mutex_);
     for (auto app : apps_) {
         addApp(app);
     }
@@ -149,6 +208,8 @@ void ProcessMonitor::disable()
 
     stopMonitoring();
 
+    std::lock_guard<std::mutex> guard(mutex_);
+    pids_.clear();
     isEnabled_ = false;
 }
 
@@ -156,6 +217,7 @@ void ProcessMonitor::addApp(const std::string &exe) {
     spdlog::info("process monitor add app: {}", exe);
     std::vector<pid_t> pids = findPids(exe);
     for (auto pid : pids) {
+        pids_.insert(pid);
         CGroups::instance().addApp(pid);
     }
 }
@@ -164,6 +226,7 @@ void ProcessMonitor::removeApp(const std::string &exe) {
     spdlog::info("process monitor remove app: {}", exe);
     std::vector<pid_t> pids = findPids(exe);
     for (auto pid : pids) {
+        pids_.erase(pid);
         CGroups::instance().removeApp(pid);
     }
 }
@@ -195,7 +258,13 @@ std::vector<pid_t> ProcessMonitor::findPids(const std::string &exe)
 }
 
 bool ProcessMonitor::compareCmd(pid_t pid, const std::vector<std::string> &exes) {
-    std::string cmd = getCmdByPid(pid);
+    return compareCmd(getCmdByPid(pid), exes);
+}
+
+bool ProcessMonitor::compareCmd(const std::string &cmd, const std::vector<std::string> &exes) {
+    if (cmd.empty()) {
+        return false;
+    }
 
     for (auto exe : exes) {
         if (cmd == exe) {
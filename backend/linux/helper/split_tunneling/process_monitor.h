@@ -1,6 +1,10 @@
 #pragma once
 
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <sys/types.h>
 #include <thread>
 #include <vector>
 
@@ -20,6 +24,14 @@ public:
 private:
     bool isEnabled_;
     std::vector<std::string> apps_;
+    // Processes moved into the cgroup by us or forked by them. Only the events of these processes and exec events
+    // need to be looked at, the helper gets the events of every process in the system.
+    std::set<pid_t> pids_;
+    // Whether an executable (device, inode) is one of apps_, so every exec of it is not matched against all the apps
+    std::map<std::pair<dev_t, ino_t>, bool> exeCache_;
+    static constexpr size_t kMaxExeCacheSize = 1024;
+    // guards apps_, pids_ and exeCache_, which are used from the monitor thread as well
+    std::mutex mutex_;
     std::thread *thread_;
     int sock_;
     bool running_;
@@ -40,6 +52,11 @@ private:
     bool startMonitoring();
     void stopMonitoring();
     void monitorWorker(void *ctx);
+    void onFork(pid_t parentPid, pid_t childPid);
+    void onExec(pid_t pid);
+    void onExit(pid_t pid);
+    bool isApp(pid_t pid);
     bool compareCmd(pid_t pid, const std::vector<std::string> &exes);
+    static bool compareCmd(const std::string &cmd, const std::vector<std::string> &exes);
 };
 
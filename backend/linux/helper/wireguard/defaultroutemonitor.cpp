@@ -1,4 +1,5 @@
 #include "defaultroutemonitor.h"
+#include "../netlink_routes.h"
 #include "../utils.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/classification.hpp>
@@ -101,6 +102,13 @@ bool DefaultRouteMonitor::executeCommandWithLogging(const std::string &command)
 
 std::string DefaultRouteMonitor::getDefaultGateway() const
 {
+    std::string gateway;
+    if (NetlinkRoutes::getDefaultGateway(gateway)) {
+        if (gateway.empty())
+            spdlog::warn("Failed to get default gateway (no default route)");
+        return gateway;
+    }
+
     std::string output;
     const auto status = Utils::executeCommand(
         "ip route | grep 'default' | awk '{print $3}'", {}, &output);
@@ -119,6 +127,9 @@ bool DefaultRouteMonitor::setEndpointDirectRoute()
 {
     if (endpoint_.empty() || lastGateway_.empty())
         return false;
+    int failures = 0;
+    if (NetlinkRoutes::apply({}, {{endpoint_ + "/32", lastGateway_, ""}}, &failures))
+        return failures == 0;
     if (!executeCommandWithLogging(
         "ip route add " + endpoint_ + "/32 via " + lastGateway_))
         return false;
@@ -129,5 +140,7 @@ void DefaultRouteMonitor::unsetEndpointDirectRoute()
 {
     if (endpoint_.empty())
         return;
+    if (NetlinkRoutes::apply({{endpoint_ + "/32", "", ""}}, {}))
+        return;
     executeCommandWithLogging("ip route del " + endpoint_);
 }
@@ -7,6 +7,11 @@
 #include <sys/socket.h>
 #include <spdlog/spdlog.h>
 
+KernelModuleCommunicator::~KernelModuleCommunicator()
+{
+    wg_socket_close(socket_);
+}
+
 bool KernelModuleCommunicator::start(const std::string &deviceName)
 {
     assert(!deviceName.empty());
@@ -26,6 +31,8 @@ bool KernelModuleCommunicator::stop()
     Utils::executeCommand("nmcli", {"con", "down", deviceName_.c_str()});
 #endif
 
+    wg_socket_close(socket_);
+    socket_ = nullptr;
     wg_del_device(deviceName_.c_str());
     return true;
 }
@@ -208,9 +215,16 @@ unsigned long KernelModuleCommunicator::getStatus(unsigned int *errorCode,
 {
     UNUSED(errorCode);
 
+    if (!socket_)
+        socket_ = wg_socket_open();
+
     wg_device *device = nullptr;
-    if (wg_get_device(&device, deviceName_.c_str()) < 0)
+    if (!socket_ || wg_get_device_with_socket(socket_, &device, deviceName_.c_str()) < 0) {
+        // a new socket on the next request
+        wg_socket_close(socket_);
+        socket_ = nullptr;
         return kWgStateListening;
+    }
 
     if (device->first_peer != nullptr && device->first_peer->last_handshake_time.tv_sec > 0)
     {
@@ -219,6 +233,7 @@ unsigned long KernelModuleCommunicator::getStatus(unsigned int *errorCode,
         if (rc || tv.tv_sec - device->first_peer->last_handshake_time.tv_sec > 180)
         {
             spdlog::info("Time since last handshake time exceeded 3 minutes, disconnecting");
+            wg_free_device(device);
             return kWgStateError;
         }
         *bytesReceived = device->first_peer->rx_bytes;
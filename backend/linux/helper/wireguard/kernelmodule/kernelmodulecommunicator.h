@@ -11,6 +11,7 @@ class KernelModuleCommunicator: public IWireGuardCommunicator
 {
 public:
     KernelModuleCommunicator() = default;
+    ~KernelModuleCommunicator();
 
     virtual bool start(const std::string &deviceName);
     virtual bool stop();
@@ -32,4 +33,6 @@ private:
     bool setPeerEndpoint(wg_peer *peer, const std::string &endpoint);
     void freeAllowedIps(wg_allowedip *ips);
     std::string deviceName_;
+    // kept open between the status requests
+    wg_socket *socket_ = nullptr;
 };
@@ -1455,6 +1455,49 @@ out:
     return ret;
 }
 
+wg_socket *wg_socket_open(void)
+{
+    return mnlg_socket_open(WG_GENL_NAME, WG_GENL_VERSION);
+}
+
+void wg_socket_close(wg_socket *sock)
+{
+    if (sock)
+        mnlg_socket_close(sock);
+}
+
+int wg_get_device_with_socket(wg_socket *nlg, wg_device **device, const char *device_name)
+{
+    int ret = 0;
+    struct nlmsghdr *nlh;
+
+    *device = calloc(1, sizeof(wg_device));
+    if (!*device)
+        return -errno;
+
+    nlh = mnlg_msg_prepare(nlg, WG_CMD_GET_DEVICE, NLM_F_REQUEST | NLM_F_ACK | NLM_F_DUMP);
+    mnl_attr_put_strz(nlh, WGDEVICE_A_IFNAME, device_name);
+    if (mnlg_socket_send(nlg, nlh) < 0) {
+        ret = -errno;
+        goto out;
+    }
+    errno = 0;
+    if (mnlg_socket_recv_run(nlg, read_device_cb, *device) < 0) {
+        ret = errno ? -errno : -EINVAL;
+        goto out;
+    }
+    coalesce_peers(*device);
+
+out:
+    if (ret) {
+        /* the rest of the reply may still be in the socket, so it is not retried here */
+        wg_free_device(*device);
+        *device = NULL;
+    }
+    errno = -ret;
+    return ret;
+}
+
 /* first\0second\0third\0forth\0last\0\0 */
 char *wg_list_device_names(void)
 {
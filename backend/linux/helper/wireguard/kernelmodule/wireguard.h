@@ -95,6 +95,12 @@ typedef struct wg_device {
 
 int wg_set_device(wg_device *dev);
 int wg_get_device(wg_device **dev, const char *device_name);
+/* A generic netlink socket for repeated wg_get_device_with_socket() calls, saves the socket setup and the family lookup of every call.
+ * Close it and open a new one after a failed call. */
+typedef struct mnlg_socket wg_socket;
+wg_socket *wg_socket_open(void);
+void wg_socket_close(wg_socket *sock);
+int wg_get_device_with_socket(wg_socket *sock, wg_device **dev, const char *device_name);
 int wg_add_device(const char *device_name);
 int wg_del_device(const char *device_name);
 void wg_free_device(wg_device *dev);
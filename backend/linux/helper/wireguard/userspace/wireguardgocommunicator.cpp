@@ -4,7 +4,6 @@
 #include "../../execute_cmd.h"
 #include "../../utils.h"
 #include <codecvt>
-#include <regex>
 #include <type_traits>
 #include <boost/algorithm/string/trim.hpp>
 #include <sys/socket.h>
@@ -62,45 +61,64 @@ WireGuardGoCommunicator::Connection::Connection(const std::string &deviceName)
 
 WireGuardGoCommunicator::Connection::~Connection()
 {
+    // fclose() closes the socket as well
     if (fileHandle_)
         fclose(fileHandle_);
-    if (socketHandle_ >= 0)
+    else if (socketHandle_ >= 0)
         close(socketHandle_);
 }
 
 bool WireGuardGoCommunicator::Connection::getOutput(ResultMap *results_map) const
 {
-    if (!fileHandle_)
+    if (socketHandle_ < 0)
         return false;
+
+    // The reply is a list of key=value lines terminated by an empty line. The requests are written with fflush()
+    // or sendRequest(), so nothing is buffered in the FILE and the reply is read from the socket in chunks.
     std::string output;
     output.reserve(1024);
-    char prev = 0, c = 0;
-    for (;;) {
-        c = static_cast<char>(fgetc(fileHandle_));
-        if ((c == '\n' && prev == '\n') || feof(fileHandle_) || ferror(fileHandle_)) {
+    char buf[1024];
+    while (output.find("\n\n") == std::string::npos) {
+        const auto len = read(socketHandle_, buf, sizeof(buf));
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len <= 0)
             break;
-        }
-        prev = c;
-        output.push_back(c);
+        output.append(buf, len);
     }
+    const auto end = output.find("\n\n");
+    if (end != std::string::npos)
+        output.resize(end + 1);
     boost::trim(output);
     if (output.empty())
         return false;
+
+    // one pass over the lines, the last value of a key wins
     if (results_map && !results_map->empty()) {
-        std::regex output_rx("(^|\n)(\\w+)=(\\w+)(?=\n|$)");
-        std::sregex_iterator it(output.begin(), output.end(), output_rx), end;
-        for (; it != end; ++it) {
-            if (it->size() != 4)
-                continue;
-            const auto &match = *it;
-            auto mapitem = results_map->find(match[2].str());
-            if (mapitem != results_map->end())
-                mapitem->second = match[3].str();
+        size_t pos = 0;
+        while (pos < output.size()) {
+            size_t eol = output.find('\n', pos);
+            if (eol == std::string::npos)
+                eol = output.size();
+            const size_t eq = output.find('=', pos);
+            if (eq != std::string::npos && eq < eol) {
+                auto mapitem = results_map->find(output.substr(pos, eq - pos));
+                if (mapitem != results_map->end())
+                    mapitem->second = output.substr(eq + 1, eol - eq - 1);
+            }
+            pos = eol + 1;
         }
     }
     return true;
 }
 
+bool WireGuardGoCommunicator::Connection::sendRequest(const std::string &request) const
+{
+    if (socketHandle_ < 0)
+        return false;
+    return send(socketHandle_, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size());
+}
+
 bool WireGuardGoCommunicator::Connection::connect(struct sockaddr_un *address)
 {
     struct stat sbuf;
@@ -159,6 +177,7 @@ bool WireGuardGoCommunicator::start(const std::string &deviceName)
         return false;
     }
 
+    statusConnection_.reset();
     daemonCmdId_ = ExecuteCmd::instance().execute(fullCmd);
     deviceName_ = deviceName;
     executable_ = "windscribewireguard";
@@ -167,6 +186,7 @@ bool WireGuardGoCommunicator::start(const std::string &deviceName)
 
 bool WireGuardGoCommunicator::stop()
 {
+    statusConnection_.reset();
     if (!deviceName_.empty()) {
         Utils::executeCommand("rm", {"-f", ("/var/run/wireguard/" + deviceName_ + ".sock").c_str()});
     }
@@ -236,23 +256,29 @@ unsigned long WireGuardGoCommunicator::getStatus(unsigned int *errorCode,
     ExecuteCmd::instance().getStatus(daemonCmdId_, is_daemon_dead, log);
     if (is_daemon_dead) {
         // Special error code means the daemon is dead.
+        statusConnection_.reset();
         *errorCode = 666u;
         return kWgStateError;
     }
 
-    Connection connection(deviceName_);
-    const auto connection_status = connection.getStatus();
+    if (!statusConnection_)
+        statusConnection_ = std::make_unique<Connection>(deviceName_);
+    const auto connection_status = statusConnection_->getStatus();
     if (connection_status != Connection::Status::OK) {
-        if (connection.getStatus() == Connection::Status::NO_SOCKET)
+        statusConnection_.reset();
+        if (connection_status == Connection::Status::NO_SOCKET)
             return kWgStateStarting;
         if (errorCode)
             *errorCode = static_cast<unsigned int>(errno);
         return kWgStateError;
     }
+    Connection &connection = *statusConnection_;
 
     // Send get command.
-    fputs("get=1\n\n", connection);
-    fflush(connection);
+    if (!connection.sendRequest("get=1\n\n")) {
+        statusConnection_.reset();
+        return kWgStateStarting;
+    }
 
     Connection::ResultMap results{
         std::make_pair("errno", ""),
@@ -263,8 +289,11 @@ unsigned long WireGuardGoCommunicator::getStatus(unsigned int *errorCode,
         std::make_pair("last_handshake_time_sec", "")
     };
     bool success = connection.getOutput(&results);
-    if (!success)
+    if (!success) {
+        // reconnect on the next request
+        statusConnection_.reset();
         return kWgStateStarting;
+    }
 
     // Check for errors.
     const auto errno_value = stringToValue<unsigned int>(results["errno"]);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -36,6 +37,8 @@ private:
         explicit Connection(const std::string &deviceName);
         ~Connection();
         bool getOutput(ResultMap *results_map) const;
+        // writes the request directly to the socket, a closed socket fails the write instead of raising SIGPIPE
+        bool sendRequest(const std::string &request) const;
         Status getStatus() const { return status_; }
         operator FILE*() const { return fileHandle_; }
     private:
@@ -51,4 +54,7 @@ private:
     std::string deviceName_;
     std::string executable_;
     unsigned long daemonCmdId_;
+    // The UAPI connection of the status requests. It is kept open while the daemon runs,
+    // the status is requested often and the daemon serves any number of requests per connection.
+    std::unique_ptr<Connection> statusConnection_;
 };
@@ -44,6 +44,8 @@
 #define HELPER_CMD_HELPER_VERSION                    36
 #define HELPER_CMD_GET_INTERFACE_SSID                37
 #define HELPER_CMD_RESET_MAC_ADDRESSES               38 // Linux only
+#define HELPER_CMD_START_SESSION                     39 // Linux only, switches the connection to the binary encoding
+#define HELPER_CMD_SET_FIREWALL_ALLOW_IPS            40 // Linux only
 
 // enums
 
@@ -280,3 +282,7 @@ struct CMD_RESET_MAC_ADDRESSES {
     std::string ignoreNetwork;
 };
 
+struct CMD_SET_FIREWALL_ALLOW_IPS {
+    std::vector<std::string> ips;
+};
+
@@ -287,5 +287,12 @@ void serialize(Archive &ar, CMD_RESET_MAC_ADDRESSES &a, const unsigned int versi
     ar & a.ignoreNetwork;
 }
 
+template<class Archive>
+void serialize(Archive &ar, CMD_SET_FIREWALL_ALLOW_IPS &a, const unsigned int version)
+{
+    UNUSED(version);
+    ar & a.ips;
+}
+
 }
 }
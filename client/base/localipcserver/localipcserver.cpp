@@ -68,9 +68,9 @@ void LocalIPCServer::onServerCallbackAcceptFunction(IPC::Connection *connection)
     connect(connection, &IPC::Connection::stateChanged, this, &LocalIPCServer::onConnectionStateCallback);
 }
 
-void LocalIPCServer::onConnectionCommandCallback(IPC::Command *command, IPC::Connection * /*connection*/)
+void LocalIPCServer::onConnectionCommandCallback(IPC::Command *command, IPC::Connection *connection)
 {
-    if (command->getStringId() ==IPC::CliCommands::ShowLocations::getCommandStringId()) {
+    if (command->getId() == IPC::CliCommands::ShowLocations::kId) {
         IPC::CliCommands::ShowLocations *cmd = static_cast<IPC::CliCommands::ShowLocations *>(command);
         emit showLocations(cmd->locationType_);
 #ifdef CLI_ONLY
@@ -78,10 +78,22 @@ void LocalIPCServer::onConnectionCommandCallback(IPC::Command *command, IPC::Con
         // the list of locations to return via sendLocations().
         return;
 #endif
-    } else if (command->getStringId() == IPC::CliCommands::GetState::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::GetState::kId) {
+        IPC::CliCommands::GetState *cmd = static_cast<IPC::CliCommands::GetState *>(command);
+        if (cmd->protocolVersion_ >= IPC::PROTOCOL_VERSION_2) {
+            connection->setProtocolVersion(IPC::PROTOCOL_VERSION_2);
+        }
         sendState();
         return;
-    } else if (command->getStringId() == IPC::CliCommands::Connect::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::SubscribeState::kId) {
+        if (!stateSubscribers_.contains(connection)) {
+            stateSubscribers_.append(connection);
+        }
+        IPC::CliCommands::State cmd;
+        fillState(cmd);
+        connection->sendCommand(cmd);
+        return;
+    } else if (command->getId() == IPC::CliCommands::Connect::kId) {
         IPC::CliCommands::Connect *cmd = static_cast<IPC::CliCommands::Connect *>(command);
         IPC::CliCommands::LocationType type = cmd->locationType_;
         QString locationStr = cmd->location_;
@@ -106,30 +118,30 @@ void LocalIPCServer::onConnectionCommandCallback(IPC::Command *command, IPC::Con
                 emit connectToLocation(lid, protocol);
             }
         }
-    } else if (command->getStringId() == IPC::CliCommands::Disconnect::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::Disconnect::kId) {
         if (!backend_->isDisconnected()) {
             backend_->sendDisconnect();
         }
-    } else if (command->getStringId() == IPC::CliCommands::Firewall::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::Firewall::kId) {
         IPC::CliCommands::Firewall *cmd = static_cast<IPC::CliCommands::Firewall *>(command);
         if (cmd->isEnable_ && !backend_->isFirewallEnabled()) {
             backend_->firewallOn();
         } else if (!cmd->isEnable_ && backend_->isFirewallEnabled() && !backend_->isFirewallAlwaysOn()) {
             backend_->firewallOff();
         }
-    } else if (command->getStringId() == IPC::CliCommands::Login::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::Login::kId) {
         if (backend_->currentLoginState() == LOGIN_STATE_LOGGED_OUT || backend_->currentLoginState() == LOGIN_STATE_LOGIN_ERROR) {
             IPC::CliCommands::Login *cmd = static_cast<IPC::CliCommands::Login *>(command);
             emit attemptLogin(cmd->username_, cmd->password_, cmd->code2fa_);
         }
-    } else if (command->getStringId() == IPC::CliCommands::Logout::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::Logout::kId) {
         if (backend_->currentLoginState() != LOGIN_STATE_LOGGED_OUT) {
             IPC::CliCommands::Logout *cmd = static_cast<IPC::CliCommands::Logout *>(command);
             backend_->logout(cmd->isKeepFirewallOn_);
         }
-    } else if (command->getStringId() == IPC::CliCommands::SendLogs::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::SendLogs::kId) {
         backend_->sendDebugLog();
-    } else if (command->getStringId() == IPC::CliCommands::Update::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::Update::kId) {
         if (!updateAvailable_.isEmpty()) {
 #ifdef CLI_ONLY
             backend_->sendUpdateVersion(0);
@@ -137,9 +149,9 @@ void LocalIPCServer::onConnectionCommandCallback(IPC::Command *command, IPC::Con
             emit update();
 #endif
         }
-    } else if (command->getStringId() == IPC::CliCommands::ReloadConfig::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::ReloadConfig::kId) {
         backend_->getPreferences()->loadIni();
-    } else if (command->getStringId() == IPC::CliCommands::SetKeyLimitBehavior::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::SetKeyLimitBehavior::kId) {
         IPC::CliCommands::SetKeyLimitBehavior *cmd = static_cast<IPC::CliCommands::SetKeyLimitBehavior *>(command);
         emit setKeyLimitBehavior(cmd->keyLimitDelete_);
     }
@@ -152,11 +164,13 @@ void LocalIPCServer::onConnectionStateCallback(int state, IPC::Connection *conne
 {
     if (state == IPC::CONNECTION_DISCONNECTED) {
         connections_.removeOne(connection);
+        stateSubscribers_.removeOne(connection);
         connection->close();
         delete connection;
     } else if (state == IPC::CONNECTION_ERROR) {
         qCWarning(LOG_BASIC) << "CLI disconnected from server with error";
         connections_.removeOne(connection);
+        stateSubscribers_.removeOne(connection);
         connection->close();
         delete connection;
     }
@@ -165,17 +179,20 @@ void LocalIPCServer::onConnectionStateCallback(int state, IPC::Connection *conne
 void LocalIPCServer::onBackendLoginFinished(bool /*isLoginFromSavedSettings*/)
 {
     loginState_ = LOGIN_STATE_LOGGED_IN;
+    pushState();
 }
 
 void LocalIPCServer::onBackendLoginError(wsnet::LoginResult code, const QString &msg)
 {
     lastLoginError_ = code;
     lastLoginErrorMessage_ = msg;
+    pushState();
 }
 
 void LocalIPCServer::onBackendLogoutFinished()
 {
     loginState_ = LOGIN_STATE_LOGGED_OUT;
+    pushState();
 }
 
 void LocalIPCServer::sendCommand(const IPC::Command &command)
@@ -185,9 +202,8 @@ void LocalIPCServer::sendCommand(const IPC::Command &command)
     }
 }
 
-void LocalIPCServer::sendState()
+void LocalIPCServer::fillState(IPC::CliCommands::State &cmd)
 {
-    IPC::CliCommands::State cmd;
     cmd.language_ = backend_->getPreferences()->language();
     cmd.connectivity_ = connectivity_;
     cmd.loginState_ = backend_->currentLoginState();
@@ -208,9 +224,32 @@ void LocalIPCServer::sendState()
     cmd.updateAvailable_ = updateAvailable_;
     cmd.trafficUsed_ = backend_->getAccountInfo()->trafficUsed();
     cmd.trafficMax_ = backend_->getAccountInfo()->plan();
+}
+
+void LocalIPCServer::sendState()
+{
+    IPC::CliCommands::State cmd;
+    fillState(cmd);
     sendCommand(cmd);
 }
 
+void LocalIPCServer::pushState()
+{
+    if (stateSubscribers_.isEmpty()) {
+        return;
+    }
+
+    IPC::CliCommands::State cmd;
+    fillState(cmd);
+    // a failed write deletes the connection, iterate over a copy and skip the removed ones
+    const QVector<IPC::Connection *> subscribers = stateSubscribers_;
+    for (IPC::Connection *connection : subscribers) {
+        if (stateSubscribers_.contains(connection)) {
+            connection->sendCommand(cmd);
+        }
+    }
+}
+
 void LocalIPCServer::onBackendCheckUpdateChanged(const api_responses::CheckUpdate &info)
 {
     if (info.isAvailable()) {
@@ -230,22 +269,26 @@ void LocalIPCServer::onBackendConnectStateChanged(const types::ConnectState &sta
         connectState_.disconnectReason = DISCONNECTED_BY_KEY_LIMIT;
         disconnectedByKeyLimit_ = false;
     }
+    pushState();
 }
 
 void LocalIPCServer::onBackendProtocolPortChanged(const types::Protocol &protocol, uint port)
 {
     protocol_ = protocol;
     port_ = port;
+    pushState();
 }
 
 void LocalIPCServer::onBackendInternetConnectivityChanged(bool connectivity)
 {
     connectivity_ = connectivity;
+    pushState();
 }
 
 void LocalIPCServer::onBackendTestTunnelResult(bool success)
 {
     tunnelTestState_ = success ? TUNNEL_TEST_STATE_SUCCESS : TUNNEL_TEST_STATE_FAILURE;
+    pushState();
 }
 
 void LocalIPCServer::onBackendUpdateVersionChanged(uint progressPercent, UPDATE_VERSION_STATE state, UPDATE_VERSION_ERROR error)
@@ -259,11 +302,13 @@ void LocalIPCServer::onBackendUpdateVersionChanged(uint progressPercent, UPDATE_
     } else if (state == UPDATE_VERSION_STATE_RUNNING) {
         updateProgress_ = 100;
     }
+    pushState();
 }
 
 void LocalIPCServer::onBackendUpdateDownloaded(const QString &path)
 {
     updatePath_ = path;
+    pushState();
 }
 
 void LocalIPCServer::setDisconnectedByKeyLimit()
@@ -274,6 +319,7 @@ void LocalIPCServer::setDisconnectedByKeyLimit()
 void LocalIPCServer::onBackendConnectionIdChanged(const QString &connId)
 {
     connectId_ = connId;
+    pushState();
 }
 
 void LocalIPCServer::onLocationsModelManagerDeviceNameChanged(const QString &deviceName)
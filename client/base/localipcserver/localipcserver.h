@@ -53,6 +53,7 @@ private:
     Backend *backend_;
     IPC::Server *server_ = nullptr;
     QVector<IPC::Connection *> connections_;
+    QVector<IPC::Connection *> stateSubscribers_;     // get State on every change, see CliCommands::SubscribeState
 
     bool connectivity_;
     LOGIN_STATE loginState_;
@@ -72,6 +73,8 @@ private:
     bool tunnelTestSuccess_;
     QString deviceName_;
 
+    void fillState(IPC::CliCommands::State &cmd);
     void sendState();
+    void pushState();
     void sendCommand(const IPC::Command &command);
 };
@@ -22,25 +22,24 @@ public:
     Acknowledge() {}
     explicit Acknowledge(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> code_ >> message_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << code_ << message_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::Acknowledge debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::Acknowledge";  }
+    static constexpr CommandId kId = CommandId::kAcknowledge;
 
     int code_;
     QString message_;
@@ -52,25 +51,24 @@ public:
     Connect() {}
     explicit Connect(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> locationType_ >> location_ >> protocol_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << locationType_ << location_ << protocol_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::Connect debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::Connect";  }
+    static constexpr CommandId kId = CommandId::kConnect;
 
     QString location_;
     QString protocol_;
@@ -87,17 +85,19 @@ public:
         Q_UNUSED(size)
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::Disconnect debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::Disconnect";  }
+    static constexpr CommandId kId = CommandId::kDisconnect;
 };
 
 class ShowLocations : public Command
@@ -106,25 +106,24 @@ public:
     ShowLocations() {}
     explicit ShowLocations(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> locationType_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << locationType_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::ShowLocations debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::ShowLocations";  }
+    static constexpr CommandId kId = CommandId::kShowLocations;
 
     LocationType locationType_;
 };
@@ -135,25 +134,24 @@ public:
     LocationsList() {}
     explicit LocationsList(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> locations_ >> deviceName_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << locations_ << deviceName_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::LocationsList debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::LocationsList";  }
+    static constexpr CommandId kId = CommandId::kLocationsList;
 
     QStringList locations_;
     QString deviceName_;
@@ -165,25 +163,24 @@ public:
     Firewall() {}
     explicit Firewall(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> isEnable_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << isEnable_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::Firewall debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::Firewall";  }
+    static constexpr CommandId kId = CommandId::kFirewall;
 
     bool isEnable_ = false;
 };
@@ -194,21 +191,57 @@ public:
     GetState() {}
     explicit GetState(char *buf, int size)
     {
-        Q_UNUSED(buf)
-        Q_UNUSED(size)
+        // the CLIs before the binary frames send an empty body, the old apps ignore the body
+        if (size > 0) {
+            QByteArray arr = QByteArray::fromRawData(buf, size);
+            QDataStream ds(&arr, QIODevice::ReadOnly);
+            ds >> protocolVersion_;
+        }
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        ds << protocolVersion_;
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::GetState debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::GetState";  }
+    static constexpr CommandId kId = CommandId::kGetState;
+
+    // the highest IPC protocol version supported by the sender, the app replies in this version
+    qint32 protocolVersion_ = PROTOCOL_VERSION_LEGACY;
+};
+
+// The app replies with the current State and then sends State to the connection every time it changes.
+// Not known to the apps before the binary frames, send only when the connection uses PROTOCOL_VERSION_2.
+class SubscribeState : public Command
+{
+public:
+    SubscribeState() {}
+    explicit SubscribeState(char *buf, int size)
+    {
+        Q_UNUSED(buf)
+        Q_UNUSED(size)
+    }
+
+    void writeData(QDataStream &ds) const override
+    {
+        Q_UNUSED(ds)
+    }
+
+    CommandId getId() const override { return kId; }
+    std::string getStringId() const override { return getCommandStringId(); }
+    std::string getDebugString() const override
+    {
+        return "CliCommands::SubscribeState debug string";
+    }
+    static std::string getCommandStringId() { return "CliCommands::SubscribeState";  }
+    static constexpr CommandId kId = CommandId::kSubscribeState;
 };
 
 class Login : public Command
@@ -217,25 +250,24 @@ public:
     Login() {}
     explicit Login(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> username_ >> password_ >> code2fa_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << username_ << password_ << code2fa_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::Login debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::Login";  }
+    static constexpr CommandId kId = CommandId::kLogin;
 
     QString username_;
     QString password_;
@@ -248,25 +280,24 @@ public:
     Logout() {}
     explicit Logout(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> isKeepFirewallOn_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << isKeepFirewallOn_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::Logout debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::Logout";  }
+    static constexpr CommandId kId = CommandId::kLogout;
 
     bool isKeepFirewallOn_;
 };
@@ -281,17 +312,19 @@ public:
         Q_UNUSED(size);
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::SendLogs debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::SendLogs";  }
+    static constexpr CommandId kId = CommandId::kSendLogs;
 };
 
 class State : public Command
@@ -300,7 +333,7 @@ public:
     State() {}
     explicit State(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> language_ >> connectivity_ >> loginState_ >> loginError_ >> loginErrorMessage_
            >> connectState_ >> connectId_ >> protocol_ >> port_ >> tunnelTestState_ >> location_
@@ -309,24 +342,23 @@ public:
            >> trafficUsed_ >> trafficMax_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << language_ << connectivity_ << loginState_ << loginError_ << loginErrorMessage_
            << connectState_ << connectId_ << protocol_ << port_ << tunnelTestState_ << location_
            << isFirewallOn_ << isFirewallAlwaysOn_
            << updateState_ << updateError_ << updateProgress_ << updatePath_ << updateAvailable_
            << trafficUsed_ << trafficMax_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::State debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::State";  }
+    static constexpr CommandId kId = CommandId::kState;
 
     QString language_;
     bool connectivity_;
@@ -360,17 +392,19 @@ public:
         Q_UNUSED(size);
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::Update debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::Update";  }
+    static constexpr CommandId kId = CommandId::kUpdate;
 };
 
 class ReloadConfig : public Command
@@ -383,17 +417,19 @@ public:
         Q_UNUSED(size);
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        return std::vector<char>();
+        Q_UNUSED(ds)
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::ReloadConfig debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::ReloadConfig";  }
+    static constexpr CommandId kId = CommandId::kReloadConfig;
 };
 
 class SetKeyLimitBehavior: public Command
@@ -402,25 +438,24 @@ public:
     SetKeyLimitBehavior() {}
     explicit SetKeyLimitBehavior(char *buf, int size)
     {
-        QByteArray arr(buf, size);
+        QByteArray arr = QByteArray::fromRawData(buf, size);
         QDataStream ds(&arr, QIODevice::ReadOnly);
         ds >> keyLimitDelete_;
     }
 
-    std::vector<char> getData() const override
+    void writeData(QDataStream &ds) const override
     {
-        QByteArray arr;
-        QDataStream ds(&arr, QIODevice::WriteOnly);
         ds << keyLimitDelete_;
-        return std::vector<char>(arr.begin(), arr.end());
     }
 
+    CommandId getId() const override { return kId; }
     std::string getStringId() const override { return getCommandStringId(); }
     std::string getDebugString() const override
     {
         return "CliCommands::SetKeyLimitBehavior debug string";
     }
     static std::string getCommandStringId() { return "CliCommands::SetKeyLimitBehavior";  }
+    static constexpr CommandId kId = CommandId::kSetKeyLimitBehavior;
 
     bool keyLimitDelete_;
 };
@@ -1,20 +1,53 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
+class QDataStream;
+
 namespace IPC
 {
 
+// the frames with the string command ids, the only format understood by the old CLIs and apps
+static const int PROTOCOL_VERSION_LEGACY = 1;
+// the binary frames with the integer command ids
+static const int PROTOCOL_VERSION_2 = 2;
+
+// Ids of the commands in the binary frames. The values are a part of the wire format, do not renumber or reuse them.
+enum class CommandId : std::uint16_t {
+    kAcknowledge = 1,
+    kConnect = 2,
+    kDisconnect = 3,
+    kShowLocations = 4,
+    kLocationsList = 5,
+    kFirewall = 6,
+    kGetState = 7,
+    kLogin = 8,
+    kLogout = 9,
+    kSendLogs = 10,
+    kState = 11,
+    kUpdate = 12,
+    kReloadConfig = 13,
+    kSetKeyLimitBehavior = 14,
+    kSubscribeState = 15,
+
+    kCount
+};
+
 // base class for all commands
 class Command
 {
 public:
     virtual ~Command() {}
 
-    virtual std::vector<char> getData() const = 0;
+    // serialize the body of the command to the stream
+    virtual void writeData(QDataStream &ds) const = 0;
+
+    // return unique integer ID for command
+    virtual CommandId getId() const = 0;
 
-    // return unique static string ID for command
+    // return unique static string ID for command, used in the legacy frames
     virtual std::string getStringId() const = 0;
 
     // return debug string of command
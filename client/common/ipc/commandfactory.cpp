@@ -1,6 +1,9 @@
 #include <QObject>
 #include <QDebug>
 
+#include <array>
+#include <unordered_map>
+
 #include "commandfactory.h"
 #include "clicommands.h"
 #include "utils/ws_assert.h"
@@ -8,46 +11,85 @@
 namespace IPC
 {
 
-Command *CommandFactory::makeCommand(const std::string strId, char *buf, int size)
+namespace {
+
+typedef Command *(*MakeCommandFunc)(char *buf, int size);
+
+template<typename T>
+Command *makeCommandOfType(char *buf, int size)
+{
+    return new T(buf, size);
+}
+
+// The dispatch tables, the integer ids index an array, the legacy string ids are hashed
+class CommandTable
 {
-    // Too much spam from GetState command
-    if (strId != IPC::CliCommands::GetState::getCommandStringId()) {
-        //qDebug() << QString::fromStdString(strId);
+public:
+    CommandTable()
+    {
+        // CLI commands
+        add<CliCommands::Acknowledge>();
+        add<CliCommands::Connect>();
+        add<CliCommands::Disconnect>();
+        add<CliCommands::ShowLocations>();
+        add<CliCommands::LocationsList>();
+        add<CliCommands::GetState>();
+        add<CliCommands::SubscribeState>();
+        add<CliCommands::State>();
+        add<CliCommands::Firewall>();
+        add<CliCommands::Login>();
+        add<CliCommands::Logout>();
+        add<CliCommands::Update>();
+        add<CliCommands::SendLogs>();
+        add<CliCommands::ReloadConfig>();
+        add<CliCommands::SetKeyLimitBehavior>();
+    }
+
+    MakeCommandFunc find(CommandId id) const
+    {
+        const size_t ind = static_cast<size_t>(id);
+        return ind < byId_.size() ? byId_[ind] : nullptr;
     }
 
-    // CLI commands
-    if (strId == IPC::CliCommands::Acknowledge::getCommandStringId()) {
-        return new IPC::CliCommands::Acknowledge(buf, size);
-    } else if (strId == IPC::CliCommands::Connect::getCommandStringId()) {
-        return new IPC::CliCommands::Connect(buf, size);
-    } else if (strId == IPC::CliCommands::Disconnect::getCommandStringId()) {
-        return new IPC::CliCommands::Disconnect(buf, size);
-    } else if (strId == IPC::CliCommands::ShowLocations::getCommandStringId()) {
-        return new IPC::CliCommands::ShowLocations(buf, size);
-    } else if (strId == IPC::CliCommands::LocationsList::getCommandStringId()) {
-        return new IPC::CliCommands::LocationsList(buf, size);
-    } else if (strId == IPC::CliCommands::GetState::getCommandStringId()) {
-        return new IPC::CliCommands::GetState(buf, size);
-    } else if (strId == IPC::CliCommands::State::getCommandStringId()) {
-        return new IPC::CliCommands::State(buf, size);
-    } else if (strId == IPC::CliCommands::Firewall::getCommandStringId()) {
-        return new IPC::CliCommands::Firewall(buf, size);
-    } else if (strId == IPC::CliCommands::Login::getCommandStringId()) {
-        return new IPC::CliCommands::Login(buf, size);
-    } else if (strId == IPC::CliCommands::Logout::getCommandStringId()) {
-        return new IPC::CliCommands::Logout(buf, size);
-    } else if (strId == IPC::CliCommands::Update::getCommandStringId()) {
-        return new IPC::CliCommands::Update(buf, size);
-    } else if (strId == IPC::CliCommands::SendLogs::getCommandStringId()) {
-        return new IPC::CliCommands::SendLogs(buf, size);
-    } else if (strId == IPC::CliCommands::ReloadConfig::getCommandStringId()) {
-        return new IPC::CliCommands::ReloadConfig(buf, size);
-    } else if (strId == IPC::CliCommands::SetKeyLimitBehavior::getCommandStringId()) {
-        return new IPC::CliCommands::SetKeyLimitBehavior(buf, size);
+    MakeCommandFunc find(const std::string &strId) const
+    {
+        auto it = byStringId_.find(strId);
+        return it != byStringId_.end() ? it->second : nullptr;
     }
 
-    WS_ASSERT(false);
-    return NULL;
+private:
+    std::array<MakeCommandFunc, static_cast<size_t>(CommandId::kCount)> byId_ {};
+    std::unordered_map<std::string, MakeCommandFunc> byStringId_;
+
+    template<typename T>
+    void add()
+    {
+        WS_ASSERT(byId_[static_cast<size_t>(T::kId)] == nullptr);
+        byId_[static_cast<size_t>(T::kId)] = &makeCommandOfType<T>;
+        byStringId_[T::getCommandStringId()] = &makeCommandOfType<T>;
+    }
+};
+
+const CommandTable &commandTable()
+{
+    static const CommandTable table;
+    return table;
+}
+
+} // namespace
+
+Command *CommandFactory::makeCommand(CommandId id, char *buf, int size)
+{
+    MakeCommandFunc func = commandTable().find(id);
+    WS_ASSERT(func != nullptr);
+    return func ? func(buf, size) : NULL;
+}
+
+Command *CommandFactory::makeCommand(const std::string &strId, char *buf, int size)
+{
+    MakeCommandFunc func = commandTable().find(strId);
+    WS_ASSERT(func != nullptr);
+    return func ? func(buf, size) : NULL;
 }
 
 } // namespace IPC
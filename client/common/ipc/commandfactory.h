@@ -10,7 +10,9 @@ static const int CLIENT_CMD_ClientAuth = 0;
 class CommandFactory
 {
 public:
-    static Command *makeCommand(const std::string strId, char *buf, int size);
+    static Command *makeCommand(CommandId id, char *buf, int size);
+    // for the legacy frames
+    static Command *makeCommand(const std::string &strId, char *buf, int size);
 };
 
 } // namespace IPC
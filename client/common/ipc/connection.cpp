@@ -1,12 +1,15 @@
 #include "connection.h"
 #include "commandfactory.h"
+#include <QBuffer>
+#include <QDataStream>
 #include <QTimer>
 #include "utils/ws_assert.h"
 
 namespace IPC
 {
 
-Connection::Connection(QLocalSocket *localSocket) : localSocket_(localSocket), bytesWrittingInProgress_(0)
+Connection::Connection(QLocalSocket *localSocket) : localSocket_(localSocket), protocolVersion_(PROTOCOL_VERSION_LEGACY),
+    writeQueueOffset_(0), bytesWrittingInProgress_(0)
 {
     QObject::connect(localSocket_, &QLocalSocket::disconnected, this, &Connection::onSocketDisconnected);
     QObject::connect(localSocket_, &QLocalSocket::bytesWritten, this, &Connection::onSocketBytesWritten);
@@ -14,7 +17,7 @@ Connection::Connection(QLocalSocket *localSocket) : localSocket_(localSocket), b
     QObject::connect(localSocket_, &QLocalSocket::errorOccurred, this, &Connection::onSocketError);
 }
 
-Connection::Connection() : localSocket_(NULL), bytesWrittingInProgress_(0)
+Connection::Connection() : localSocket_(NULL), protocolVersion_(PROTOCOL_VERSION_LEGACY), writeQueueOffset_(0), bytesWrittingInProgress_(0)
 {
 }
 
@@ -26,6 +29,12 @@ Connection::~Connection()
 void Connection::connect()
 {
     safeDeleteSocket();
+    // the peer may be a different version of the app after a reconnect
+    protocolVersion_ = PROTOCOL_VERSION_LEGACY;
+    writeQueue_.clear();
+    writeQueueOffset_ = 0;
+    readBuf_.clear();
+    bytesWrittingInProgress_ = 0;
     localSocket_ = new QLocalSocket;
     QObject::connect(localSocket_, &QLocalSocket::connected, this, &Connection::onSocketConnected);
     QObject::connect(localSocket_, &QLocalSocket::disconnected, this, &Connection::onSocketDisconnected);
@@ -49,43 +58,41 @@ void Connection::sendCommand(const Command &commandl)
 {
     WS_ASSERT(localSocket_ != NULL);
 
-    // command structure
-    // 1) (int) size of protobuf message in bytes
-    // 2) (int) size of message string id in bytes
-    // 3) (string) message string id
-    // 4) (byte array) body of protobuf message
+    serializeCommand(commandl);
 
-    std::vector<char> buf = commandl.getData();
-    int sizeOfBuf = buf.size();
-    std::string strId = commandl.getStringId();
-    int sizeOfStringId = strId.length();
-
-    WS_ASSERT(sizeOfStringId > 0);
-
-    bool isWriteBufIsEmpty = writeBuf_.isEmpty();
+    if (!writeQueue_.empty())
+    {
+        // keep the order, the frame will be written after the queued ones
+        writeQueue_.push_back(QByteArray(outBuf_.constData(), outBuf_.size()));
+        return;
+    }
 
-    writeBuf_.append((const char *)&sizeOfBuf, sizeof(sizeOfBuf));
-    writeBuf_.append((const char *)&sizeOfStringId, sizeof(sizeOfStringId));
-    writeBuf_.append(strId.c_str(), sizeOfStringId);
-    if (sizeOfBuf > 0)
+    // write from the raw data, so the socket copies it and does not share the reused buffer
+    qint64 bytesWritten = localSocket_->write(outBuf_.constData(), outBuf_.size());
+    if (bytesWritten == -1)
     {
-        writeBuf_.append(&buf[0], sizeOfBuf);
+        emit stateChanged(CONNECTION_DISCONNECTED, this);
     }
-    if (isWriteBufIsEmpty)
+    else
     {
-        qint64 bytesWritten = localSocket_->write(writeBuf_);
-        if (bytesWritten == -1)
-        {
-            emit stateChanged(CONNECTION_DISCONNECTED, this);
-        }
-        else
+        bytesWrittingInProgress_ += bytesWritten;
+        if (bytesWritten < outBuf_.size())
         {
-            bytesWrittingInProgress_ += bytesWritten;
-            writeBuf_.remove(0, bytesWritten);
+            writeQueue_.push_back(QByteArray(outBuf_.constData() + bytesWritten, outBuf_.size() - bytesWritten));
         }
     }
 }
 
+void Connection::setProtocolVersion(int protocolVersion)
+{
+    protocolVersion_ = protocolVersion;
+}
+
+int Connection::protocolVersion() const
+{
+    return protocolVersion_;
+}
+
 void Connection::onSocketConnected()
 {
     emit stateChanged(CONNECTION_CONNECTED, this);
@@ -117,18 +124,12 @@ void Connection::onSocketBytesWritten(qint64 bytes)
 {
     bytesWrittingInProgress_ -= bytes;
 
-    if (!writeBuf_.isEmpty())
+    if (!writeQueue_.empty())
     {
-        qint64 bytesWritten = localSocket_->write(writeBuf_);
-        if (bytesWritten == -1)
+        if (!writeQueuedFrames())
         {
             emit stateChanged(CONNECTION_DISCONNECTED, this);
         }
-        else
-        {
-            bytesWrittingInProgress_ += bytesWritten;
-            writeBuf_.remove(0, bytesWritten);
-        }
     }
     else if (bytesWrittingInProgress_ == 0)
     {
@@ -139,10 +140,22 @@ void Connection::onSocketBytesWritten(qint64 bytes)
 void Connection::onReadyRead()
 {
     readBuf_.append(localSocket_->readAll());
-    while (canReadCommand())
+
+    // parse all the complete frames and remove them from the buffer at once
+    int offset = 0;
+    int frameSize;
+    while ((frameSize = completeFrameSize(offset)) > 0)
+    {
+        Command *cmd = readCommand(offset, frameSize);
+        offset += frameSize;
+        if (cmd)
+        {
+            emit newCommand(cmd, this);
+        }
+    }
+    if (offset > 0)
     {
-        Command *cmd = readCommand();
-        emit newCommand(cmd, this);
+        readBuf_.remove(0, offset);
     }
 }
 
@@ -157,35 +170,129 @@ void Connection::onSocketError(QLocalSocket::LocalSocketError socketError)
     }
 }
 
-bool Connection::canReadCommand()
+void Connection::serializeCommand(const Command &command)
 {
-    if (readBuf_.size() > (int)(sizeof(int) * 2))
+    std::string strId;
+    int headerSize = kFrameV2HeaderSize;
+    if (protocolVersion_ == PROTOCOL_VERSION_LEGACY)
     {
-        int sizeOfCmd;
-        int sizeOfId;
-        memcpy(&sizeOfCmd, readBuf_.data(), sizeof(int));
-        memcpy(&sizeOfId, readBuf_.data() + sizeof(int), sizeof(int));
+        strId = command.getStringId();
+        WS_ASSERT(strId.length() > 0);
+        headerSize = sizeof(int) * 2 + strId.length();
+    }
+
+    // the body is serialized right after the space for the header, the header is filled in when the size is known
+    outBuf_.resize(headerSize);
+    QBuffer buffer(&outBuf_);
+    buffer.open(QIODevice::WriteOnly | QIODevice::Append);
+    QDataStream ds(&buffer);
+    command.writeData(ds);
+    buffer.close();
+
+    char *header = outBuf_.data();
+    if (protocolVersion_ == PROTOCOL_VERSION_LEGACY)
+    {
+        int sizeOfBuf = outBuf_.size() - headerSize;
+        int sizeOfStringId = strId.length();
+        memcpy(header, &sizeOfBuf, sizeof(sizeOfBuf));
+        memcpy(header + sizeof(int), &sizeOfStringId, sizeof(sizeOfStringId));
+        memcpy(header + sizeof(int) * 2, strId.c_str(), sizeOfStringId);
+    }
+    else
+    {
+        quint32 marker = kFrameV2Marker;
+        quint32 sizeOfBody = outBuf_.size() - headerSize;
+        quint16 id = static_cast<quint16>(command.getId());
+        memcpy(header, &marker, sizeof(marker));
+        memcpy(header + sizeof(quint32), &sizeOfBody, sizeof(sizeOfBody));
+        memcpy(header + sizeof(quint32) * 2, &id, sizeof(id));
+    }
+}
+
+// Writes the queued frames while the socket accepts them, returns false on a socket error
+bool Connection::writeQueuedFrames()
+{
+    while (!writeQueue_.empty())
+    {
+        const QByteArray &frame = writeQueue_.front();
+        qint64 bytesWritten = localSocket_->write(frame.constData() + writeQueueOffset_, frame.size() - writeQueueOffset_);
+        if (bytesWritten == -1)
+        {
+            return false;
+        }
+        bytesWrittingInProgress_ += bytesWritten;
+        writeQueueOffset_ += bytesWritten;
+        if (writeQueueOffset_ < frame.size())
+        {
+            break;
+        }
+        writeQueue_.pop_front();
+        writeQueueOffset_ = 0;
+    }
+    return true;
+}
+
+// Returns the size of the frame at the offset of the read buffer, or 0 if it is not received completely yet
+int Connection::completeFrameSize(int offset) const
+{
+    const char *data = readBuf_.constData() + offset;
+    const qint64 available = readBuf_.size() - offset;
+    qint64 frameSize;
+
+    quint32 marker = 0;
+    if (available >= (qint64)sizeof(marker))
+    {
+        memcpy(&marker, data, sizeof(marker));
+    }
 
-        if (readBuf_.size() >= (int)(sizeof(int) * 2 + sizeOfCmd + sizeOfId))
+    if (marker == kFrameV2Marker)
+    {
+        if (available < kFrameV2HeaderSize)
+        {
+            return 0;
+        }
+        quint32 sizeOfBody;
+        memcpy(&sizeOfBody, data + sizeof(quint32), sizeof(sizeOfBody));
+        frameSize = kFrameV2HeaderSize + (qint64)sizeOfBody;
+    }
+    else
+    {
+        if (available <= (qint64)(sizeof(int) * 2))
         {
-            return true;
+            return 0;
         }
+        int sizeOfCmd;
+        int sizeOfId;
+        memcpy(&sizeOfCmd, data, sizeof(int));
+        memcpy(&sizeOfId, data + sizeof(int), sizeof(int));
+        frameSize = sizeof(int) * 2 + (qint64)sizeOfCmd + sizeOfId;
     }
-    return false;
+
+    return available >= frameSize ? (int)frameSize : 0;
 }
 
-Command *Connection::readCommand()
+Command *Connection::readCommand(int offset, int frameSize)
 {
+    char *data = readBuf_.data() + offset;
+
+    quint32 marker;
+    memcpy(&marker, data, sizeof(marker));
+    if (marker == kFrameV2Marker)
+    {
+        quint16 id;
+        memcpy(&id, data + sizeof(quint32) * 2, sizeof(id));
+        // the peer understands the binary frames, reply with them too
+        protocolVersion_ = PROTOCOL_VERSION_2;
+        return CommandFactory::makeCommand(static_cast<CommandId>(id), data + kFrameV2HeaderSize, frameSize - kFrameV2HeaderSize);
+    }
+
     int sizeOfCmd;
     int sizeOfId;
-    memcpy(&sizeOfCmd, readBuf_.data(), sizeof(int));
-    memcpy(&sizeOfId, readBuf_.data() + sizeof(int), sizeof(int));
-
-    std::string strId(readBuf_.data() + sizeof(int) * 2, sizeOfId);
+    memcpy(&sizeOfCmd, data, sizeof(int));
+    memcpy(&sizeOfId, data + sizeof(int), sizeof(int));
 
-    Command *cmd = CommandFactory::makeCommand(strId, readBuf_.data() + sizeof(int) * 2 + sizeOfId, sizeOfCmd);
-    readBuf_.remove(0, sizeof(int) * 2 + sizeOfId + sizeOfCmd);
-    return cmd;
+    std::string strId(data + sizeof(int) * 2, sizeOfId);
+    return CommandFactory::makeCommand(strId, data + sizeof(int) * 2 + sizeOfId, sizeOfCmd);
 }
 
 void Connection::safeDeleteSocket()
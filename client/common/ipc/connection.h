@@ -2,6 +2,7 @@
 
 #include <QLocalSocket>
 #include <QObject>
+#include <deque>
 #include "command.h"
 
 namespace IPC
@@ -23,6 +24,11 @@ public:
     void close();
     void sendCommand(const Command &commandl);
 
+    // The frame format of the sent commands. The legacy format by default, switched to the binary frames when the peer
+    // sends one or announces the support (see CliCommands::GetState)
+    void setProtocolVersion(int protocolVersion);
+    int protocolVersion() const;
+
 signals:
     void newCommand(IPC::Command *cmd, IPC::Connection *connection);
     void stateChanged(int state, IPC::Connection *connection);
@@ -36,14 +42,25 @@ private slots:
     void onSocketError(QLocalSocket::LocalSocketError socketError);
 
 private:
+    // legacy frame: (int) size of body, (int) size of string id, string id, body
+    // v2 frame: (quint32) kFrameV2Marker, (quint32) size of body, (quint16) command id, body
+    // The marker is a negative number as int, so it is never a valid size of a legacy body
+    static constexpr quint32 kFrameV2Marker = 0xFFFF5702;
+    static constexpr int kFrameV2HeaderSize = sizeof(quint32) * 2 + sizeof(quint16);
+
     QLocalSocket *localSocket_;
+    int protocolVersion_;
 
-    QByteArray writeBuf_;
+    QByteArray outBuf_;     // the commands are serialized here, reused between the commands
+    std::deque<QByteArray> writeQueue_;     // the frames not accepted by the socket yet
+    qint64 writeQueueOffset_;   // the written part of the first frame in the queue
     QByteArray readBuf_;
     qint64 bytesWrittingInProgress_;
 
-    bool canReadCommand();
-    Command *readCommand();
+    void serializeCommand(const Command &command);
+    bool writeQueuedFrames();
+    int completeFrameSize(int offset) const;
+    Command *readCommand(int offset, int frameSize);
 
     void safeDeleteSocket();
 };
@@ -9,9 +9,9 @@
 #include <signal.h>
 #include <Windows.h>
 
-#if defined(WINDSCRIBE_SERVICE)
 #include <spdlog/spdlog.h>
-#else
+
+#if !defined(WINDSCRIBE_SERVICE)
 #include "log/logger.h"
 #include <QStandardPaths>
 #endif
@@ -342,6 +342,9 @@ void CrashHandler::handleException(ExceptionInfo info)
                              info.exceptionPointers))
         CRASH_LOG_INFO(L"Wrote minidump: {}", filename);
 
+    // the log may be written asynchronously, write out the pending messages before the process is gone
+    // (skipped by the sink if the crash interrupted a log write in this thread)
+    spdlog::default_logger()->flush();
     TerminateProcess(GetCurrentProcess(), 1);
 }
 
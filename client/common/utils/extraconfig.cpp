@@ -43,6 +43,8 @@ const QString WS_LOG_CTRLD = WS_PREFIX + "log-ctrld";
 const QString WS_LOG_PINGS = WS_PREFIX + "log-pings";
 const QString WS_LOG_SPLITTUNNELEXTENSION = WS_PREFIX + "log-splittunnelextension";
 
+const QString WS_PROXY_MULTI_REACTOR = WS_PREFIX + "proxy-multi-reactor";
+
 
 void ExtraConfig::writeConfig(const QString &cfg)
 {
@@ -288,6 +290,11 @@ bool ExtraConfig::getWireGuardUdpStuffing()
     return getFlagFromExtraConfigLines(WS_WG_UDP_STUFFING);
 }
 
+bool ExtraConfig::getProxyMultiReactor()
+{
+    return getFlagFromExtraConfigLines(WS_PROXY_MULTI_REACTOR);
+}
+
 std::optional<QString> ExtraConfig::serverlistCountryOverride()
 {
     auto value = getValue(WS_SERVERLIST_COUNTRY_OVERRIDE);
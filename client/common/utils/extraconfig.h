@@ -59,6 +59,9 @@ public:
     bool getWireGuardVerboseLogging();
     bool getWireGuardUdpStuffing();
 
+    // Linux only: serve the proxy sharing with one reactor thread per core (see ProxyReactorPool)
+    bool getProxyMultiReactor();
+
     std::optional<QString> serverlistCountryOverride();
     bool serverListIgnoreCountryOverride();
     bool haveServerListCountryOverride();
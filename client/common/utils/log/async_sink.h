@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/sinks/sink.h>
+
+namespace log_utils {
+
+// Sink that moves the formatting and the file writes of the wrapped sink to a writer thread.
+// The callers only copy the message into the pending batch, the writer thread takes the whole batch at once,
+// writes it and flushes the wrapped sink. This happens every kFlushInterval or when kBatchSize messages are pending.
+// Error and critical messages, as well as flush(), write out everything pending synchronously in the calling thread,
+// so the log is complete on disk when such a call returns (before reading the log file or on crash).
+// A flush from a crash or signal handler interrupting a write in the same thread is skipped, the messages stay pending.
+// Thread safe
+class AsyncSink : public spdlog::sinks::sink
+{
+public:
+    explicit AsyncSink(std::shared_ptr<spdlog::sinks::sink> sink) : sink_(std::move(sink))
+    {
+        pending_.reserve(kBatchSize);
+        thread_ = std::thread(&AsyncSink::run, this);
+    }
+
+    ~AsyncSink() override
+    {
+        {
+            std::lock_guard<std::mutex> locker(queueMutex_);
+            finish_ = true;
+        }
+        condition_.notify_one();
+        thread_.join();
+        writePending();
+    }
+
+    void log(const spdlog::details::log_msg &msg) override
+    {
+        bool isFull;
+        bool isWriteNow;
+        {
+            std::lock_guard<std::mutex> locker(queueMutex_);
+            pending_.emplace_back(msg);
+            isFull = pending_.size() >= kBatchSize;
+            // if the writer does not keep up, the callers write the messages themselves rather than growing the queue
+            isWriteNow = msg.level >= spdlog::level::err || pending_.size() >= kMaxPendingMessages;
+        }
+
+        if (isWriteNow)
+            writePending();
+        else if (isFull)
+            condition_.notify_one();
+    }
+
+    void flush() override
+    {
+        writePending();
+    }
+
+    void set_pattern(const std::string &pattern) override
+    {
+        std::lock_guard<std::mutex> locker(writeMutex_);
+        sink_->set_pattern(pattern);
+    }
+
+    void set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter) override
+    {
+        std::lock_guard<std::mutex> locker(writeMutex_);
+        sink_->set_formatter(std::move(sinkFormatter));
+    }
+
+private:
+    static constexpr size_t kBatchSize = 256;
+    static constexpr size_t kMaxPendingMessages = 8192;
+    static constexpr std::chrono::milliseconds kFlushInterval{1000};
+
+    std::shared_ptr<spdlog::sinks::sink> sink_;
+    std::thread thread_;
+
+    std::mutex queueMutex_;
+    std::condition_variable condition_;
+    std::vector<spdlog::details::log_msg_buffer> pending_;
+    bool finish_ = false;
+
+    // serializes the writes to the wrapped sink, so the batches are written in the order they were taken
+    std::mutex writeMutex_;
+    // the thread holding writeMutex_, the mutex is not recursive
+    std::atomic<std::thread::id> writeOwner_;
+    std::vector<spdlog::details::log_msg_buffer> batch_;
+
+    void run()
+    {
+        std::unique_lock<std::mutex> locker(queueMutex_);
+        while (!finish_) {
+            condition_.wait_for(locker, kFlushInterval, [this] { return finish_ || pending_.size() >= kBatchSize; });
+            if (finish_)
+                break;
+            if (pending_.empty())
+                continue;
+            locker.unlock();
+            writePending();
+            locker.lock();
+        }
+    }
+
+    void writePending()
+    {
+        // the thread crashed while writing (the writer thread, or a caller writing out an error),
+        // locking again would hang the process instead of letting it terminate
+        if (writeOwner_.load() == std::this_thread::get_id())
+            return;
+
+        std::lock_guard<std::mutex> writeLocker(writeMutex_);
+        writeOwner_ = std::this_thread::get_id();
+        struct OwnerReset {
+            std::atomic<std::thread::id> &owner;
+            ~OwnerReset() { owner = std::thread::id(); }
+        } ownerReset{writeOwner_};
+        {
+            std::lock_guard<std::mutex> locker(queueMutex_);
+            batch_.swap(pending_);
+        }
+        for (const auto &msg : batch_)
+            sink_->log(msg);
+        sink_->flush();
+        batch_.clear();
+    }
+};
+
+}  // namespace log_utils
@@ -11,6 +11,7 @@
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_sinks.h>
 
+#include "async_sink.h"
 #include "spdlog_utils.h"
 #include "paths.h"
 
@@ -38,7 +39,8 @@ bool Logger::install(const QString &logFilePath, bool consoleOutput)
         }
         // Create rotation logger with 2 file with unlimited size
         // rotate it on open, the first file is the current log, the 2nd is the previous log
-        auto fileSink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(path, SIZE_MAX, 1, true);
+        // the file is written by the writer thread of the async sink, so logging does not block the engine and network threads
+        auto fileSink = std::make_shared<log_utils::AsyncSink>(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(path, SIZE_MAX, 1, true));
         auto defaultLogger = std::make_shared<spdlog::logger>("default", fileSink);
         spdlog::set_default_logger(defaultLogger);
 
@@ -53,10 +55,8 @@ bool Logger::install(const QString &logFilePath, bool consoleOutput)
         spdlog::get("raw")->sinks().push_back(sinkDebug);
 #endif
 
-        // this will trigger flush on every log message
-        defaultLogger->flush_on(spdlog::level::trace);
+        // no flush_on() here, the async sink flushes the batches and writes out errors immediately itself
         defaultLogger->set_level(spdlog::level::trace);
-        rawLogger->flush_on(spdlog::level::trace);
         rawLogger->set_level(spdlog::level::trace);
 
         auto formatter = std::make_unique<log_utils::CustomFormatter>(spdlog::details::make_unique<spdlog::pattern_formatter>("{\"tm\": \"%Y-%m-%d %H:%M:%S.%e\", \"lvl\": \"%^%l%$\", %v}"));
@@ -73,6 +73,13 @@ bool Logger::install(const QString &logFilePath, bool consoleOutput)
 }
 
 
+void Logger::flush()
+{
+    // the loggers share the file sink, flushing one of them writes out the pending messages of both
+    if (auto logger = spdlog::default_logger())
+        logger->flush();
+}
+
 Logger::Logger()
 {
     connectionCategoryDefault_ = std::make_unique<QLoggingCategory>("connection");
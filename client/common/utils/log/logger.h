@@ -19,6 +19,9 @@ public:
 
     void setConsoleOutput(bool on);
 
+    // Writes the pending log messages to the file, should be called before the log file is read
+    void flush();
+
     void startConnectionMode(const std::string &id);
     void endConnectionMode();
     const QLoggingCategory& connectionModeLoggingCategory();
@@ -8,6 +8,7 @@
 #include <QTextStream>
 #include <future>
 
+#include "logger.h"
 #include "paths.h"
 
 namespace
@@ -112,6 +113,9 @@ std::unique_ptr<MergeLog::ParseTaskResult> MergeLog::parseTask(const QString *fi
 QString MergeLog::merge(const QString &guiLogFilename, const QString &serviceLogFilename, const QString &wireguardServiceLogFilename,
                         const QString &servicePrevLogFilename, const QString &installerLogFilename)
 {
+    // The client log is written by a background thread, make sure it is complete on disk
+    Logger::instance().flush();
+
     // Do parallel parsing for speed
     auto futureClientLog = std::async(MergeLog::parseTask, &guiLogFilename, LineSource::CLIENT);
     auto futureServiceLog = std::async(MergeLog::parseTask, &serviceLogFilename, LineSource::SERVICE);
@@ -0,0 +1,279 @@
+#include "network_snapshot_linux.h"
+
+#include <QScopeGuard>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../log/categories.h"
+
+namespace NetworkUtils_linux
+{
+
+// accessed with std::atomic_load() and std::atomic_store() only, which lock a mutex of a pool in libstdc++
+static std::shared_ptr<const NetworkSnapshot> g_snapshot;
+// a cached snapshot is current if its generation is the current one
+static std::atomic<quint64> g_generation(1);
+static std::atomic<bool> g_isMonitored(false);
+
+static QString addressToString(const void *data)
+{
+    char str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, data, str, sizeof(str));
+    return QString(str);
+}
+
+// Sends a dump request and passes every message of the reply to the callback
+static bool dump(int fd, quint16 type, const void *header, size_t headerLen, quint32 seq,
+                 const std::function<void(const struct nlmsghdr *)> &callback)
+{
+    std::vector<char> request(NLMSG_SPACE(headerLen), 0);
+    auto *nlh = reinterpret_cast<struct nlmsghdr *>(request.data());
+    nlh->nlmsg_len = NLMSG_LENGTH(headerLen);
+    nlh->nlmsg_type = type;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    nlh->nlmsg_seq = seq;
+    memcpy(NLMSG_DATA(nlh), header, headerLen);
+    if (send(fd, request.data(), request.size(), 0) < 0) {
+        return false;
+    }
+
+    std::vector<char> buf(65536);
+    while (true) {
+        ssize_t len = recv(fd, buf.data(), buf.size(), 0);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        for (auto *msg = reinterpret_cast<struct nlmsghdr *>(buf.data()); NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+            if (msg->nlmsg_seq != seq) {
+                continue;
+            }
+            if (msg->nlmsg_type == NLMSG_DONE) {
+                return true;
+            }
+            if (msg->nlmsg_type == NLMSG_ERROR) {
+                return false;
+            }
+            callback(msg);
+        }
+    }
+}
+
+static void parseLink(const struct nlmsghdr *nlh, NetworkSnapshot &snapshot)
+{
+    const auto *ifi = reinterpret_cast<const struct ifinfomsg *>(NLMSG_DATA(nlh));
+    NetworkSnapshot::Link link;
+    link.index = ifi->ifi_index;
+    link.type = ifi->ifi_type;
+    link.flags = ifi->ifi_flags;
+
+    unsigned char mac[6] = { 0 };
+    int len = IFLA_PAYLOAD(nlh);
+    for (auto *attr = IFLA_RTA(ifi); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFLA_IFNAME) {
+            link.name = QString(reinterpret_cast<const char *>(RTA_DATA(attr)));
+        } else if (attr->rta_type == IFLA_ADDRESS) {
+            memcpy(mac, RTA_DATA(attr), qMin<size_t>(RTA_PAYLOAD(attr), sizeof(mac)));
+        }
+    }
+    link.macAddress = QString::asprintf("%.2X:%.2X:%.2X:%.2X:%.2X:%.2X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    snapshot.links.push_back(link);
+}
+
+static void parseAddress(const struct nlmsghdr *nlh, NetworkSnapshot &snapshot)
+{
+    const auto *ifa = reinterpret_cast<const struct ifaddrmsg *>(NLMSG_DATA(nlh));
+    if (ifa->ifa_family != AF_INET) {
+        return;
+    }
+
+    // IFA_ADDRESS is the peer on a point-to-point link, IFA_LOCAL the address of the interface
+    const void *local = nullptr;
+    const void *address = nullptr;
+    int len = IFA_PAYLOAD(nlh);
+    for (auto *attr = IFA_RTA(ifa); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFA_LOCAL) {
+            local = RTA_DATA(attr);
+        } else if (attr->rta_type == IFA_ADDRESS) {
+            address = RTA_DATA(attr);
+        }
+    }
+    if (local || address) {
+        NetworkSnapshot::Address addr;
+        addr.ifIndex = ifa->ifa_index;
+        addr.address = addressToString(local ? local : address);
+        snapshot.addresses.push_back(addr);
+    }
+}
+
+static void parseRoute(const struct nlmsghdr *nlh, NetworkSnapshot &snapshot)
+{
+    const auto *rtm = reinterpret_cast<const struct rtmsg *>(NLMSG_DATA(nlh));
+    if (rtm->rtm_family != AF_INET || rtm->rtm_type != RTN_UNICAST) {
+        return;
+    }
+
+    quint32 table = rtm->rtm_table;
+    NetworkSnapshot::Route route;
+    route.destination = "0.0.0.0";
+    route.gateway = "0.0.0.0";
+    route.prefixLength = rtm->rtm_dst_len;
+    int len = RTM_PAYLOAD(nlh);
+    for (auto *attr = RTM_RTA(rtm); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        switch (attr->rta_type) {
+        case RTA_TABLE:
+            table = *reinterpret_cast<const quint32 *>(RTA_DATA(attr));
+            break;
+        case RTA_DST:
+            route.destination = addressToString(RTA_DATA(attr));
+            break;
+        case RTA_GATEWAY:
+            route.gateway = addressToString(RTA_DATA(attr));
+            break;
+        case RTA_OIF:
+            route.ifIndex = *reinterpret_cast<const int *>(RTA_DATA(attr));
+            break;
+        case RTA_PRIORITY:
+            route.metric = *reinterpret_cast<const quint32 *>(RTA_DATA(attr));
+            break;
+        case RTA_MULTIPATH:
+            // an ECMP route has its next hops here and no RTA_OIF, /proc/net/route listed the first one
+            if (RTA_PAYLOAD(attr) >= sizeof(struct rtnexthop)) {
+                const auto *nh = reinterpret_cast<const struct rtnexthop *>(RTA_DATA(attr));
+                if (nh->rtnh_len >= sizeof(struct rtnexthop) && nh->rtnh_len <= RTA_PAYLOAD(attr)) {
+                    route.ifIndex = nh->rtnh_ifindex;
+                    int nhLen = nh->rtnh_len - RTNH_LENGTH(0);
+                    for (auto *nhAttr = RTNH_DATA(nh); RTA_OK(nhAttr, nhLen); nhAttr = RTA_NEXT(nhAttr, nhLen)) {
+                        if (nhAttr->rta_type == RTA_GATEWAY) {
+                            route.gateway = addressToString(RTA_DATA(nhAttr));
+                        }
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    // the routes of /proc/net/route
+    if (table == RT_TABLE_MAIN && route.ifIndex != 0) {
+        snapshot.routes.push_back(route);
+    }
+}
+
+static bool fetchSnapshot(NetworkSnapshot &snapshot)
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        qCCritical(LOG_BASIC) << "NetworkUtils_linux::fetchSnapshot() could not open netlink socket:" << errno;
+        return false;
+    }
+
+    auto exitGuard = qScopeGuard([&] {
+        close(fd);
+    });
+
+    // one socket, the dumps of the links, the addresses and the routes one after another
+    struct ifinfomsg ifi;
+    memset(&ifi, 0, sizeof(ifi));
+    ifi.ifi_family = AF_UNSPEC;
+    struct ifaddrmsg ifa;
+    memset(&ifa, 0, sizeof(ifa));
+    ifa.ifa_family = AF_INET;
+    struct rtmsg rtm;
+    memset(&rtm, 0, sizeof(rtm));
+    rtm.rtm_family = AF_INET;
+
+    const bool result =
+        dump(fd, RTM_GETLINK, &ifi, sizeof(ifi), 1, [&](const struct nlmsghdr *nlh) { parseLink(nlh, snapshot); }) &&
+        dump(fd, RTM_GETADDR, &ifa, sizeof(ifa), 2, [&](const struct nlmsghdr *nlh) { parseAddress(nlh, snapshot); }) &&
+        dump(fd, RTM_GETROUTE, &rtm, sizeof(rtm), 3, [&](const struct nlmsghdr *nlh) { parseRoute(nlh, snapshot); });
+    if (!result) {
+        qCCritical(LOG_BASIC) << "NetworkUtils_linux::fetchSnapshot() netlink dump failed:" << errno;
+    }
+    return result;
+}
+
+const NetworkSnapshot::Link *NetworkSnapshot::linkByIndex(int index) const
+{
+    for (const auto &link : links) {
+        if (link.index == index) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+const NetworkSnapshot::Link *NetworkSnapshot::linkByName(const QString &name) const
+{
+    for (const auto &link : links) {
+        if (link.name == name) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+QString NetworkSnapshot::firstAddress(int ifIndex) const
+{
+    for (const auto &address : addresses) {
+        if (address.ifIndex == ifIndex) {
+            return address.address;
+        }
+    }
+    return QString();
+}
+
+std::shared_ptr<const NetworkSnapshot> networkSnapshot()
+{
+    // the generation is read before the fetch, a change during the fetch makes the new snapshot outdated already;
+    // without the monitor every snapshot gets a generation of its own, nothing cached for an older one is reused
+    const bool isMonitored = g_isMonitored;
+    const quint64 generation = isMonitored ? g_generation.load() : ++g_generation;
+    // a thread keeps its own reference to the published snapshot, so the shared one (and its lock) is only read
+    // once per thread and network change; the generations only grow, an older snapshot never matches again
+    thread_local std::shared_ptr<const NetworkSnapshot> t_snapshot;
+    if (isMonitored) {
+        if (t_snapshot && t_snapshot->generation == generation) {
+            return t_snapshot;
+        }
+        auto snapshot = std::atomic_load(&g_snapshot);
+        if (snapshot && snapshot->generation == generation) {
+            t_snapshot = snapshot;
+            return snapshot;
+        }
+    }
+
+    auto snapshot = std::make_shared<NetworkSnapshot>();
+    snapshot->generation = generation;
+    if (fetchSnapshot(*snapshot) && isMonitored) {
+        std::atomic_store(&g_snapshot, std::shared_ptr<const NetworkSnapshot>(snapshot));
+        t_snapshot = snapshot;
+    }
+    return snapshot;
+}
+
+void setNetworkSnapshotMonitored(bool isMonitored)
+{
+    g_isMonitored = isMonitored;
+    g_generation++;
+}
+
+void invalidateNetworkSnapshot()
+{
+    g_generation++;
+}
+
+} // namespace NetworkUtils_linux
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <memory>
+
+namespace NetworkUtils_linux
+{
+
+// The links, their IPv4 addresses and the IPv4 routes of the main table, fetched from the kernel with rtnetlink dumps.
+// A snapshot is never modified once published, the readers share it.
+struct NetworkSnapshot
+{
+    struct Link
+    {
+        int index = 0;
+        QString name;
+        unsigned int type = 0;      // ARPHRD_*
+        unsigned int flags = 0;     // IFF_*
+        QString macAddress;         // "XX:XX:XX:XX:XX:XX", all zeros if the link has no hardware address
+    };
+
+    struct Address
+    {
+        int ifIndex = 0;
+        QString address;
+    };
+
+    struct Route
+    {
+        int ifIndex = 0;
+        QString destination;
+        int prefixLength = 0;
+        QString gateway;            // "0.0.0.0" if the route has no gateway, as in /proc/net/route
+        quint32 metric = 0;
+    };
+
+    // the data derived from a snapshot can be cached by its generation: it changes with the network while monitored,
+    // every snapshot has its own otherwise
+    quint64 generation = 0;
+    QVector<Link> links;            // in the order of the interface indexes
+    QVector<Address> addresses;     // in the order of the interface indexes
+    QVector<Route> routes;
+
+    const Link *linkByIndex(int index) const;
+    const Link *linkByName(const QString &name) const;
+    // the first address of the link, empty if it has none
+    QString firstAddress(int ifIndex) const;
+};
+
+// The current snapshot. While the network changes are monitored (see below), it is fetched once and reused until
+// invalidateNetworkSnapshot() is called, otherwise every call fetches a new one.
+std::shared_ptr<const NetworkSnapshot> networkSnapshot();
+
+// Called by the monitor of the rtnetlink notifications (RouteMonitor_linux), for as long as it gets them.
+void setNetworkSnapshotMonitored(bool isMonitored);
+void invalidateNetworkSnapshot();
+
+} // namespace NetworkUtils_linux
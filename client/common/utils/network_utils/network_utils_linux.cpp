@@ -1,86 +1,42 @@
 #include "network_utils_linux.h"
 
-#include <QDir>
-#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
 #include <QScopeGuard>
-#include <QtAlgorithms>
+
+#include <algorithm>
+#include <map>
+#include <set>
 
 #include <net/if.h>
 #include <arpa/inet.h>
+#include <linux/errqueue.h>
 #include <linux/if_arp.h>
 #include <linux/rtnetlink.h>
 #include <linux/wireless.h>
+#include <netdb.h>
+#include <netinet/ip_icmp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
 #include "../log/categories.h"
 #include "../utils.h"
+#include "network_snapshot_linux.h"
 
 namespace NetworkUtils_linux
 {
 
-static RoutingTableEntry parseEntry(const char *buf)
+static QString getAdapterIp(const NetworkSnapshot &snapshot, const NetworkSnapshot::Link &link)
 {
-    QStringList split = QString(buf).split("\t");
-    RoutingTableEntry entry;
-
-    if (split.size() < 9) {
-        qCWarning(LOG_BASIC) << "NetworkUtils_linux::parseEntry() failed to parse routing table entry:" << buf;
-        return entry;
+    // first IPv4 address of the interface if it is up
+    if ((link.flags & (IFF_UP | IFF_RUNNING)) != (IFF_UP | IFF_RUNNING)) {
+        return QString();
     }
-
-    entry.interface = split[0];
-    entry.destination = QHostAddress((quint32)ntohl(split[1].toUInt(nullptr, 16))).toString();
-    entry.gateway = QHostAddress((quint32)ntohl(split[2].toUInt(nullptr, 16))).toString();
-    entry.flags = split[3].toInt();
-    entry.metric = split[6].toInt();
-    entry.netmask = qPopulationCount((quint32)split[7].toUInt(nullptr, 16));
-    entry.mtu = split[8].toInt();
-    return entry;
-}
-
-static QList<RoutingTableEntry> getRoutingTableAsList()
-{
-    QList<RoutingTableEntry> entries;
-
-    FILE *f = fopen("/proc/net/route", "r");
-    if (f == NULL) {
-        qCCritical(LOG_BASIC) << "NetworkUtils_linux::getRoutingTable() failed to open /proc/net/route:" << errno;
-        return entries;
-    }
-
-    auto exitGuard = qScopeGuard([&] {
-        fclose(f);
-    });
-
-    const size_t len = 1024;
-    char buf[len];
-    memset(buf, 0, len);
-
-    // skip the first line, which is just labels
-    if (fgets(buf, 1024, f) == NULL) {
-        qCCritical(LOG_BASIC) << "NetworkUtils_linux::getRoutingTable() failed to read routing table";
-        return entries;
-    }
-
-    // parse remaining lines
-    while (fgets(buf, 1024, f) != NULL) {
-        RoutingTableEntry entry = parseEntry(buf);
-        if (entry.interface.isEmpty()) {
-            // skip invalid entries
-            continue;
-        }
-
-        entries.push_back(entry);
-    }
-
-    return entries;
-}
-
-static QString getAdapterIp(QString interface)
-{
-    return Utils::execCmd(QString("ip -br -4 addr show %1 | grep UP | awk '{print $3}' | cut -d '/' -f 1").arg(interface)).trimmed();
+    return snapshot.firstAddress(link.index);
 }
 
 void getDefaultRoute(QString &outGatewayIp, QString &outInterfaceName, QString &outAdapterIp, bool ignoreTun)
@@ -89,22 +45,26 @@ void getDefaultRoute(QString &outGatewayIp, QString &outInterfaceName, QString &
     outGatewayIp.clear();
     outAdapterIp.clear();
 
-    int lowestMetric = INT32_MAX;
+    quint32 lowestMetric = UINT32_MAX;
 
-    QList<RoutingTableEntry> entries = getRoutingTableAsList();
-    for (const RoutingTableEntry& entry : qAsConst(entries)) {
+    const auto snapshot = networkSnapshot();
+    for (const auto &route : snapshot->routes) {
+        const NetworkSnapshot::Link *link = snapshot->linkByIndex(route.ifIndex);
+        if (!link) {
+            continue;
+        }
         // if ignoring tun interfaces, remove them from contention
-        if (ignoreTun && (entry.interface.startsWith("tun") || entry.interface.startsWith("utun"))) {
+        if (ignoreTun && (link->name.startsWith("tun") || link->name.startsWith("utun"))) {
             continue;
         }
         // only consider routes which have a destination of 0.0.0.0.
         // filtering by metric alone is not enough, because when an interface first comes up, network manager will add 20000 to the metric
         // if it has not yet passed a connectivity check
-        if (entry.metric < lowestMetric && entry.destination == "0.0.0.0") {
-            lowestMetric = entry.metric;
-            outInterfaceName = entry.interface;
-            outAdapterIp = getAdapterIp(entry.interface);
-            outGatewayIp = entry.gateway;
+        if (route.metric < lowestMetric && route.destination == "0.0.0.0") {
+            lowestMetric = route.metric;
+            outInterfaceName = link->name;
+            outAdapterIp = getAdapterIp(*snapshot, *link);
+            outGatewayIp = route.gateway;
         }
     }
 }
@@ -117,77 +77,225 @@ bool pingWithMtu(const QString &url, int mtu)
     return result.contains("icmp_seq=");
 }
 
-QString getLocalIP()
+// the sizes probed at once, and the time to wait for their replies
+static const int kPmtuProbesPerRound = 4;
+static const int kPmtuProbeTimeoutMs = 1000;
+// Once a probe got a reply, the others sent with it are waited for a few round trips more only. A path that drops
+// the large packets silently (no ICMP frag-needed) would cost the full timeout in every round otherwise.
+static const int kPmtuProbeExtraWaitMs = 100;
+// the IP and ICMP headers in front of the payload
+static const int kPmtuHeadersSize = 28;
+
+bool findMaxPingPayload(const QString &url, const QVector<int> &sizes, int hintSize, const std::function<bool()> &isCancelled, int &outSize)
 {
-    // Yegor and Clayton found this command to work on many distros, including old ones.
-    QString sLocalIP = Utils::execCmd("hostname -I | awk '{print $1}'").trimmed();
+    outSize = -1;
+    if (sizes.isEmpty()) {
+        return true;
+    }
 
-    // Check if we received a valid IPv4 address.
-    QHostAddress addr;
-    if (addr.setAddress(sLocalIP) && addr.protocol() == QAbstractSocket::IPv4Protocol) {
-        return sLocalIP;
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_ICMP);
+    if (sock < 0) {
+        qCInfo(LOG_BASIC) << "NetworkUtils_linux::findMaxPingPayload() ICMP socket not available:" << errno;
+        return false;
     }
 
-    sLocalIP.clear();
-    int lowestMetric = INT32_MAX;
+    auto exitGuard = qScopeGuard([&] {
+        close(sock);
+    });
 
-    QList<RoutingTableEntry> entries = getRoutingTableAsList();
-    for (const RoutingTableEntry& entry : qAsConst(entries)) {
-        QString adapterIp = getAdapterIp(entry.interface);
-        if (!adapterIp.isEmpty() && entry.metric < lowestMetric) {
-            lowestMetric = entry.metric;
-            sLocalIP = adapterIp;
-        }
+    // PROBE sets the DF bit and ignores the path MTU cached by the kernel, RECVERR returns the ICMP errors for the probes
+    int val = IP_PMTUDISC_PROBE;
+    setsockopt(sock, IPPROTO_IP, IP_MTU_DISCOVER, &val, sizeof(val));
+    val = 1;
+    setsockopt(sock, IPPROTO_IP, IP_RECVERR, &val, sizeof(val));
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo *addr = nullptr;
+    if (getaddrinfo(url.toStdString().c_str(), nullptr, &hints, &addr) != 0 || addr == nullptr) {
+        qCWarning(LOG_BASIC) << "NetworkUtils_linux::findMaxPingPayload() could not resolve" << url;
+        return true;
+    }
+    const int ret = ::connect(sock, addr->ai_addr, addr->ai_addrlen);
+    freeaddrinfo(addr);
+    if (ret < 0) {
+        qCWarning(LOG_BASIC) << "NetworkUtils_linux::findMaxPingPayload() could not connect:" << errno;
+        return true;
     }
 
-    if (sLocalIP.isEmpty()) {
-        qCCritical(LOG_BASIC) << "LinuxUtils::getLocalIP() failed to determine the local IP";
+    // sizes[good] got a reply, the sizes from the lowest index in badIndexes above it did not, the ones in between are unknown
+    int good = -1;
+    int bad = sizes.size();
+    std::set<int> badIndexes;
+    std::uint16_t sequence = 0;
+    const int hint = sizes.indexOf(hintSize);
+    QByteArray buf(sizes.last() + sizeof(struct icmphdr), 0);
+    struct icmphdr *icmp = reinterpret_cast<struct icmphdr *>(buf.data());
+
+    for (bool isFirstRound = true; bad - good > 1; isFirstRound = false) {
+        if (isCancelled && isCancelled()) {
+            return true;
+        }
+
+        // The largest unknown size is always probed, a clean path is done in one round trip.
+        // The first round also checks the last result on this network and the size above it.
+        std::set<int> indexes;
+        indexes.insert(bad - 1);
+        if (isFirstRound && hint > good && hint < bad) {
+            indexes.insert(hint);
+            if (hint + 1 < bad) {
+                indexes.insert(hint + 1);
+            }
+        }
+        for (int i = 1; i < kPmtuProbesPerRound; ++i) {
+            const int index = good + (bad - good) * i / kPmtuProbesPerRound;
+            if (index > good && index < bad) {
+                indexes.insert(index);
+            }
+        }
+
+        // sequence number -> index of the size
+        std::map<std::uint16_t, int> probes;
+        for (int index : indexes) {
+            // the kernel fills the identifier and the checksum
+            memset(buf.data(), 0, buf.size());
+            icmp->type = ICMP_ECHO;
+            icmp->un.echo.sequence = htons(++sequence);
+            if (send(sock, buf.data(), sizeof(struct icmphdr) + sizes[index], 0) < 0) {
+                // EMSGSIZE: larger than the MTU of the local interface
+                badIndexes.insert(index);
+                continue;
+            }
+            probes[sequence] = index;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        int timeoutMs = kPmtuProbeTimeoutMs;
+        while (!probes.empty()) {
+            const int remainingMs = timeoutMs - timer.elapsed();
+            struct pollfd pfd;
+            pfd.fd = sock;
+            pfd.events = POLLIN;
+            if (remainingMs <= 0 || poll(&pfd, 1, remainingMs) <= 0) {
+                break;
+            }
+
+            if (pfd.revents & POLLERR) {
+                // an ICMP error, returned with the beginning of the probe it is for
+                char data[64];
+                char control[512];
+                struct iovec iov = { data, sizeof(data) };
+                struct msghdr msg;
+                memset(&msg, 0, sizeof(msg));
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                const ssize_t len = recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+                if (len < static_cast<ssize_t>(sizeof(struct icmphdr))) {
+                    continue;
+                }
+                for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                    if (cmsg->cmsg_level != SOL_IP || cmsg->cmsg_type != IP_RECVERR) {
+                        continue;
+                    }
+                    const auto *err = reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cmsg));
+                    const auto probe = probes.find(ntohs(reinterpret_cast<const struct icmphdr *>(data)->un.echo.sequence));
+                    if (probe == probes.end()) {
+                        continue;
+                    }
+                    badIndexes.insert(probe->second);
+                    // a router reported the MTU of the next hop, none of the larger sizes can pass it
+                    const bool isFragNeeded = (err->ee_origin == SO_EE_ORIGIN_ICMP && err->ee_type == ICMP_DEST_UNREACH && err->ee_code == ICMP_FRAG_NEEDED) ||
+                                              (err->ee_origin == SO_EE_ORIGIN_LOCAL && err->ee_errno == EMSGSIZE);
+                    if (isFragNeeded && err->ee_info > 0) {
+                        for (int i = 0; i < sizes.size(); ++i) {
+                            if (sizes[i] + kPmtuHeadersSize > static_cast<int>(err->ee_info)) {
+                                badIndexes.insert(i);
+                                break;
+                            }
+                        }
+                    }
+                    probes.erase(probe);
+                }
+                continue;
+            }
+
+            const ssize_t len = recv(sock, buf.data(), buf.size(), MSG_DONTWAIT);
+            if (len < static_cast<ssize_t>(sizeof(struct icmphdr)) || icmp->type != ICMP_ECHOREPLY) {
+                continue;
+            }
+            const auto probe = probes.find(ntohs(icmp->un.echo.sequence));
+            if (probe != probes.end()) {
+                good = std::max(good, probe->second);
+                probes.erase(probe);
+                timeoutMs = std::min<int>(timeoutMs, timer.elapsed() * 3 + kPmtuProbeExtraWaitMs);
+            }
+            // the sizes below a reply are good, their probes are not waited for
+            for (auto it = probes.begin(); it != probes.end();) {
+                it = (it->second < good) ? probes.erase(it) : std::next(it);
+            }
+        }
+
+        // a probe without a reply counts as too large, like a ping that timed out
+        for (const auto &probe : probes) {
+            badIndexes.insert(probe.second);
+        }
+        const auto firstBad = badIndexes.upper_bound(good);
+        bad = (firstBad != badIndexes.end()) ? *firstBad : sizes.size();
     }
 
-    return sLocalIP;
+    if (good >= 0) {
+        outSize = sizes[good];
+    }
+    return true;
 }
 
-QString getRoutingTable()
+QString getLocalIP()
 {
-    return Utils::execCmd("cat /proc/net/route");
-}
+    const auto snapshot = networkSnapshot();
 
-static QString getMacAddressByIfName(const QString &ifname)
-{
-    QString ret;
+    // the first address outside of the loopback, what "hostname -I" printed first
+    for (const auto &address : snapshot->addresses) {
+        const NetworkSnapshot::Link *link = snapshot->linkByIndex(address.ifIndex);
+        if (link && link->type != ARPHRD_LOOPBACK && !address.address.startsWith("127.")) {
+            return address.address;
+        }
+    }
 
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd != -1) {
-        struct ifreq ifr;
-        memset(&ifr, 0, sizeof(ifr));
-        ifr.ifr_addr.sa_family = AF_INET;
-        strncpy(ifr.ifr_name , ifname.toStdString().c_str() , IFNAMSIZ-1);
-        if (ioctl(fd, SIOCGIFHWADDR, &ifr) == 0) {
-            unsigned char *mac = (unsigned char *)ifr.ifr_hwaddr.sa_data;
-            // format mac address
-            ret = QString::asprintf("%.2X:%.2X:%.2X:%.2X:%.2X:%.2X" , mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    QString sLocalIP;
+    quint32 lowestMetric = UINT32_MAX;
+
+    for (const auto &route : snapshot->routes) {
+        const NetworkSnapshot::Link *link = snapshot->linkByIndex(route.ifIndex);
+        if (!link) {
+            continue;
+        }
+        QString adapterIp = getAdapterIp(*snapshot, *link);
+        if (!adapterIp.isEmpty() && route.metric < lowestMetric) {
+            lowestMetric = route.metric;
+            sLocalIP = adapterIp;
         }
-        close(fd);
     }
-    return ret;
+
+    if (sLocalIP.isEmpty()) {
+        qCCritical(LOG_BASIC) << "LinuxUtils::getLocalIP() failed to determine the local IP";
+    }
+
+    return sLocalIP;
 }
 
-static bool isActiveByIfName(const QString &ifname)
+QString getRoutingTable()
 {
-    bool ret = false;
-
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd != -1) {
-        struct ifreq ifr;
-        memset(&ifr, 0, sizeof(ifr));
-        ifr.ifr_addr.sa_family = AF_INET;
-        strncpy(ifr.ifr_name , ifname.toStdString().c_str() , IFNAMSIZ-1);
-        if (ioctl(fd, SIOCGIFFLAGS, &ifr) == 0) {
-            ret = (ifr.ifr_flags & ( IFF_UP | IFF_RUNNING )) == ( IFF_UP | IFF_RUNNING );
-        }
-        close(fd);
+    QFile f("/proc/net/route");
+    if (!f.open(QFile::ReadOnly | QFile::Text)) {
+        qCCritical(LOG_BASIC) << "NetworkUtils_linux::getRoutingTable() failed to open /proc/net/route";
+        return QString();
     }
-    return ret;
+    return QString::fromLocal8Bit(f.readAll());
 }
 
 static bool checkWirelessByIfName(const QString &ifname)
@@ -207,9 +315,47 @@ static bool checkWirelessByIfName(const QString &ifname)
     return ret;
 }
 
-static QString getNetworkForInterface(const QString &ifname)
+#ifndef CLI_ONLY
+// The names of the NetworkManager connections by interface. nmcli is run once for a snapshot of the network,
+// not for every interface, and not again until the network changes (every snapshot is new without the monitor).
+static QHash<QString, QString> getNetworkNames(quint64 generation)
+{
+    static QMutex mutex;
+    static quint64 namesGeneration = 0;
+    static QHash<QString, QString> names;
+
+    QMutexLocker locker(&mutex);
+    if (generation != 0 && generation == namesGeneration) {
+        return names;
+    }
+
+    QString strReply;
+    FILE *file = popen("nmcli -t -f NAME,DEVICE c show", "r");
+    if (file) {
+        char szLine[4096];
+        while(fgets(szLine, sizeof(szLine), file) != 0) {
+            strReply += szLine;
+        }
+        pclose(file);
+    }
+
+    names.clear();
+    const QStringList lines = strReply.split('\n', Qt::SkipEmptyParts);
+    for (auto &it : lines) {
+        const QStringList pars = it.split(':', Qt::SkipEmptyParts);
+        if (pars.size() == 2 && !names.contains(pars[1])) {
+            names[pars[1]] = pars[0];
+        }
+    }
+    namesGeneration = generation;
+    return names;
+}
+#endif
+
+static QString getNetworkForInterface(const NetworkSnapshot &snapshot, const QString &ifname)
 {
 #ifdef CLI_ONLY
+    Q_UNUSED(snapshot);
     // When using CLI only, the network is likely not managed by nmcli, even if network-manager is even installed.
     // Instead, we use iwgetid to get the SSID if it is Wi-Fi.  Otherwise, the name is just the name of the interface.
     if (!checkWirelessByIfName(ifname)) {
@@ -228,42 +374,27 @@ static QString getNetworkForInterface(const QString &ifname)
             return "";
         }
     }
+    return QString();
 #else
-    QString strReply;
-    FILE *file = popen("nmcli -t -f NAME,DEVICE c show", "r");
-    if (file) {
-        char szLine[4096];
-        while(fgets(szLine, sizeof(szLine), file) != 0) {
-            strReply += szLine;
-        }
-        pclose(file);
-    }
-
-    const QStringList lines = strReply.split('\n', Qt::SkipEmptyParts);
-    for (auto &it : lines) {
-        const QStringList pars = it.split(':', Qt::SkipEmptyParts);
-        if (pars.size() == 2) {
-            if (pars[1] == ifname) {
-                return pars[0];
-            }
-        }
-    }
+    return getNetworkNames(snapshot.generation).value(ifname);
 #endif
-    return QString();
 }
 
-static void populateInterface(const QString &ifname, types::NetworkInterface &interface)
+static types::NetworkInterface interfaceForLink(const NetworkSnapshot &snapshot, const NetworkSnapshot::Link &link)
 {
-    interface.interfaceName = ifname;
-    interface.interfaceIndex = if_nametoindex(ifname.toStdString().c_str());
-    if (interface.interfaceIndex == 0) {
-        // interface index can not be 0 on Linux, this is an error.
-        interface.interfaceIndex = -1;
+    types::NetworkInterface interface = types::NetworkInterface::noNetworkInterface();
+
+    // Exclude loopback type
+    if (link.type == ARPHRD_LOOPBACK) {
+        return interface;
     }
-    interface.physicalAddress = getMacAddressByIfName(ifname);
-    interface.networkOrSsid = getNetworkForInterface(ifname);
 
-    if (checkWirelessByIfName(ifname)) {
+    interface.interfaceName = link.name;
+    interface.interfaceIndex = link.index;
+    interface.physicalAddress = link.macAddress;
+    interface.networkOrSsid = getNetworkForInterface(snapshot, link.name);
+
+    if (checkWirelessByIfName(link.name)) {
         interface.interfaceType = NETWORK_INTERFACE_WIFI;
         interface.friendlyName = "Wi-Fi";
     } else {
@@ -271,52 +402,52 @@ static void populateInterface(const QString &ifname, types::NetworkInterface &in
         interface.friendlyName = "Ethernet";
     }
 
-    interface.active = isActiveByIfName(ifname);
+    interface.active = (link.flags & (IFF_UP | IFF_RUNNING)) == (IFF_UP | IFF_RUNNING);
+    return interface;
 }
 
 QList<types::NetworkInterface> currentNetworkInterfaces(bool includeNoInterface)
 {
     QList<types::NetworkInterface> interfaces;
-    QStringList names;
 
     if (includeNoInterface) {
         interfaces.push_back(types::NetworkInterface::noNetworkInterface());
     }
 
-    QDir dir("/sys/class/net");
-    names = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    // sorted by name, like the listing of /sys/class/net
+    const auto snapshot = networkSnapshot();
+    QVector<const NetworkSnapshot::Link *> links;
+    for (const auto &link : snapshot->links) {
+        links.push_back(&link);
+    }
+    std::sort(links.begin(), links.end(), [](const NetworkSnapshot::Link *a, const NetworkSnapshot::Link *b) {
+        return a->name < b->name;
+    });
 
-    for (const QString name : names) {
-        interfaces.push_back(networkInterfaceByName(name));
+    for (const auto *link : links) {
+        interfaces.push_back(interfaceForLink(*snapshot, *link));
     }
     return interfaces;
 }
 
 types::NetworkInterface networkInterfaceByName(const QString &name)
 {
-    types::NetworkInterface interface = types::NetworkInterface::noNetworkInterface();
-
-    // Exclude loopback type
-    QString type;
-    QFile f("/sys/class/net/" + name + "/type");
-    if (f.open(QFile::ReadOnly | QFile::Text)) {
-        QTextStream in(&f);
-        type = in.readAll().trimmed();
-    }
-
-    bool ok = false;
-    if (!type.isEmpty()) {
-        int interfaceType = type.toInt(&ok);
-        if (!ok || interfaceType == ARPHRD_LOOPBACK) {
-            return interface;
-        }
+    if (name.isEmpty()) {
+        return types::NetworkInterface::noNetworkInterface();
     }
 
-    if (!name.isEmpty()) {
-        populateInterface(name, interface);
+    const auto snapshot = networkSnapshot();
+    const NetworkSnapshot::Link *link = snapshot->linkByName(name);
+    if (!link) {
+        // the interface is gone, it is reported as inactive
+        types::NetworkInterface interface = types::NetworkInterface::noNetworkInterface();
+        interface.interfaceName = name;
+        interface.interfaceType = NETWORK_INTERFACE_ETH;
+        interface.friendlyName = "Ethernet";
+        interface.active = false;
+        return interface;
     }
-
-    return interface;
+    return interfaceForLink(*snapshot, *link);
 }
 
 } // namespace NetworkUtils_linux
@@ -2,26 +2,21 @@
 
 #include <QList>
 #include <QString>
+#include <QVector>
+#include <functional>
 
 #include "types/networkinterface.h"
 
 namespace NetworkUtils_linux
 {
 
-class RoutingTableEntry
-{
-public:
-    int metric = 0;
-    int mtu = 0;
-    int flags = 0;
-    int netmask = 0;
-    QString interface;
-    QString gateway;
-    QString destination;
-};
-
 void getDefaultRoute(QString &outGatewayIp, QString &outInterfaceName, QString &outAdapterIp, bool ignoreTun = false);
 bool pingWithMtu(const QString &url, int mtu);
+// Finds the largest of the ICMP echo payload sizes (ascending) that gets a reply from the host with the DF bit set.
+// Probes several sizes at a time on an unprivileged ICMP socket, starting with hintSize if it is one of the sizes.
+// Returns false if the ICMP sockets are not allowed for the user (net.ipv4.ping_group_range), outSize is -1 if no size got a reply.
+bool findMaxPingPayload(const QString &url, const QVector<int> &sizes, int hintSize, const std::function<bool()> &isCancelled, int &outSize);
+// The routes, addresses and interfaces come from the shared network snapshot (network_snapshot_linux.h).
 QString getLocalIP();
 QString getRoutingTable();
 QList<types::NetworkInterface> currentNetworkInterfaces(bool includeNoInterface);
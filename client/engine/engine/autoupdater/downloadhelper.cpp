@@ -152,21 +152,6 @@ void DownloadHelper::onReplyDownloadProgress(std::uint64_t requestId, std::uint6
     emit progressChanged(progressPercent_);
 }
 
-void DownloadHelper::onReplyReadyRead(std::uint64_t requestId, const std::string &data)
-{
-    auto it = replies_.find(requestId);
-    if (it == replies_.end()) {
-        return;
-    }
-    if (!data.empty()) {
-        if (it->second->file.isOpen()) {
-            it->second->file.write(data.c_str(), data.size());
-        } else {
-            qCWarning(LOG_DOWNLOADER) << "Download error occurred (file not opened)";
-        }
-    }
-}
-
 void DownloadHelper::getInner(const QString url, const QString targetFilenamePath)
 {
     // remove a previously used file if it exists
@@ -174,12 +159,6 @@ void DownloadHelper::getInner(const QString url, const QString targetFilenamePat
     qCDebug(LOG_DOWNLOADER) << "Starting download from url: " << url;
 
     auto fileAndProgess = std::make_unique<FileAndProgress>();
-    fileAndProgess->file.setFileName(targetFilenamePath);
-    if (!fileAndProgess->file.open(QIODevice::WriteOnly))
-    {
-        qCWarning(LOG_DOWNLOADER) << "Failed to open file for download" << url;
-        return;
-    }
 
     auto callbackFinished = [this] (std::uint64_t requestId, std::uint32_t elapsedMs,
                                     std::shared_ptr<WSNetRequestError> error, const std::string &data)
@@ -196,16 +175,12 @@ void DownloadHelper::getInner(const QString url, const QString targetFilenamePat
         }) ;
     };
 
-    auto callbackReadyData = [this] (std::uint64_t requestId, const std::string &data) {
-        QMetaObject::invokeMethod(this, [this, requestId, data] { // NOLINT: false positive for memory leak
-            onReplyReadyRead(requestId, data);
-        }) ;
-    };
-
     auto httpRequest = WSNet::instance()->httpNetworkManager()->createGetRequest(url.toStdString(), (std::uint16_t)(60000 * 5));  // timeout 5 mins
     httpRequest->setRemoveFromWhitelistIpsAfterFinish(true);
+    // wsnet writes the data to the file itself, without passing it through this thread
+    httpRequest->setOutputFilePath(QDir::toNativeSeparators(targetFilenamePath).toStdString());
 
-    fileAndProgess->request = WSNet::instance()->httpNetworkManager()->executeRequestEx(httpRequest, uniqueRequestId_, callbackFinished, callbackProgress, callbackReadyData);
+    fileAndProgess->request = WSNet::instance()->httpNetworkManager()->executeRequestEx(httpRequest, uniqueRequestId_, callbackFinished, callbackProgress);
     replies_[uniqueRequestId_] = std::move(fileAndProgess);
     uniqueRequestId_++;
 }
@@ -2,7 +2,6 @@
 
 #include <QString>
 #include <QObject>
-#include <QFile>
 #include <QSharedPointer>
 #include <QMap>
 #include <wsnet/WSNet.h>
@@ -36,7 +35,6 @@ private:
 
     struct FileAndProgress {
         std::shared_ptr<wsnet::WSNetCancelableCallback> request;
-        QFile file;
         qint64 bytesReceived = 0;
         qint64 bytesTotal = 0;
         bool done = false;
@@ -59,5 +57,4 @@ private:
                          std::shared_ptr<wsnet::WSNetRequestError> error, const std::string &data);
     void onReplyDownloadProgress(std::uint64_t requestId, std::uint64_t bytesReceived,
                                  std::uint64_t bytesTotal);
-    void onReplyReadyRead(std::uint64_t requestId, const std::string &data);
 };
@@ -1,4 +1,7 @@
 #include "wireguardconnection_posix.h"
+
+#include <algorithm>
+
 #include "utils/ws_assert.h"
 #include "utils/crashhandler.h"
 #include "utils/log/categories.h"
@@ -203,6 +206,7 @@ void WireGuardConnection::run()
     quint64 bytesTransmitted = 0;
     bool is_configured = false;
     bool is_connected = false;
+    unsigned int idle_status_check_ms = kStatusCheckActiveMs;
     QElapsedTimer elapsedTimer;
     elapsedTimer.start();
 
@@ -225,6 +229,8 @@ void WireGuardConnection::run()
                 pimpl_->disconnect();
                 break;
             }
+            if (status.state != types::WireGuardState::ACTIVE)
+                idle_status_check_ms = kStatusCheckActiveMs;
             switch (status.state) {
             case types::WireGuardState::NONE:
                 // Not initialized.
@@ -263,8 +269,13 @@ void WireGuardConnection::run()
                     bytesReceived = status.bytesReceived;
                     bytesTransmitted = status.bytesTransmitted;
                     emit statisticsUpdated(newBytesReceived, newBytesTransmitted, false);
+                    idle_status_check_ms = kStatusCheckActiveMs;
+                } else {
+                    // Nothing to report while the tunnel is idle, poll less often. The helper still reports an error
+                    // when the handshake gets stale, so a broken tunnel is noticed within kStatusCheckIdleMaxMs.
+                    idle_status_check_ms = std::min(idle_status_check_ms * 2, kStatusCheckIdleMaxMs);
                 }
-                next_status_check_ms = 500u;
+                next_status_check_ms = idle_status_check_ms;
                 break;
             }
             }
@@ -274,7 +285,9 @@ void WireGuardConnection::run()
             setError(STATE_TIMEOUT_FOR_AUTOMATIC);
         }
 
-        QThread::msleep(next_status_check_ms);
+        // sleep in short slices, a stop request should not wait for a long idle interval
+        for (unsigned int slept_ms = 0; slept_ms < next_status_check_ms && !do_stop_thread_; slept_ms += 100u)
+            QThread::msleep(std::min(100u, next_status_check_ms - slept_ms));
     }
 }
 
@@ -42,6 +42,8 @@ private:
     enum class ConnectionState { DISCONNECTED, CONNECTING, CONNECTED };
     static constexpr int PROCESS_KILL_TIMEOUT = 10000;
     static constexpr int kTimeoutForAutomatic = 20000;  // 20 secs timeout for the automatic connection mode
+    static constexpr unsigned int kStatusCheckActiveMs = 500;
+    static constexpr unsigned int kStatusCheckIdleMaxMs = 8000;
 
     ConnectionState getCurrentState() const;
     void setCurrentState(ConnectionState state);
@@ -1790,7 +1790,9 @@ void Engine::detectAppropriatePacketSizeImpl()
         qCDebug(LOG_PACKET_SIZE) << "Detecting appropriate packet size";
         runningPacketDetection_ = true;
         emit packetSizeDetectionStateChanged(true, false);
-        packetSizeController_->detectAppropriatePacketSize(HardcodedSettings::instance().windscribeHost());
+        types::NetworkInterface networkInterface;
+        networkDetectionManager_->getCurrentNetworkInterface(networkInterface);
+        packetSizeController_->detectAppropriatePacketSize(HardcodedSettings::instance().windscribeHost(), networkInterface.networkOrSsid);
     }
     else
     {
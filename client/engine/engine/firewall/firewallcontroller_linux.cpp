@@ -99,6 +99,13 @@ bool FirewallController_linux::firewallOnImpl(const QString &connectingIp, const
     forceUpdateInterfaceToSkip_ = false;
     bool bExists = firewallActualState();
 
+    // The helper keeps the allowed addresses in an ipset, so the chains have a constant number of rules
+    // and an update of the addresses only sends the difference to the kernel
+    const bool isAllowIpSet = helper_->setFirewallAllowIps(ips);
+    if (!isAllowIpSet) {
+        qCInfo(LOG_FIREWALL_CONTROLLER) << "ipset is unavailable, adding a rule per address";
+    }
+
     // rules for IPv4
     {
         QStringList rules;
@@ -168,9 +175,14 @@ bool FirewallController_linux::firewallOnImpl(const QString &connectingIp, const
             rules << "-A windscribe_output -d " + connectingIp + "/32 -j ACCEPT -m mark --mark 51820 -m comment --comment \"" + comment_ + "\"\n";
         }
 
-        for (const auto &i : ips) {
-            rules << "-A windscribe_input -s " + i + "/32 -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
-            rules << "-A windscribe_output -d " + i + "/32 -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+        if (isAllowIpSet) {
+            rules << "-A windscribe_input -m set --match-set " + kAllowIpSet + " src -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+            rules << "-A windscribe_output -m set --match-set " + kAllowIpSet + " dst -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+        } else {
+            for (const auto &i : ips) {
+                rules << "-A windscribe_input -s " + i + "/32 -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+                rules << "-A windscribe_output -d " + i + "/32 -j ACCEPT -m comment --comment \"" + comment_ + "\"\n";
+            }
         }
 
         // drop filter for the hotspot adapter in the disconnected state
@@ -22,6 +22,9 @@ public:
     void setFirewallOnBoot(bool bEnable, const QSet<QString>& ipTable = QSet<QString>(), bool isAllowLanTraffic = false) override;
 
 private:
+    // the name of the set the helper fills with the allowed addresses
+    inline static const QString kAllowIpSet = "windscribe_allow";
+
     Helper_linux *helper_;
     QString interfaceToSkip_;
     bool forceUpdateInterfaceToSkip_;
@@ -51,11 +51,7 @@ bool Helper_linux::setDnsLeakProtectEnabled(bool bEnabled)
     CMD_SET_DNS_LEAK_PROTECT_ENABLED cmd;
     cmd.enabled = bEnabled;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_SET_DNS_LEAK_PROTECT_ENABLED, stream.str(), answer);
+    return runCommand(HELPER_CMD_SET_DNS_LEAK_PROTECT_ENABLED, serializeCommand(cmd), answer);
 }
 
 bool Helper_linux::resetMacAddresses(const QString &ignoreNetwork)
@@ -66,10 +62,20 @@ bool Helper_linux::resetMacAddresses(const QString &ignoreNetwork)
     CMD_RESET_MAC_ADDRESSES cmd;
     cmd.ignoreNetwork = ignoreNetwork.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
+    return runCommand(HELPER_CMD_RESET_MAC_ADDRESSES, serializeCommand(cmd), answer) && answer.executed;
+}
+
+bool Helper_linux::setFirewallAllowIps(const QSet<QString> &ips)
+{
+    QMutexLocker locker(&mutex_);
+
+    CMD_ANSWER answer;
+    CMD_SET_FIREWALL_ALLOW_IPS cmd;
+    cmd.ips.reserve(ips.size());
+    for (const auto &ip : ips) {
+        cmd.ips.push_back(ip.toStdString());
+    }
 
-    return runCommand(HELPER_CMD_RESET_MAC_ADDRESSES, stream.str(), answer) && answer.executed;
+    return runCommand(HELPER_CMD_SET_FIREWALL_ALLOW_IPS, serializeCommand(cmd), answer) && answer.executed;
 }
 
@@ -18,4 +18,6 @@ public:
     std::optional<bool> installUpdate(const QString& package) const;
     bool setDnsLeakProtectEnabled(bool bEnabled);
     bool resetMacAddresses(const QString &ignoreNetwork = "");
+    // false if the helper can't keep the addresses in an ipset (no kernel support or an older helper)
+    bool setFirewallAllowIps(const QSet<QString> &ips);
 };
@@ -91,11 +91,7 @@ QString Helper_mac::getInterfaceSsid(const QString &interfaceName)
     CMD_ANSWER answer;
     cmd.interface = interfaceName.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    if (runCommand(HELPER_CMD_GET_INTERFACE_SSID, stream.str(), answer)) {
+    if (runCommand(HELPER_CMD_GET_INTERFACE_SSID, serializeCommand(cmd), answer)) {
         return QString::fromStdString(answer.body);
     } else {
         return "";
@@ -112,11 +108,7 @@ bool Helper_mac::enableMacSpoofingOnBoot(bool bEnabled, const QString &interface
     cmd.interface = interface.toStdString();
     cmd.macAddress = macAddress.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_SET_MAC_SPOOFING_ON_BOOT, stream.str(), answer);
+    return runCommand(HELPER_CMD_SET_MAC_SPOOFING_ON_BOOT, serializeCommand(cmd), answer);
 }
 
 bool Helper_mac::setDnsOfDynamicStoreEntry(const QString &ipAddress, const QString &entry)
@@ -130,12 +122,8 @@ bool Helper_mac::setDnsOfDynamicStoreEntry(const QString &ipAddress, const QStri
     if (curState_ != STATE_CONNECTED)
         return false;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (runCommand(HELPER_CMD_APPLY_CUSTOM_DNS, stream.str(), answer)) {
+    if (runCommand(HELPER_CMD_APPLY_CUSTOM_DNS, serializeCommand(cmd), answer)) {
         return answer.executed != 0;
     } else {
         return false;
@@ -150,11 +138,7 @@ bool Helper_mac::setIpv6Enabled(bool bEnabled)
     CMD_SET_IPV6_ENABLED cmd;
     cmd.enabled = bEnabled;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_SET_IPV6_ENABLED, stream.str(), answer);
+    return runCommand(HELPER_CMD_SET_IPV6_ENABLED, serializeCommand(cmd), answer);
 }
 
 void Helper_mac::doDisconnectAndReconnect()
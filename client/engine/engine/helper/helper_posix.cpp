@@ -31,7 +31,7 @@ Helper_posix *g_this_ = NULL;
 
 Helper_posix::Helper_posix(QObject *parent) : IHelper(parent), bIPV6State_(true), cmdId_(0), lastOpenVPNCmdId_(0)
   , ep_(SOCK_PATH), bHelperConnectedEmitted_(false)
-  , curState_(STATE_INIT), bNeedFinish_(false), firstConnectToHelperErrorReported_(false)
+  , curState_(STATE_INIT), bNeedFinish_(false), isBinaryEncoding_(false), firstConnectToHelperErrorReported_(false)
 {
     WS_ASSERT(g_this_ == NULL);
     g_this_ = this;
@@ -68,12 +68,8 @@ void Helper_posix::getUnblockingCmdStatus(unsigned long cmdId, QString &outLog,
     CMD_GET_CMD_STATUS cmd;
     cmd.cmdId = cmdId;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_GET_CMD_STATUS, stream.str(), answer) || answer.executed == 0) {
+    if (!runCommand(HELPER_CMD_GET_CMD_STATUS, serializeCommand(cmd), answer) || answer.executed == 0) {
         doDisconnectAndReconnect();
         return;
     }
@@ -94,12 +90,8 @@ void Helper_posix::clearUnblockingCmd(unsigned long cmdId)
 
     CMD_CLEAR_CMDS cmd;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_CLEAR_CMDS, stream.str(), answer)) {
+    if (!runCommand(HELPER_CMD_CLEAR_CMDS, serializeCommand(cmd), answer)) {
         doDisconnectAndReconnect();
     }
 }
@@ -137,12 +129,8 @@ bool Helper_posix::setSplitTunnelingSettings(bool isActive, bool isExclude,
         cmdSplitTunnelingSettings.hosts.push_back(hosts[i].toStdString());
     }
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmdSplitTunnelingSettings;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_SPLIT_TUNNELING_SETTINGS, stream.str(), answer)) {
+    if (!runCommand(HELPER_CMD_SPLIT_TUNNELING_SETTINGS, serializeCommand(cmdSplitTunnelingSettings), answer)) {
         doDisconnectAndReconnect();
         return false;
     }
@@ -198,12 +186,8 @@ bool Helper_posix::sendConnectStatus(bool isConnected, bool isTerminateSocket, b
         cmd.remoteIp = vpnAdapter.remoteIp().toStdString();
     }
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_SEND_CONNECT_STATUS, stream.str(), answer)) {
+    if (!runCommand(HELPER_CMD_SEND_CONNECT_STATUS, serializeCommand(cmd), answer)) {
         doDisconnectAndReconnect();
         return false;
     }
@@ -223,11 +207,7 @@ bool Helper_posix::changeMtu(const QString &adapter, int mtu)
     cmd.mtu = mtu;
     cmd.adapterName = adapter.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_CHANGE_MTU, stream.str(), answer);
+    return runCommand(HELPER_CMD_CHANGE_MTU, serializeCommand(cmd), answer);
 }
 
 bool Helper_posix::deleteRoute(const QString &range, int mask, const QString &gateway)
@@ -240,11 +220,7 @@ bool Helper_posix::deleteRoute(const QString &range, int mask, const QString &ga
     cmd.mask = mask;
     cmd.gateway = gateway.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_DELETE_ROUTE, stream.str(), answer);
+    return runCommand(HELPER_CMD_DELETE_ROUTE, serializeCommand(cmd), answer);
 }
 
 IHelper::ExecuteError Helper_posix::startWireGuard()
@@ -315,12 +291,8 @@ bool Helper_posix::configureWireGuard(const WireGuardConfig &config)
     cmd.allowedIps = config.peerAllowedIps().toLatin1().data();
     cmd.listenPort = config.clientListenPort().toUInt();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_CONFIGURE_WIREGUARD, stream.str(), answer) || answer.executed == 0) {
+    if (!runCommand(HELPER_CMD_CONFIGURE_WIREGUARD, serializeCommand(cmd), answer) || answer.executed == 0) {
         qCCritical(LOG_WIREGUARD) << "WireGuard configuration failed";
         doDisconnectAndReconnect();
         return false;
@@ -396,12 +368,8 @@ bool Helper_posix::startCtrld(const QString &upstream1, const QString &upstream2
     cmd.domains = domainsList;
     cmd.isCreateLog = isCreateLog;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_START_CTRLD, stream.str(), answer) || answer.executed == 0) {
+    if (!runCommand(HELPER_CMD_START_CTRLD, serializeCommand(cmd), answer) || answer.executed == 0) {
         qCCritical(LOG_BASIC) << "helper returned error starting ctrld";
         doDisconnectAndReconnect();
         return false;
@@ -449,12 +417,8 @@ IHelper::ExecuteError Helper_posix::executeOpenVPN(const QString &config, unsign
     }
 #endif
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_START_OPENVPN, stream.str(), answer) || answer.executed == 0) {
+    if (!runCommand(HELPER_CMD_START_OPENVPN, serializeCommand(cmd), answer) || answer.executed == 0) {
         doDisconnectAndReconnect();
         return IHelper::EXECUTE_ERROR;
     }
@@ -471,11 +435,7 @@ bool Helper_posix::executeTaskKill(CmdKillTarget target)
     CMD_ANSWER answer;
     cmd.target = target;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_TASK_KILL, stream.str(), answer);
+    return runCommand(HELPER_CMD_TASK_KILL, serializeCommand(cmd), answer);
 }
 
 bool Helper_posix::setDnsScriptEnabled(bool bEnabled)
@@ -486,11 +446,7 @@ bool Helper_posix::setDnsScriptEnabled(bool bEnabled)
     CMD_ANSWER answer;
     cmd.enabled = bEnabled;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_SET_DNS_SCRIPT_ENABLED, stream.str(), answer);
+    return runCommand(HELPER_CMD_SET_DNS_SCRIPT_ENABLED, serializeCommand(cmd), answer);
 }
 
 bool Helper_posix::checkFirewallState(const QString &tag)
@@ -501,11 +457,7 @@ bool Helper_posix::checkFirewallState(const QString &tag)
     CMD_ANSWER answer;
     cmd.tag = tag.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    if (!runCommand(HELPER_CMD_CHECK_FIREWALL_STATE, stream.str(), answer)) {
+    if (!runCommand(HELPER_CMD_CHECK_FIREWALL_STATE, serializeCommand(cmd), answer)) {
         return false;
     }
     return answer.exitCode != 0;
@@ -519,11 +471,7 @@ bool Helper_posix::clearFirewallRules(bool isKeepPfEnabled)
     CMD_ANSWER answer;
     cmd.isKeepPfEnabled = isKeepPfEnabled;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_CLEAR_FIREWALL_RULES, stream.str(), answer);
+    return runCommand(HELPER_CMD_CLEAR_FIREWALL_RULES, serializeCommand(cmd), answer);
 }
 
 bool Helper_posix::setFirewallRules(CmdIpVersion version, const QString &table, const QString &group, const QString &rules)
@@ -537,11 +485,7 @@ bool Helper_posix::setFirewallRules(CmdIpVersion version, const QString &table,
     cmd.group = group.toStdString();
     cmd.rules = rules.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_SET_FIREWALL_RULES, stream.str(), answer);
+    return runCommand(HELPER_CMD_SET_FIREWALL_RULES, serializeCommand(cmd), answer);
 }
 
 bool Helper_posix::getFirewallRules(CmdIpVersion version, const QString &table, const QString &group, QString &rules)
@@ -554,11 +498,7 @@ bool Helper_posix::getFirewallRules(CmdIpVersion version, const QString &table,
     cmd.table = table.toStdString();
     cmd.group = group.toStdString();
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    if (!runCommand(HELPER_CMD_GET_FIREWALL_RULES, stream.str(), answer)) {
+    if (!runCommand(HELPER_CMD_GET_FIREWALL_RULES, serializeCommand(cmd), answer)) {
         return false;
     }
     rules = QString::fromStdString(answer.body);
@@ -582,11 +522,7 @@ bool Helper_posix::setFirewallOnBoot(bool enabled, const QSet<QString> &ipTable,
 
     cmd.ipTable = ipTableStr;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_SET_FIREWALL_ON_BOOT, stream.str(), answer);
+    return runCommand(HELPER_CMD_SET_FIREWALL_ON_BOOT, serializeCommand(cmd), answer);
 }
 
 bool Helper_posix::setMacAddress(const QString &interface, const QString &macAddress, const QString &network, bool isWifi)
@@ -600,11 +536,7 @@ bool Helper_posix::setMacAddress(const QString &interface, const QString &macAdd
     cmd.network = network.toStdString();
     cmd.isWifi = isWifi;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
-    return runCommand(HELPER_CMD_SET_MAC_ADDRESS, stream.str(), answer) && answer.executed;
+    return runCommand(HELPER_CMD_SET_MAC_ADDRESS, serializeCommand(cmd), answer) && answer.executed;
 }
 
 bool Helper_posix::startStunnel(const QString &hostname, unsigned int port, unsigned int localPort, bool extraPadding)
@@ -617,12 +549,8 @@ bool Helper_posix::startStunnel(const QString &hostname, unsigned int port, unsi
     cmd.localPort = localPort;
     cmd.extraPadding = extraPadding;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_START_STUNNEL, stream.str(), answer) || answer.executed == 0) {
+    if (!runCommand(HELPER_CMD_START_STUNNEL, serializeCommand(cmd), answer) || answer.executed == 0) {
         doDisconnectAndReconnect();
         return IHelper::EXECUTE_ERROR;
     }
@@ -639,12 +567,8 @@ bool Helper_posix::startWstunnel(const QString &hostname, unsigned int port, uns
     cmd.port = port;
     cmd.localPort = localPort;
 
-    std::stringstream stream;
-    boost::archive::text_oarchive oa(stream, boost::archive::no_header);
-    oa << cmd;
-
     CMD_ANSWER answer;
-    if (!runCommand(HELPER_CMD_START_WSTUNNEL, stream.str(), answer) || answer.executed == 0) {
+    if (!runCommand(HELPER_CMD_START_WSTUNNEL, serializeCommand(cmd), answer) || answer.executed == 0) {
         doDisconnectAndReconnect();
         return IHelper::EXECUTE_ERROR;
     }
@@ -667,6 +591,7 @@ void Helper_posix::connectHandler(const boost::system::error_code &ec)
 {
     if (!ec) {
         // we connected
+        g_this_->isBinaryEncoding_ = g_this_->startSession();
         g_this_->curState_ = STATE_CONNECTED;
         //emit signal only once on first run
         if (!g_this_->bHelperConnectedEmitted_) {
@@ -737,8 +662,13 @@ bool Helper_posix::readAnswer(CMD_ANSWER &outAnswer)
 
         std::string str(buff.begin(), buff.end());
         std::istringstream stream(str);
-        boost::archive::text_iarchive ia(stream, boost::archive::no_header);
-        ia >> outAnswer;
+        if (isBinaryEncoding_) {
+            boost::archive::binary_iarchive ia(stream, boost::archive::no_header);
+            ia >> outAnswer;
+        } else {
+            boost::archive::text_iarchive ia(stream, boost::archive::no_header);
+            ia >> outAnswer;
+        }
     }
 
     return true;
@@ -747,30 +677,37 @@ bool Helper_posix::readAnswer(CMD_ANSWER &outAnswer)
 bool Helper_posix::sendCmdToHelper(int cmdId, const std::string &data)
 {
     int length = data.size();
+    const auto pid = getpid();
     boost::system::error_code ec;
 
-    // first 4 bytes - cmdId
-    boost::asio::write(*socket_, boost::asio::buffer(&cmdId, sizeof(cmdId)), boost::asio::transfer_exactly(sizeof(cmdId)), ec);
-    if (ec) {
-        return false;
-    }
-    // second 4 bytes - pid
-    const auto pid = getpid();
-    boost::asio::write(*socket_, boost::asio::buffer(&pid, sizeof(pid)), boost::asio::transfer_exactly(sizeof(pid)), ec);
+    // header: 4 bytes - cmdId, 4 bytes - pid, 4 bytes - size of buffer; then the body of message. All with one write.
+    std::array<boost::asio::const_buffer, 4> buffers = {
+        boost::asio::buffer(&cmdId, sizeof(cmdId)),
+        boost::asio::buffer(&pid, sizeof(pid)),
+        boost::asio::buffer(&length, sizeof(length)),
+        boost::asio::buffer(data.data(), length)
+    };
+    boost::asio::write(*socket_, buffers, boost::asio::transfer_all(), ec);
     if (ec) {
+        doDisconnectAndReconnect();
         return false;
     }
-    // third 4 bytes - size of buffer
-    boost::asio::write(*socket_, boost::asio::buffer(&length, sizeof(length)), boost::asio::transfer_exactly(sizeof(length)), ec);
-    if (ec) {
+
+    return true;
+}
+
+bool Helper_posix::startSession()
+{
+    // the request and the answer are always in the text encoding
+    isBinaryEncoding_ = false;
+
+    CMD_ANSWER answer;
+    if (!sendCmdToHelper(HELPER_CMD_START_SESSION, std::string()) || !readAnswer(answer)) {
         return false;
     }
-    // body of message
-    boost::asio::write(*socket_, boost::asio::buffer(data.data(), length), boost::asio::transfer_exactly(length), ec);
-    if (ec) {
-        doDisconnectAndReconnect();
+    if (answer.executed != 1) {
+        qCInfo(LOG_BASIC) << "The helper does not support the sessions, the text encoding is used";
         return false;
     }
-
     return true;
 }
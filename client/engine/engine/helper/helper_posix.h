@@ -119,6 +119,25 @@ protected:
     bool sendCmdToHelper(int cmdId, const std::string &data);
     virtual bool runCommand(int cmdId, const std::string &data, CMD_ANSWER &answer);
 
+    // The helper verifies the app once per connection. A helper that supports the sessions switches the connection
+    // to the binary encoding, the older ones answer an unknown command and the text encoding stays.
+    bool startSession();
+    std::atomic<bool> isBinaryEncoding_;
+
+    template<typename T>
+    std::string serializeCommand(const T &cmd) const
+    {
+        std::ostringstream stream;
+        if (isBinaryEncoding_) {
+            boost::archive::binary_oarchive oa(stream, boost::archive::no_header);
+            oa << cmd;
+        } else {
+            boost::archive::text_oarchive oa(stream, boost::archive::no_header);
+            oa << cmd;
+        }
+        return stream.str();
+    }
+
 private:
     bool firstConnectToHelperErrorReported_;
 };
@@ -39,8 +39,10 @@ void ApiLocationsModel::setLocations(const QVector<api_responses::Location> &loc
         for (int i = 0; i < l.groupsCount(); ++i) {
             api_responses::Group group = l.getGroup(i);
             // Ping with Curl by hostname was introduced later, so the ping hostname may be empty when updating the program from an older version.
+            // The TLS handshake ping ranks the best location by the network round trip and not by the HTTP request overhead,
+            // the hostname is its SNI and the URL of the HTTP ping used as the fallback.
             if (!group.getPingHost().isEmpty()) {
-                ips << PingIpInfo { group.getPingIp(), group.getPingHost(), group.getCity(), group.getNick(), wsnet::PingType::kHttp };
+                ips << PingIpInfo { group.getPingIp(), group.getPingHost(), group.getCity(), group.getNick(), wsnet::PingType::kTls };
             }
         }
     }
@@ -49,7 +51,7 @@ void ApiLocationsModel::setLocations(const QVector<api_responses::Location> &loc
     for (int i = 0; i < staticIps_.getIpsCount(); ++i) {
         const api_responses::StaticIpDescr &sid = staticIps_.getIp(i);
         if (!sid.getPingHost().isEmpty()) {
-            ips << PingIpInfo { sid.getPingIp(), sid.getPingHost(), sid.name, "staticIP", wsnet::PingType::kHttp };
+            ips << PingIpInfo { sid.getPingIp(), sid.getPingHost(), sid.name, "staticIP", wsnet::PingType::kTls };
         }
     }
 
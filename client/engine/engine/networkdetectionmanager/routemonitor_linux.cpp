@@ -2,11 +2,13 @@
 
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
+#include <errno.h>
 #include <stdio.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
 #include "utils/log/categories.h"
+#include "utils/network_utils/network_snapshot_linux.h"
 #include "utils/ws_assert.h"
 
 RouteMonitor_linux::RouteMonitor_linux(QObject *parent) : QObject(parent)
@@ -32,7 +34,8 @@ void RouteMonitor_linux::init()
     memset(&addr, 0, sizeof(addr));
     addr.nl_family = AF_NETLINK;
     addr.nl_pid    = getpid();
-    addr.nl_groups = RTMGRP_IPV4_ROUTE;
+    // the address and link changes keep the network snapshot current, only the route changes are signaled
+    addr.nl_groups = RTMGRP_IPV4_ROUTE | RTMGRP_IPV4_IFADDR | RTMGRP_LINK;
 
     if (bind(fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         qCCritical(LOG_BASIC) << "RouteMonitor_linux could not bind address";
@@ -43,6 +46,7 @@ void RouteMonitor_linux::init()
     notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
     connect(notifier_, &QSocketNotifier::activated, this, &RouteMonitor_linux::netlinkSocketReady);
     notifier_->setEnabled(true);
+    NetworkUtils_linux::setNetworkSnapshotMonitored(true);
 }
 
 void RouteMonitor_linux::finish()
@@ -50,6 +54,7 @@ void RouteMonitor_linux::finish()
     if (notifier_) {
         notifier_->setEnabled(false);
     }
+    NetworkUtils_linux::setNetworkSnapshotMonitored(false);
 }
 
 void RouteMonitor_linux::netlinkSocketReady(QSocketDescriptor socket, QSocketNotifier::Type activationEvent)
@@ -57,9 +62,30 @@ void RouteMonitor_linux::netlinkSocketReady(QSocketDescriptor socket, QSocketNot
     Q_UNUSED(socket)
     Q_UNUSED(activationEvent)
 
-    char buffer[4096];
-    ssize_t len = recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
-    if (len >= 0) {
+    // read everything queued, a burst of changes is signaled once
+    bool isRoutesChanged = false;
+    char buffer[8192];
+    while (true) {
+        ssize_t len = recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == ENOBUFS) {
+                // the socket buffer overflowed and some notifications are lost
+                isRoutesChanged = true;
+                continue;
+            }
+            break;
+        }
+
+        for (auto *nlh = reinterpret_cast<struct nlmsghdr *>(buffer); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_DELROUTE) {
+                isRoutesChanged = true;
+            }
+        }
+        NetworkUtils_linux::invalidateNetworkSnapshot();
+    }
+
+    if (isRoutesChanged) {
+        NetworkUtils_linux::invalidateNetworkSnapshot();
         emit routesChanged();
     }
 }
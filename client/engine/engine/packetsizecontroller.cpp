@@ -4,6 +4,10 @@
 #include "utils/log/categories.h"
 #include "utils/network_utils/network_utils.h"
 
+#ifdef Q_OS_LINUX
+    #include "utils/network_utils/network_utils_linux.h"
+#endif
+
 PacketSizeController::PacketSizeController(QObject *parent)
     : QObject(parent),
       earlyStop_(false)
@@ -30,10 +34,10 @@ void PacketSizeController::setPacketSize(const types::PacketSize &packetSize)
     setPacketSizeImpl(packetSize);
 }
 
-void PacketSizeController::detectAppropriatePacketSize(const QString &hostname)
+void PacketSizeController::detectAppropriatePacketSize(const QString &hostname, const QString &network)
 {
     QMutexLocker locker(&mutex_);
-    QMetaObject::invokeMethod(this, "detectAppropriatePacketSizeImpl", Q_ARG(QString, hostname));
+    QMetaObject::invokeMethod(this, "detectAppropriatePacketSizeImpl", Q_ARG(QString, hostname), Q_ARG(QString, network));
 }
 
 void PacketSizeController::earlyStop()
@@ -51,15 +55,19 @@ void PacketSizeController::setPacketSizeImpl(const types::PacketSize &packetSize
     }
 }
 
-void PacketSizeController::detectAppropriatePacketSizeImpl(const QString &hostname)
+void PacketSizeController::detectAppropriatePacketSizeImpl(const QString &hostname, const QString &network)
 {
     {
         QMutexLocker locker(&mutex_);
         earlyStop_ = false;
     }
 
-    const int mtu = getIdealPacketSize(hostname);
+    const int mtu = getIdealPacketSize(hostname, lastMtuForNetwork_.value(network, -1));
     const bool is_error = mtu < 0;
+    if (mtu > 0 && !network.isEmpty())
+    {
+        lastMtuForNetwork_[network] = mtu;
+    }
 
     QMutexLocker locker(&mutex_);
     if (mtu > 0)
@@ -74,7 +82,7 @@ void PacketSizeController::detectAppropriatePacketSizeImpl(const QString &hostna
     emit finishedPacketSizeDetection(is_error);
 }
 
-int PacketSizeController::getIdealPacketSize(const QString &hostname)
+int PacketSizeController::getIdealPacketSize(const QString &hostname, int lastMtu)
 {
     int mtu = 1470;
     QString modifiedHostname = hostname;
@@ -93,6 +101,33 @@ int PacketSizeController::getIdealPacketSize(const QString &hostname)
 
     qCDebug(LOG_PACKET_SIZE) << "Detecting packet size via:" << modifiedHostname;
 
+#ifdef Q_OS_LINUX
+    // The same sizes as the ping loop below, probed in-process several at a time.
+    // The ping command is used if the user is not allowed to open ICMP sockets.
+    QVector<int> sizes;
+    for (int size = 1300; size <= mtu; size += 10)
+    {
+        sizes << size;
+    }
+
+    int foundMtu = -1;
+    const auto isEarlyStop = [this]()
+    {
+        QMutexLocker locker(&mutex_);
+        return earlyStop_;
+    };
+    if (NetworkUtils_linux::findMaxPingPayload(modifiedHostname, sizes, lastMtu, isEarlyStop, foundMtu))
+    {
+        if (foundMtu < 0)
+        {
+            qCWarning(LOG_PACKET_SIZE) << "Couldn't find appropriate MTU -- check internet connection";
+        }
+        return foundMtu;
+    }
+#else
+    Q_UNUSED(lastMtu);
+#endif
+
     bool success = false;
     while (mtu >= 1300)
     {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QHash>
 #include <QObject>
 #include <QMutex>
 #include "types/packetsize.h"
@@ -15,7 +16,8 @@ public:
     explicit PacketSizeController(QObject *parent = nullptr);
 
     void setPacketSize(const types::PacketSize &packetSize);
-    void detectAppropriatePacketSize(const QString &hostname);
+    // network is the network name or SSID, the last result on the network is probed first
+    void detectAppropriatePacketSize(const QString &hostname, const QString &network);
     void earlyStop();
 
 signals:
@@ -27,17 +29,19 @@ public slots:
     void finish();
 
 private slots:
-    void detectAppropriatePacketSizeImpl(const QString &hostname);
+    void detectAppropriatePacketSizeImpl(const QString &hostname, const QString &network);
 
 private:
     QMutex mutex_;
     bool earlyStop_;
     types::PacketSize packetSize_;
+    // used from the thread of the controller only
+    QHash<QString, int> lastMtuForNetwork_;
 
 #ifdef Q_OS_WIN
     QScopedPointer<Debug::CrashHandlerForThread> crashHandler_;
 #endif
 
     void setPacketSizeImpl(const types::PacketSize &packetSize);
-    int getIdealPacketSize(const QString &hostname);
+    int getIdealPacketSize(const QString &hostname, int lastMtu);
 };
@@ -72,7 +72,6 @@ PingTime PingManager::getPing(const QString &ip) const
 
 void PingManager::onPingTimer()
 {
-    using namespace std::placeholders;
     // We don't attempt to issue a ping request when state is CONNECT_STATE_CONNECTING, as the firewall will block it.
     if (!networkDetectionManager_->isOnline() || connectStateController_->currentState() != CONNECT_STATE_DISCONNECTED)
         return;
@@ -103,37 +102,40 @@ void PingManager::onPingTimer()
         if (pni.nowPinging)
             continue;
 
-        // Checking the option ws-use-icmp-pings and force ICMP pings if enabled.
-        wsnet::PingType pingType = pni.ipInfo.pingType;
-        if (isUseIcmpPings_) {
-            pingType = wsnet::PingType::kIcmp;
-        }
-
         if (pni.latestPingFailed) {
             if (pni.nextTimeForFailedPing == 0 || QDateTime::currentMSecsSinceEpoch() >= pni.nextTimeForFailedPing) {
-                pni.nowPinging = true;
                 addLog("PingManager::onPingTimer", "start ping because latest ping failed: " + it.key());
-                WSNet::instance()->pingManager()->ping(pni.ipInfo.ip.toStdString(), pni.ipInfo.hostname.toStdString(), pingType,
-                   [this](const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState) {
-                       QMetaObject::invokeMethod(this, [this, ip, isSuccess, timeMs, isFromDisconnectedVpnState] { // NOLINT: false positive for memory leak
-                           onPingFinished(ip, isSuccess, timeMs, isFromDisconnectedVpnState);
-                    });
-                });
+                startPing(pni);
             }
         } else if (pni.iterationTime != pingStorage_.currentIterationTime()) {
             addLog("PingManager::onPingTimer", QString::fromLatin1("ping new node: %1 (%2 - %3)").arg(pni.ipInfo.ip, pni.ipInfo.city, pni.ipInfo.nick));
-            pni.nowPinging = true;
-            WSNet::instance()->pingManager()->ping(pni.ipInfo.ip.toStdString(), pni.ipInfo.hostname.toStdString(), pingType,
-                                                   [this](const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState) {
-                                                       QMetaObject::invokeMethod(this, [this, ip, isSuccess, timeMs, isFromDisconnectedVpnState] {
-                                                           onPingFinished(ip, isSuccess, timeMs, isFromDisconnectedVpnState);
-                                                       });
-                                                   });
+            startPing(pni);
         }
     }
 }
 
-void PingManager::onPingFinished(const std::string &ip, bool isSuccess, int32_t timeMs, bool isFromDisconnectedVpnState)
+void PingManager::startPing(PingIpState &pni)
+{
+    // Checking the option ws-use-icmp-pings and force ICMP pings if enabled.
+    // A node that does not answer the TCP or TLS ping (e.g. the port is filtered on the network) gets the HTTP ping.
+    wsnet::PingType pingType = pni.ipInfo.pingType;
+    if (isUseIcmpPings_) {
+        pingType = wsnet::PingType::kIcmp;
+    } else if (pni.isHttpFallback) {
+        pingType = wsnet::PingType::kHttp;
+    }
+
+    pni.nowPinging = true;
+    WSNet::instance()->pingManager()->ping(pni.ipInfo.ip.toStdString(), pni.ipInfo.hostname.toStdString(), pingType,
+        [this](const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState, std::int32_t connectTimeMs, std::int32_t handshakeTimeMs) {
+            QMetaObject::invokeMethod(this, [=] { // NOLINT: false positive for memory leak
+                onPingFinished(ip, isSuccess, timeMs, isFromDisconnectedVpnState, connectTimeMs, handshakeTimeMs);
+            });
+        });
+}
+
+void PingManager::onPingFinished(const std::string &ip, bool isSuccess, int32_t timeMs, bool isFromDisconnectedVpnState,
+                                 std::int32_t connectTimeMs, std::int32_t handshakeTimeMs)
 {
     Q_UNUSED(isFromDisconnectedVpnState);
     QString ipStr = QString::fromStdString(ip);
@@ -158,7 +160,8 @@ void PingManager::onPingFinished(const std::string &ip, bool isSuccess, int32_t
             p.iterationTime = pingStorage_.currentIterationTime();
             pingStorage_.setPing(ipStr, timeMs);
             emit pingInfoChanged(ipStr, timeMs);
-            addLog("PingManager::onPingFinished", QString::fromLatin1("ping successful: %1 (%2 - %3) %4ms").arg(p.ipInfo.ip, p.ipInfo.city, p.ipInfo.nick).arg(timeMs));
+            addLog("PingManager::onPingFinished", QString::fromLatin1("ping successful: %1 (%2 - %3) %4ms%5").arg(p.ipInfo.ip, p.ipInfo.city, p.ipInfo.nick).arg(timeMs)
+                                                      .arg(networkTimesForLog(connectTimeMs, handshakeTimeMs)));
         }
         else {
             addLog("PingManager::onPingFinished", QString::fromLatin1("discarding ping while connected: %1 (%2 - %3) %4ms").arg(p.ipInfo.ip, p.ipInfo.city, p.ipInfo.nick).arg(timeMs));
@@ -168,6 +171,11 @@ void PingManager::onPingFinished(const std::string &ip, bool isSuccess, int32_t
         p.latestPingFailed = true;
         p.failedPingsInRow++;
 
+        if (!isUseIcmpPings_ && !p.isHttpFallback && (p.ipInfo.pingType == wsnet::PingType::kTcp || p.ipInfo.pingType == wsnet::PingType::kTls)) {
+            p.isHttpFallback = true;
+            addLog("PingManager::onPingFinished", QString::fromLatin1("falling back to the HTTP ping: %1 (%2 - %3)").arg(p.ipInfo.ip, p.ipInfo.city, p.ipInfo.nick));
+        }
+
         if (p.failedPingsInRow >= MAX_FAILED_PING_IN_ROW) {
             p.failedPingsInRow = 0;
             p.nextTimeForFailedPing = QDateTime::currentMSecsSinceEpoch() + 1000 * 60;
@@ -194,6 +202,17 @@ void PingManager::onPingFinished(const std::string &ip, bool isSuccess, int32_t
     }
 }
 
+QString PingManager::networkTimesForLog(std::int32_t connectTimeMs, std::int32_t handshakeTimeMs)
+{
+    // measured by the TCP and TLS pings only
+    if (connectTimeMs < 0) {
+        return QString();
+    } else if (handshakeTimeMs < 0) {
+        return QString::fromLatin1(" (connect %1ms)").arg(connectTimeMs);
+    }
+    return QString::fromLatin1(" (connect %1ms, handshake %2ms)").arg(connectTimeMs).arg(handshakeTimeMs);
+}
+
 int PingManager::exponentialBackoff_GetNextDelay(int curDelay, float factor, float jitter, float maxDelay)
 {
     float res = std::min((float)curDelay * factor, maxDelay);
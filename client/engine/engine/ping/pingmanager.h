@@ -14,7 +14,7 @@
 struct PingIpInfo
 {
     QString ip;
-    QString hostname;  // used for PING_CURL type
+    QString hostname;  // URL for the HTTP ping, SNI for the TLS ping
     QString city;      // only for log
     QString nick;      // only for log
     wsnet::PingType pingType;
@@ -62,6 +62,7 @@ private:
         qint64 nextTimeForFailedPing;
         int curDelayForFailedPing = MIN_DELAY_FOR_FAILED_IN_ROW_PINGS;
         bool existThisIp;
+        bool isHttpFallback;    // a TCP or TLS ping failed, the HTTP ping is used until the next iteration
 
         PingIpState()
         {
@@ -85,6 +86,7 @@ private:
             nextTimeForFailedPing = 0;
             curDelayForFailedPing = MIN_DELAY_FOR_FAILED_IN_ROW_PINGS;
             existThisIp = false;
+            isHttpFallback = false;
         }
     };
 
@@ -93,7 +95,9 @@ private:
     bool isLogPings_;
     bool isUseIcmpPings_;
 
-    void onPingFinished(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState);
+    void startPing(PingIpState &pni);
+    void onPingFinished(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState,
+                        std::int32_t connectTimeMs, std::int32_t handshakeTimeMs);
 
     // Exponential Backoff algorithm, get next delay
     // We start re-ping failed nodes after 1 second. Then the delay increases according to the algorithm to a maximum of 1 minute.
@@ -101,5 +105,6 @@ private:
 
     bool isAllIpsHaveCurIteration() const;
     void addLog(const QString &tag, const QString &str);
+    static QString networkTimesForLog(std::int32_t connectTimeMs, std::int32_t handshakeTimeMs);
 };
 
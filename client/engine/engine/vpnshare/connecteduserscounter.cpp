@@ -41,6 +41,7 @@ void ConnectedUsersCounter::userDiconnected(const QString &hostname)
 void ConnectedUsersCounter::reset()
 {
     connections_.clear();
+    threadLoads_.fill(0);
     checkUsersCount();
 }
 
@@ -49,6 +50,38 @@ int ConnectedUsersCounter::getConnectedUsersCount()
     return connections_.count();
 }
 
+int ConnectedUsersCounter::getConnectionsCount()
+{
+    int count = 0;
+    for (auto it = connections_.cbegin(); it != connections_.cend(); ++it)
+    {
+        count += it.value();
+    }
+    return count;
+}
+
+void ConnectedUsersCounter::setThreadsCount(int count)
+{
+    threadLoads_.fill(0, count);
+}
+
+void ConnectedUsersCounter::setThreadLoad(int threadIndex, int connectionsCount)
+{
+    if (threadIndex >= 0 && threadIndex < threadLoads_.count())
+    {
+        threadLoads_[threadIndex] = connectionsCount;
+    }
+    else
+    {
+        WS_ASSERT(false);
+    }
+}
+
+QVector<int> ConnectedUsersCounter::getThreadLoads()
+{
+    return threadLoads_;
+}
+
 void ConnectedUsersCounter::checkUsersCount()
 {
     if (connections_.count() != lastCnt_)
@@ -2,6 +2,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <QVector>
 
 class ConnectedUsersCounter : public QObject
 {
@@ -13,6 +14,13 @@ public:
     void reset();
 
     int getConnectedUsersCount();
+    // total number of connections, a user can have many
+    int getConnectionsCount();
+
+    // per worker thread load, reported by the multi-reactor engine
+    void setThreadsCount(int count);
+    void setThreadLoad(int threadIndex, int connectionsCount);
+    QVector<int> getThreadLoads();
 
 signals:
     void usersCountChanged();
@@ -20,6 +28,7 @@ signals:
 private:
     enum { MAX_NOT_ACTIVITY_TIME = 10000 };
     QMap<QString, int> connections_;
+    QVector<int> threadLoads_;
     int lastCnt_;
 
     void checkUsersCount();
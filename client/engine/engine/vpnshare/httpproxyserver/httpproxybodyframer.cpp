@@ -0,0 +1,192 @@
+#include "httpproxybodyframer.h"
+
+namespace HttpProxyServer {
+
+HttpProxyBodyFramer::HttpProxyBodyFramer() : mode_(NO_BODY), bFinished_(true), remaining_(0), chunkState_(chunk_size_start)
+{
+
+}
+
+void HttpProxyBodyFramer::reset(MODE mode, qint64 contentLength)
+{
+    mode_ = mode;
+    remaining_ = 0;
+    chunkState_ = chunk_size_start;
+
+    if (mode_ == NO_BODY || (mode_ == CONTENT_LENGTH && contentLength <= 0))
+    {
+        mode_ = NO_BODY;
+        bFinished_ = true;
+    }
+    else
+    {
+        bFinished_ = false;
+        if (mode_ == CONTENT_LENGTH)
+        {
+            remaining_ = contentLength;
+        }
+    }
+}
+
+TRI_BOOL HttpProxyBodyFramer::consume(const char *data, qint64 size, qint64 &outConsumed)
+{
+    outConsumed = 0;
+    if (bFinished_)
+    {
+        return TRI_TRUE;
+    }
+
+    switch (mode_)
+    {
+        case CONTENT_LENGTH:
+            outConsumed = qMin(size, remaining_);
+            remaining_ -= outConsumed;
+            bFinished_ = (remaining_ == 0);
+            return bFinished_ ? TRI_TRUE : TRI_INDETERMINATE;
+        case CHUNKED:
+            return consumeChunked(data, size, outConsumed);
+        case UNTIL_CLOSE:
+            outConsumed = size;
+            return TRI_INDETERMINATE;
+        default:
+            return TRI_TRUE;
+    }
+}
+
+TRI_BOOL HttpProxyBodyFramer::consumeChunked(const char *data, qint64 size, qint64 &outConsumed)
+{
+    qint64 i = 0;
+    while (i < size)
+    {
+        const char c = data[i];
+        switch (chunkState_)
+        {
+            case chunk_size_start:
+                if (hexValue(c) < 0)
+                {
+                    return TRI_FALSE;
+                }
+                remaining_ = hexValue(c);
+                chunkState_ = chunk_size;
+                i++;
+                break;
+            case chunk_size:
+                if (hexValue(c) >= 0)
+                {
+                    // more than 15 hex digits can't be a real chunk
+                    if (remaining_ > (Q_INT64_C(1) << 56))
+                    {
+                        return TRI_FALSE;
+                    }
+                    remaining_ = remaining_ * 16 + hexValue(c);
+                }
+                else if (c == '\r')
+                {
+                    chunkState_ = chunk_size_newline;
+                }
+                else if (c == ';' || c == ' ' || c == '\t')
+                {
+                    chunkState_ = chunk_extension;
+                }
+                else
+                {
+                    return TRI_FALSE;
+                }
+                i++;
+                break;
+            case chunk_extension:
+                if (c == '\r')
+                {
+                    chunkState_ = chunk_size_newline;
+                }
+                i++;
+                break;
+            case chunk_size_newline:
+                if (c != '\n')
+                {
+                    return TRI_FALSE;
+                }
+                // the last chunk is followed by optional trailers
+                chunkState_ = (remaining_ == 0) ? trailer_line_start : chunk_data;
+                i++;
+                break;
+            case chunk_data:
+            {
+                // skip the whole chunk payload at once
+                const qint64 len = qMin(size - i, remaining_);
+                remaining_ -= len;
+                i += len;
+                if (remaining_ == 0)
+                {
+                    chunkState_ = chunk_data_cr;
+                }
+                break;
+            }
+            case chunk_data_cr:
+                if (c != '\r')
+                {
+                    return TRI_FALSE;
+                }
+                chunkState_ = chunk_data_newline;
+                i++;
+                break;
+            case chunk_data_newline:
+                if (c != '\n')
+                {
+                    return TRI_FALSE;
+                }
+                chunkState_ = chunk_size_start;
+                i++;
+                break;
+            case trailer_line_start:
+                chunkState_ = (c == '\r') ? last_newline : trailer_line;
+                i++;
+                break;
+            case trailer_line:
+                if (c == '\r')
+                {
+                    chunkState_ = trailer_newline;
+                }
+                i++;
+                break;
+            case trailer_newline:
+                if (c != '\n')
+                {
+                    return TRI_FALSE;
+                }
+                chunkState_ = trailer_line_start;
+                i++;
+                break;
+            case last_newline:
+                if (c != '\n')
+                {
+                    return TRI_FALSE;
+                }
+                outConsumed = i + 1;
+                bFinished_ = true;
+                return TRI_TRUE;
+        }
+    }
+
+    outConsumed = size;
+    return TRI_INDETERMINATE;
+}
+
+int HttpProxyBodyFramer::hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+} // namespace HttpProxyServer
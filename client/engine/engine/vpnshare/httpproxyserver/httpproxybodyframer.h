@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QtGlobal>
+#include "httpproxyrequestparser.h"
+
+namespace HttpProxyServer {
+
+// Finds where the body of an HTTP message ends, so the next message on a persistent connection can be parsed.
+// The body itself is relayed unchanged, chunked encoding is only tracked, not decoded.
+class HttpProxyBodyFramer
+{
+public:
+    enum MODE { NO_BODY, CONTENT_LENGTH, CHUNKED, UNTIL_CLOSE };
+
+    HttpProxyBodyFramer();
+
+    void reset(MODE mode, qint64 contentLength = 0);
+
+    // Consumes the body bytes from data, outConsumed is set to the number of bytes that belong to the body.
+    // Returns TRI_TRUE when the body is complete (the rest of data belongs to the next message),
+    // TRI_INDETERMINATE if more data is needed and TRI_FALSE on malformed chunked encoding.
+    TRI_BOOL consume(const char *data, qint64 size, qint64 &outConsumed);
+
+    MODE mode() const { return mode_; }
+    bool isFinished() const { return bFinished_; }
+
+private:
+    enum CHUNK_STATE
+    {
+        chunk_size_start,
+        chunk_size,
+        chunk_extension,
+        chunk_size_newline,
+        chunk_data,
+        chunk_data_cr,
+        chunk_data_newline,
+        trailer_line_start,
+        trailer_line,
+        trailer_newline,
+        last_newline
+    };
+
+    MODE mode_;
+    bool bFinished_;
+    qint64 remaining_;
+    CHUNK_STATE chunkState_;
+
+    TRI_BOOL consumeChunked(const char *data, qint64 size, qint64 &outConsumed);
+    static int hexValue(char c);
+};
+
+} // namespace HttpProxyServer
@@ -4,13 +4,19 @@
 #include "utils/ws_assert.h"
 #include "utils/log/categories.h"
 
+#ifdef Q_OS_LINUX
+    #include "../socketutils/splicerelayhandover_linux.h"
+#endif
+
 namespace HttpProxyServer {
 
 
 HttpProxyConnection::HttpProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent) : QObject(parent),
     socket_(nullptr), socketExternal_(nullptr), socketDescriptor_(socketDescriptor),
     hostname_(hostname), state_(READ_CLIENT_REQUEST), writeAllSocket_(nullptr),
-    writeAllSocketExternal_(nullptr), httpError_(), bAlreadyClosedAndEmitFinished_(false)
+    writeAllSocketExternal_(nullptr), httpError_(), externalPort_(0), upstreamPool_(nullptr),
+    bExternalReused_(false), bExternalReusable_(false), bClientKeepAlive_(false), bAnswerKeepAlive_(false),
+    bAnswerStarted_(false), bAlreadyClosedAndEmitFinished_(false)
 {
     httpError_.status = HttpProxyReply::ok;
 }
@@ -29,9 +35,13 @@ void HttpProxyConnection::start()
     }
 
     state_ = READ_CLIENT_REQUEST;
+    upstreamPool_ = HttpProxyUpstreamPool::forCurrentThread();
+    socket_->setReadBufferSize(SocketWriteAll::kSourceReadBufferSize);
     connect(socket_, &QTcpSocket::disconnected, this, &HttpProxyConnection::onSocketDisconnected);
     connect(socket_, &QTcpSocket::readyRead, this, &HttpProxyConnection::onSocketReadyRead);
     writeAllSocket_ = new SocketWriteAll(this, socket_);
+    // the client is slower than the web server, stop reading from the web server until the client catches up
+    connect(writeAllSocket_, &SocketWriteAll::lowWaterMarkReached, this, &HttpProxyConnection::onExternalSocketReadyRead);
 }
 
 void HttpProxyConnection::onSocketDisconnected()
@@ -41,67 +51,232 @@ void HttpProxyConnection::onSocketDisconnected()
 
 void HttpProxyConnection::onSocketReadyRead()
 {
-    QByteArray arr = socket_->readAll();
+    // reading is paused, the data stays in the socket buffers until lowWaterMarkReached()
+    if (writeAllSocketExternal_ && writeAllSocketExternal_->isFull())
+    {
+        return;
+    }
+    // pipelined requests wait for the current answer, read more only when they are processed
+    if (clientData_.size() >= kMaxPendingClientData)
+    {
+        return;
+    }
+    if (socket_->bytesAvailable() == 0)
+    {
+        return;
+    }
 
-    if (state_ == READ_CLIENT_REQUEST)
+    if (state_ == RELAY_BETWEEN_CLIENT_SERVER && requestParser_.getRequest().isConnectMethod())
     {
-        quint32 parsed;
-        TRI_BOOL ret;
-        ret = requestParser_.parse(arr, parsed);
+        writeAllSocketExternal_->write(socket_->readAll());
+    }
+    else if (state_ == STATE_WRITE_AND_CLOSE)
+    {
+        socket_->readAll();
+    }
+    else
+    {
+        clientData_.append(socket_->readAll());
+        processClientData();
+    }
+}
 
-        if (ret == TRI_TRUE)
+void HttpProxyConnection::processClientData()
+{
+    while (!bAlreadyClosedAndEmitFinished_)
+    {
+        if (state_ == READ_CLIENT_REQUEST)
         {
-            if ((arr.size() - parsed) > 0)
+            if (clientData_.isEmpty())
             {
-                extraContent_ = QByteArray(arr.data() + parsed, arr.size() - parsed);
+                return;
             }
 
-            if (requestParser_.getRequest().extractHostAndPort())
-            {
-                socketExternal_ = new QTcpSocket(this);
+            quint32 parsed;
+            TRI_BOOL ret = requestParser_.parse(clientData_, parsed);
+            clientData_.remove(0, parsed);
 
-                connect(socketExternal_, &QTcpSocket::connected, this, &HttpProxyConnection::onExternalSocketConnected);
-                connect(socketExternal_, &QTcpSocket::disconnected, this, &HttpProxyConnection::onExternalSocketDisconnected);
-                connect(socketExternal_, &QTcpSocket::readyRead, this, &HttpProxyConnection::onExternalSocketReadyRead);
-                connect(socketExternal_, &QTcpSocket::errorOccurred, this, &HttpProxyConnection::onExternalSocketError);
-
-                writeAllSocketExternal_ = new SocketWriteAll(this, socketExternal_);
-
-                state_ = CONNECTING_TO_EXTERNAL_SERVER;
-                socketExternal_->connectToHost(QString::fromStdString(requestParser_.getRequest().host), requestParser_.getRequest().port);
+            if (ret == TRI_TRUE)
+            {
+                startRequest();
+            }
+            else if (ret == TRI_INDETERMINATE)
+            {
+                return;
             }
             else
             {
-                //todo send error reply
-                qCWarning(LOG_HTTP_SERVER) << "extractHostAndPort from request failed";
-                closeSocketsAndEmitFinished();
+                qCWarning(LOG_HTTP_SERVER) << "Parse client request failed";
+                httpError_ = HttpProxyReply::stock_reply(HttpProxyReply::service_unavailable);
+                writeAndClose(httpError_.toBuffer());
+                return;
             }
         }
-        else if (ret == TRI_INDETERMINATE)
+        else if (state_ == READ_HEADERS_FROM_WEBSERVER || state_ == RELAY_ANSWER_BODY ||
+                 (state_ == RELAY_BETWEEN_CLIENT_SERVER && !requestParser_.getRequest().isConnectMethod()))
         {
+            // relay the request body, the data after it is the next request and waits for the current answer
+            if (requestBodyFramer_.isFinished() || clientData_.isEmpty())
+            {
+                return;
+            }
+
+            qint64 consumed;
+            if (requestBodyFramer_.consume(clientData_.constData(), clientData_.size(), consumed) == TRI_FALSE)
+            {
+                qCWarning(LOG_HTTP_SERVER) << "Malformed chunked body in client request";
+                closeSocketsAndEmitFinished();
+                return;
+            }
+            if (consumed == clientData_.size())
+            {
+                writeAllSocketExternal_->write(clientData_);
+                clientData_.clear();
+            }
+            else
+            {
+                writeAllSocketExternal_->write(clientData_.left(consumed));
+                clientData_.remove(0, consumed);
+            }
         }
         else
         {
-            httpError_ = HttpProxyReply::stock_reply(HttpProxyReply::service_unavailable);
-            connect(writeAllSocket_, &SocketWriteAll::allDataWriteFinished, this, &HttpProxyConnection::onSocketAllDataWritten);
-            writeAllSocket_->write(httpError_.toBuffer());
-            writeAllSocket_->setEmitAllDataWritten();
-            state_ = STATE_WRITE_HTTP_ERROR;
-            qCWarning(LOG_HTTP_SERVER) << "Parse client request failed";
+            return;
         }
     }
-    else if (state_ == CONNECTING_TO_EXTERNAL_SERVER)
+}
+
+void HttpProxyConnection::startRequest()
+{
+    HttpProxyRequest &request = requestParser_.getRequest();
+    if (!request.extractHostAndPort())
+    {
+        //todo send error reply
+        qCWarning(LOG_HTTP_SERVER) << "extractHostAndPort from request failed";
+        closeSocketsAndEmitFinished();
+        return;
+    }
+
+    const QString host = QString::fromStdString(request.host);
+    if (request.isConnectMethod())
     {
-        extraContent_.append(arr);
+        bClientKeepAlive_ = false;
+        releaseExternalSocket();
+        externalHost_ = host;
+        externalPort_ = request.port;
+        connectToExternal();
+        return;
     }
-    else if (state_ == RELAY_BETWEEN_CLIENT_SERVER  || state_ == READ_HEADERS_FROM_WEBSERVER)
+
+    if (request.isChunked())
     {
-        writeAllSocketExternal_->write(arr);
+        requestBodyFramer_.reset(HttpProxyBodyFramer::CHUNKED);
     }
     else
     {
-        WS_ASSERT(false);
+        requestBodyFramer_.reset(HttpProxyBodyFramer::CONTENT_LENGTH, request.getContentLength());
+    }
+    bClientKeepAlive_ = request.isKeepAlive();
+
+    // the previous request went to the same webserver, its connection is still open
+    if (socketExternal_ && externalHost_ == host && externalPort_ == request.port &&
+        socketExternal_->state() == QAbstractSocket::ConnectedState)
+    {
+        bExternalReused_ = true;
+        sendRequestHeaders();
+        return;
     }
+
+    releaseExternalSocket();
+    externalHost_ = host;
+    externalPort_ = request.port;
+    QTcpSocket *socket = upstreamPool_ ? upstreamPool_->take(externalHost_, externalPort_) : nullptr;
+    if (socket)
+    {
+        attachExternalSocket(socket);
+        bExternalReused_ = true;
+        sendRequestHeaders();
+    }
+    else
+    {
+        connectToExternal();
+    }
+}
+
+void HttpProxyConnection::connectToExternal()
+{
+    attachExternalSocket(new QTcpSocket(this));
+    bExternalReused_ = false;
+    state_ = CONNECTING_TO_EXTERNAL_SERVER;
+    socketExternal_->connectToHost(externalHost_, externalPort_);
+}
+
+void HttpProxyConnection::attachExternalSocket(QTcpSocket *socket)
+{
+    socketExternal_ = socket;
+    socketExternal_->setParent(this);
+    socketExternal_->setReadBufferSize(SocketWriteAll::kSourceReadBufferSize);
+
+    connect(socketExternal_, &QTcpSocket::connected, this, &HttpProxyConnection::onExternalSocketConnected);
+    connect(socketExternal_, &QTcpSocket::disconnected, this, &HttpProxyConnection::onExternalSocketDisconnected);
+    connect(socketExternal_, &QTcpSocket::readyRead, this, &HttpProxyConnection::onExternalSocketReadyRead);
+    connect(socketExternal_, &QTcpSocket::errorOccurred, this, &HttpProxyConnection::onExternalSocketError);
+
+    writeAllSocketExternal_ = new SocketWriteAll(this, socketExternal_);
+    connect(writeAllSocketExternal_, &SocketWriteAll::lowWaterMarkReached, this, &HttpProxyConnection::onSocketReadyRead);
+    bExternalReusable_ = false;
+}
+
+void HttpProxyConnection::releaseExternalSocket()
+{
+    if (!socketExternal_)
+    {
+        return;
+    }
+
+    disconnect(socketExternal_, nullptr, this, nullptr);
+    disconnect(socketExternal_, nullptr, writeAllSocketExternal_, nullptr);
+    disconnect(writeAllSocketExternal_, nullptr, this, nullptr);
+
+    if (bExternalReusable_ && upstreamPool_ && writeAllSocketExternal_->isEmpty() &&
+        socketExternal_->state() == QAbstractSocket::ConnectedState &&
+        socketExternal_->bytesToWrite() == 0 && socketExternal_->bytesAvailable() == 0)
+    {
+        upstreamPool_->put(externalHost_, externalPort_, socketExternal_);
+    }
+    else
+    {
+        socketExternal_->abort();
+        socketExternal_->deleteLater();
+    }
+
+    writeAllSocketExternal_->deleteLater();
+    writeAllSocketExternal_ = nullptr;
+    socketExternal_ = nullptr;
+    bExternalReusable_ = false;
+}
+
+void HttpProxyConnection::sendRequestHeaders()
+{
+    HttpProxyRequest &request = requestParser_.getRequest();
+    // ask the webserver to keep the connection, it goes back to the pool after the answer
+    std::string s = request.getEstablishHttpConnectionMessage(true);
+    s += request.processClientHeaders();
+    writeAllSocketExternal_->write(QByteArray(s.c_str(), s.length()));
+
+    webAnswerParser_.reset();
+    bExternalReusable_ = false;
+    bAnswerKeepAlive_ = false;
+    bAnswerStarted_ = false;
+    state_ = READ_HEADERS_FROM_WEBSERVER;
+}
+
+void HttpProxyConnection::writeAndClose(const QByteArray &arr)
+{
+    state_ = STATE_WRITE_AND_CLOSE;
+    connect(writeAllSocket_, &SocketWriteAll::allDataWriteFinished, this, &HttpProxyConnection::onSocketAllDataWritten, Qt::UniqueConnection);
+    writeAllSocket_->write(arr);
+    writeAllSocket_->setEmitAllDataWritten();
 }
 
 void HttpProxyConnection::onSocketAllDataWritten()
@@ -116,38 +291,23 @@ void HttpProxyConnection::onExternalSocketConnected()
         if (requestParser_.getRequest().isConnectMethod())
         {
             writeAllSocket_->write(QByteArray(reply_established_, strlen(reply_established_)));
-            if (extraContent_.size() > 0)
+            if (clientData_.size() > 0)
             {
-                writeAllSocketExternal_->write(extraContent_);
-                extraContent_.clear();
+                writeAllSocketExternal_->write(clientData_);
+                clientData_.clear();
             }
             state_ = RELAY_BETWEEN_CLIENT_SERVER;
+#ifdef Q_OS_LINUX
+            startWaitingForSpliceRelay();
+#endif
         }
         else
         {
-            std::string s = requestParser_.getRequest().getEstablishHttpConnectionMessage();
-            writeAllSocketExternal_->write(QByteArray(s.c_str(), s.length()));
-
-            s = requestParser_.getRequest().processClientHeaders();
-            writeAllSocketExternal_->write(QByteArray(s.c_str(), s.length()));
-
-            /*long contentLength = requestParser_.getRequest().getContentLength();
-            if (contentLength > 0)
-            {
-                WS_ASSERT(contentLength == extraContent_.size());
-                writeAllSocketExternal_->write(extraContent_);
-            }
-            else
-            {*/
-                if (extraContent_.size() > 0)
-                {
-                    writeAllSocketExternal_->write(extraContent_);
-                    extraContent_.clear();
-                }
-            //}
-
-            state_ = READ_HEADERS_FROM_WEBSERVER;
+            sendRequestHeaders();
+            processClientData();
         }
+        // reading from the client could have been paused while connecting
+        onSocketReadyRead();
     }
     else
     {
@@ -157,58 +317,195 @@ void HttpProxyConnection::onExternalSocketConnected()
 
 void HttpProxyConnection::onExternalSocketDisconnected()
 {
-    if (state_ != STATE_WRITE_HTTP_ERROR)
+    if (state_ == STATE_WRITE_AND_CLOSE)
     {
-        // wait while all data will be write to client socket
-        if (writeAllSocket_)
-        {
-            connect(writeAllSocket_, &SocketWriteAll::allDataWriteFinished, this, &HttpProxyConnection::onSocketAllDataWritten);
-            writeAllSocket_->setEmitAllDataWritten();
-        }
-        else
-        {
-            closeSocketsAndEmitFinished();
-        }
+        return;
+    }
+
+    if (state_ == READ_CLIENT_REQUEST)
+    {
+        // the idle webserver connection was closed between requests, the next request opens a new one
+        bExternalReusable_ = false;
+        releaseExternalSocket();
+        return;
+    }
+
+    if (state_ == READ_HEADERS_FROM_WEBSERVER && !bAnswerStarted_ && bExternalReused_ &&
+        requestBodyFramer_.mode() == HttpProxyBodyFramer::NO_BODY)
+    {
+        // the webserver closed the kept connection before it got the request, repeat it on a new connection
+        releaseExternalSocket();
+        connectToExternal();
+        return;
+    }
+
+    // wait while all data will be write to client socket
+    if (writeAllSocket_)
+    {
+        connect(writeAllSocket_, &SocketWriteAll::allDataWriteFinished, this, &HttpProxyConnection::onSocketAllDataWritten, Qt::UniqueConnection);
+        writeAllSocket_->setEmitAllDataWritten();
+    }
+    else
+    {
+        closeSocketsAndEmitFinished();
     }
 }
 
 void HttpProxyConnection::onExternalSocketReadyRead()
 {
+    if (!socketExternal_ || writeAllSocket_->isFull() || socketExternal_->bytesAvailable() == 0)
+    {
+        return;
+    }
+
     QByteArray arr = socketExternal_->readAll();
     if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
     {
         writeAllSocket_->write(arr);
     }
-    else if (state_ == READ_HEADERS_FROM_WEBSERVER)
+    else if (state_ == READ_HEADERS_FROM_WEBSERVER || state_ == RELAY_ANSWER_BODY)
     {
-        quint32 parsed;
-        TRI_BOOL ret;
-        ret = webAnswerParser_.parse(arr, parsed);
+        processAnswerData(arr);
+    }
+    else if (state_ == READ_CLIENT_REQUEST)
+    {
+        // nothing is expected from the webserver between requests
+        bExternalReusable_ = false;
+        releaseExternalSocket();
+    }
+    else if (state_ != STATE_WRITE_AND_CLOSE)
+    {
+        WS_ASSERT(false);
+    }
+}
+
+void HttpProxyConnection::processAnswerData(const QByteArray &arr)
+{
+    bAnswerStarted_ = true;
+    int offset = 0;
 
-        if (ret == TRI_TRUE)
+    while (!bAlreadyClosedAndEmitFinished_)
+    {
+        if (state_ == READ_HEADERS_FROM_WEBSERVER && offset < arr.size())
         {
-            std::string s = webAnswerParser_.getAnswer().processServerHeaders(requestParser_.getRequest().http_version_major,
-                                                                              requestParser_.getRequest().http_version_minor);
-            writeAllSocket_->write(QByteArray(s.c_str(), s.length()));
+            quint32 parsed;
+            TRI_BOOL ret = webAnswerParser_.parse(QByteArray::fromRawData(arr.constData() + offset, arr.size() - offset), parsed);
+            offset += parsed;
 
-            quint32 remainingData = arr.size() - parsed;
-            if (remainingData > 0)
+            if (ret == TRI_TRUE)
             {
-                writeAllSocket_->write(QByteArray(arr.data() + parsed, remainingData));
+                startAnswer();
             }
-            state_ = RELAY_BETWEEN_CLIENT_SERVER;
+            else if (ret == TRI_FALSE)
+            {
+                //todo send error reply
+                qCWarning(LOG_HTTP_SERVER) << "Parse webserver answer and headers failed";
+                closeSocketsAndEmitFinished();
+                return;
+            }
+        }
+        else if (state_ == RELAY_ANSWER_BODY)
+        {
+            qint64 consumed;
+            TRI_BOOL ret = answerBodyFramer_.consume(arr.constData() + offset, arr.size() - offset, consumed);
+            if (ret == TRI_FALSE)
+            {
+                qCWarning(LOG_HTTP_SERVER) << "Malformed chunked body in webserver answer";
+                closeSocketsAndEmitFinished();
+                return;
+            }
+            if (consumed > 0)
+            {
+                writeAllSocket_->write(consumed == arr.size() ? arr : arr.mid(offset, consumed));
+                offset += consumed;
+            }
+            if (ret == TRI_TRUE)
+            {
+                if (offset < arr.size())
+                {
+                    // data after the answer that was not asked for, the connection can't be reused
+                    bAnswerKeepAlive_ = false;
+                }
+                finishAnswer();
+            }
+            return;
         }
-        else if (ret == TRI_FALSE)
+        else if (state_ == RELAY_BETWEEN_CLIENT_SERVER && offset < arr.size())
+        {
+            // the answer ends when the webserver closes the connection
+            writeAllSocket_->write(offset == 0 ? arr : arr.mid(offset));
+            return;
+        }
+        else
         {
-            //todo send error reply
-            qCWarning(LOG_HTTP_SERVER) << "Parse webserver answer and headers failed";
-            closeSocketsAndEmitFinished();
+            return;
         }
     }
+}
+
+void HttpProxyConnection::startAnswer()
+{
+    HttpProxyWebAnswer &answer = webAnswerParser_.getAnswer();
+    const HttpProxyRequest &request = requestParser_.getRequest();
+    const int statusCode = answer.getStatusCode();
+
+    if (statusCode >= 100 && statusCode < 200)
+    {
+        // interim answer (100 Continue), the final one follows
+        std::string s = answer.processServerHeaders(request.http_version_major, request.http_version_minor, nullptr);
+        writeAllSocket_->write(QByteArray(s.c_str(), s.length()));
+        webAnswerParser_.reset();
+        return;
+    }
+
+    if (request.isHeadMethod() || statusCode == 204 || statusCode == 304)
+    {
+        answerBodyFramer_.reset(HttpProxyBodyFramer::NO_BODY);
+    }
+    else if (answer.isChunked())
+    {
+        answerBodyFramer_.reset(HttpProxyBodyFramer::CHUNKED);
+    }
+    else if (answer.getContentLength() >= 0)
+    {
+        answerBodyFramer_.reset(HttpProxyBodyFramer::CONTENT_LENGTH, answer.getContentLength());
+    }
     else
     {
-        WS_ASSERT(false);
+        answerBodyFramer_.reset(HttpProxyBodyFramer::UNTIL_CLOSE);
+    }
+
+    const bool isFramed = answerBodyFramer_.mode() != HttpProxyBodyFramer::UNTIL_CLOSE;
+    bAnswerKeepAlive_ = isFramed && answer.isKeepAlive();
+    bClientKeepAlive_ = bClientKeepAlive_ && isFramed;
+
+    std::string s = answer.processServerHeaders(request.http_version_major, request.http_version_minor,
+                                                bClientKeepAlive_ ? "keep-alive" : "close");
+    writeAllSocket_->write(QByteArray(s.c_str(), s.length()));
+    state_ = isFramed ? RELAY_ANSWER_BODY : RELAY_BETWEEN_CLIENT_SERVER;
+}
+
+void HttpProxyConnection::finishAnswer()
+{
+    // the webserver connection can be reused only if it got the whole request
+    bExternalReusable_ = bAnswerKeepAlive_ && requestBodyFramer_.isFinished();
+
+    if (!bClientKeepAlive_ || !requestBodyFramer_.isFinished())
+    {
+        writeAndClose(QByteArray());
+        return;
     }
+
+    if (!bExternalReusable_)
+    {
+        releaseExternalSocket();
+    }
+    requestParser_.reset();
+    state_ = READ_CLIENT_REQUEST;
+
+    // the client could have sent the next requests already
+    processClientData();
+    onSocketReadyRead();
 }
 
 void HttpProxyConnection::onExternalSocketError(QAbstractSocket::SocketError socketError)
@@ -217,10 +514,7 @@ void HttpProxyConnection::onExternalSocketError(QAbstractSocket::SocketError soc
     if (state_ == CONNECTING_TO_EXTERNAL_SERVER)
     {
         httpError_ = HttpProxyReply::stock_reply(HttpProxyReply::internal_server_error);
-        connect(writeAllSocket_, &SocketWriteAll::allDataWriteFinished, this, &HttpProxyConnection::onSocketAllDataWritten);
-        writeAllSocket_->write(httpError_.toBuffer());
-        writeAllSocket_->setEmitAllDataWritten();
-        state_ = STATE_WRITE_HTTP_ERROR;
+        writeAndClose(httpError_.toBuffer());
     }
 }
 
@@ -229,11 +523,24 @@ void HttpProxyConnection::closeSocketsAndEmitFinished()
     if (!bAlreadyClosedAndEmitFinished_)
     {
         bAlreadyClosedAndEmitFinished_ = true;
+        logBufferStats();
+#ifdef Q_OS_LINUX
+        if (spliceRelayId_)
+        {
+            spliceRelay_->remove(spliceRelayId_);
+            spliceRelayId_ = 0;
+        }
+#endif
         if (socket_)
         {
             socket_->close();
         }
-        if (socketExternal_)
+        if (bExternalReusable_)
+        {
+            // the webserver connection is idle after a complete answer, it can serve other clients
+            releaseExternalSocket();
+        }
+        else if (socketExternal_)
         {
             socketExternal_->close();
         }
@@ -241,4 +548,54 @@ void HttpProxyConnection::closeSocketsAndEmitFinished()
     }
 }
 
+void HttpProxyConnection::logBufferStats()
+{
+    const SocketWriteAllStats toClient = writeAllSocket_ ? writeAllSocket_->stats() : SocketWriteAllStats();
+    const SocketWriteAllStats toServer = writeAllSocketExternal_ ? writeAllSocketExternal_->stats() : SocketWriteAllStats();
+    // only the connections that reached the high-water mark (and paused the producer) are logged
+    if (toClient.pauseCount == 0 && toServer.pauseCount == 0)
+    {
+        return;
+    }
+    qCDebug(LOG_HTTP_SERVER) << "Connection from" << hostname_ << "closed, to client: peak buffered" << toClient.peakBufferedBytes
+                             << "bytes, paused" << toClient.pauseCount << "times; to server: peak buffered" << toServer.peakBufferedBytes
+                             << "bytes, paused" << toServer.pauseCount << "times";
+}
+
+#ifdef Q_OS_LINUX
+void HttpProxyConnection::startWaitingForSpliceRelay()
+{
+    if (!spliceRelay_ || !spliceRelay_->isStarted())
+    {
+        return;
+    }
+    // the handover happens as soon as the reply and the client's early data have been flushed
+    bWaitingForSpliceRelay_ = true;
+    connect(socket_, &QTcpSocket::bytesWritten, this, &HttpProxyConnection::tryHandOverToSpliceRelay);
+    connect(socketExternal_, &QTcpSocket::bytesWritten, this, &HttpProxyConnection::tryHandOverToSpliceRelay);
+    tryHandOverToSpliceRelay();
+}
+
+void HttpProxyConnection::tryHandOverToSpliceRelay()
+{
+    if (!bWaitingForSpliceRelay_ || state_ != RELAY_BETWEEN_CLIENT_SERVER || bAlreadyClosedAndEmitFinished_)
+    {
+        return;
+    }
+    if (!SpliceRelayHandover::isReady(socket_, writeAllSocket_, socketExternal_, writeAllSocketExternal_))
+    {
+        return;
+    }
+
+    bWaitingForSpliceRelay_ = false;
+    spliceRelayId_ = SpliceRelayHandover::handOver(spliceRelay_, socket_, socketExternal_, this, [this]() {
+        QMetaObject::invokeMethod(this, [this]() { closeSocketsAndEmitFinished(); }, Qt::QueuedConnection);
+    });
+    if (spliceRelayId_ == 0)
+    {
+        qCWarning(LOG_HTTP_SERVER) << "Can't hand over the connection to the splice relay, continue relaying in user space";
+    }
+}
+#endif
+
 } // namespace HttpProxyServer
@@ -5,8 +5,14 @@
 #include "httpproxyrequestparser.h"
 #include "httpproxywebanswerparser.h"
 #include "httpproxyreply.h"
+#include "httpproxybodyframer.h"
+#include "httpproxyupstreampool.h"
 #include "../socketutils/socketwriteall.h"
 
+#ifdef Q_OS_LINUX
+    #include "../socketutils/splicerelay_linux.h"
+#endif
+
 namespace HttpProxyServer {
 
 class HttpProxyConnection : public QObject
@@ -14,6 +20,10 @@ class HttpProxyConnection : public QObject
     Q_OBJECT
 public:
     explicit HttpProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent = nullptr);
+#ifdef Q_OS_LINUX
+    // if set, the established CONNECT tunnel is handed over to the kernel splice() relay
+    void setSpliceRelay(SpliceRelay *spliceRelay) { spliceRelay_ = spliceRelay; }
+#endif
 
     bool start(qintptr socketDescriptor);
 
@@ -34,6 +44,9 @@ private slots:
     void onExternalSocketDisconnected();
     void onExternalSocketReadyRead();
     void onExternalSocketError(QAbstractSocket::SocketError socketError);
+#ifdef Q_OS_LINUX
+    void tryHandOverToSpliceRelay();
+#endif
 
 private:
     QTcpSocket *socket_;
@@ -43,19 +56,56 @@ private:
 
     const char *reply_established_ = "HTTP/1.0 200 Connection established\r\nProxy-agent: Windscribe\r\n\r\n";
 
-    enum { READ_CLIENT_REQUEST, CONNECTING_TO_EXTERNAL_SERVER, RELAY_BETWEEN_CLIENT_SERVER, READ_HEADERS_FROM_WEBSERVER, STATE_WRITE_HTTP_ERROR } state_;
+    // pipelined requests read from the client while a response is in progress wait in clientData_ up to this size
+    static constexpr int kMaxPendingClientData = 256 * 1024;
+
+    // RELAY_BETWEEN_CLIENT_SERVER is a raw relay (CONNECT tunnel or an answer delimited by the connection close),
+    // otherwise every request/answer pair is framed, so the client connection can be reused for the next request
+    enum { READ_CLIENT_REQUEST, CONNECTING_TO_EXTERNAL_SERVER, RELAY_BETWEEN_CLIENT_SERVER, READ_HEADERS_FROM_WEBSERVER,
+           RELAY_ANSWER_BODY, STATE_WRITE_AND_CLOSE } state_;
     HttpProxyRequestParser requestParser_;
     HttpProxyWebAnswerParser webAnswerParser_;
-
+    HttpProxyBodyFramer requestBodyFramer_;
+    HttpProxyBodyFramer answerBodyFramer_;
 
     SocketWriteAll *writeAllSocket_;
     SocketWriteAll *writeAllSocketExternal_;
 
-    QByteArray extraContent_;
+    // client data not yet parsed or relayed: the request body while connecting and the following pipelined requests
+    QByteArray clientData_;
     HttpProxyReply httpError_;
 
+    // the webserver the external socket is connected to, the socket is kept between requests to the same host
+    QString externalHost_;
+    quint16 externalPort_;
+    HttpProxyUpstreamPool *upstreamPool_;
+    bool bExternalReused_;
+    bool bExternalReusable_;
+    bool bClientKeepAlive_;
+    bool bAnswerKeepAlive_;
+    bool bAnswerStarted_;
+
     bool bAlreadyClosedAndEmitFinished_;
     void closeSocketsAndEmitFinished();
+    void logBufferStats();
+
+    void processClientData();
+    void startRequest();
+    void connectToExternal();
+    void attachExternalSocket(QTcpSocket *socket);
+    void releaseExternalSocket();
+    void sendRequestHeaders();
+    void processAnswerData(const QByteArray &arr);
+    void startAnswer();
+    void finishAnswer();
+    void writeAndClose(const QByteArray &arr);
+
+#ifdef Q_OS_LINUX
+    SpliceRelay *spliceRelay_ = nullptr;
+    quint64 spliceRelayId_ = 0;
+    bool bWaitingForSpliceRelay_ = false;
+    void startWaitingForSpliceRelay();
+#endif
 };
 
 } // namespace HttpProxyServer
@@ -3,6 +3,7 @@
 #include <QThread>
 #include <QTimer>
 #include "utils/ws_assert.h"
+#include "utils/log/categories.h"
 
 namespace HttpProxyServer {
 
@@ -16,6 +17,12 @@ HttpProxyConnectionManager::HttpProxyConnectionManager(QObject *parent, int thre
         threads_[thread] = 0;
         thread->start(QThread::LowPriority);
     }
+#ifdef Q_OS_LINUX
+    if (!spliceRelay_.start())
+    {
+        qCWarning(LOG_HTTP_SERVER) << "Can't start the splice relay, the connections will be relayed in user space";
+    }
+#endif
 }
 
 void HttpProxyConnectionManager::newConnection(qintptr socketDescriptor)
@@ -32,6 +39,9 @@ void HttpProxyConnectionManager::newConnection(qintptr socketDescriptor)
     usersCounter_->newUserConnected(ip);
     QThread *thread = getLessBusyThread();
     HttpProxyConnection *connection = new HttpProxyConnection(socketDescriptor, ip);
+#ifdef Q_OS_LINUX
+    connection->setSpliceRelay(&spliceRelay_);
+#endif
     connect(connection, &HttpProxyConnection::finished, this, &HttpProxyConnectionManager::onConnectionFinished);
     addConnectionToThread(thread, connection);
 
@@ -56,6 +66,9 @@ void HttpProxyConnectionManager::stop()
     {
         thread->wait();
     }
+#ifdef Q_OS_LINUX
+    spliceRelay_.stop();
+#endif
 }
 
 void HttpProxyConnectionManager::onConnectionFinished(const QString &hostname)
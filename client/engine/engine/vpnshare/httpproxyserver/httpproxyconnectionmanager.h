@@ -25,6 +25,9 @@ private:
     QMap<QThread *, quint32> threads_;
     QMap<HttpProxyConnection *, QThread *> connections_;
     ConnectedUsersCounter *usersCounter_;
+#ifdef Q_OS_LINUX
+    SpliceRelay spliceRelay_;
+#endif
 
     QThread *getLessBusyThread();
     void addConnectionToThread(QThread *thread, HttpProxyConnection *connection);
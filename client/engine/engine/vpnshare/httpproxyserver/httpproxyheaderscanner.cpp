@@ -0,0 +1,164 @@
+#include "httpproxyheaderscanner.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define HTTP_PROXY_SCANNER_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define HTTP_PROXY_SCANNER_NEON
+    #include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace HttpProxyServer {
+
+namespace {
+
+inline int countTrailingZeros(quint64 value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+inline bool isControlOr(char c, char delimiter)
+{
+    const unsigned char u = static_cast<unsigned char>(c);
+    return u < 0x20 || u == 0x7F || c == delimiter;
+}
+
+} // namespace
+
+const char *HttpProxyHeaderScanner::findHeadersEnd(const char *begin, const char *end)
+{
+    // memchr() is already vectorized by the C runtime
+    const char *p = begin;
+    while (end - p >= 4)
+    {
+        p = static_cast<const char *>(memchr(p, '\r', end - p - 3));
+        if (!p)
+        {
+            return nullptr;
+        }
+        if (p[1] == '\n' && p[2] == '\r' && p[3] == '\n')
+        {
+            return p;
+        }
+        p++;
+    }
+    return nullptr;
+}
+
+const char *HttpProxyHeaderScanner::findControlOr(const char *begin, const char *end, char delimiter)
+{
+    const char *p = begin;
+
+#if defined(HTTP_PROXY_SCANNER_SSE2)
+    const __m128i maxControl = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    while (end - p >= 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        // unsigned v <= 0x1F is the same as max(v, 0x1F) == 0x1F
+        const __m128i isControl = _mm_cmpeq_epi8(_mm_max_epu8(v, maxControl), maxControl);
+        const __m128i match = _mm_or_si128(isControl, _mm_or_si128(_mm_cmpeq_epi8(v, del), _mm_cmpeq_epi8(v, delim)));
+        const int mask = _mm_movemask_epi8(match);
+        if (mask != 0)
+        {
+            return p + countTrailingZeros(static_cast<quint64>(mask));
+        }
+        p += 16;
+    }
+#elif defined(HTTP_PROXY_SCANNER_NEON)
+    const uint8x16_t minPrintable = vdupq_n_u8(0x20);
+    const uint8x16_t del = vdupq_n_u8(0x7F);
+    const uint8x16_t delim = vdupq_n_u8(static_cast<uint8_t>(delimiter));
+    while (end - p >= 16)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t match = vorrq_u8(vcltq_u8(v, minPrintable), vorrq_u8(vceqq_u8(v, del), vceqq_u8(v, delim)));
+        // NEON has no movemask, narrow every byte of the mask to 4 bits instead
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+        if (mask != 0)
+        {
+            return p + (countTrailingZeros(mask) >> 2);
+        }
+        p += 16;
+    }
+#endif
+
+    while (p < end && !isControlOr(*p, delimiter))
+    {
+        p++;
+    }
+    return p;
+}
+
+bool HttpProxyHeaderScanner::parseHeaderLines(const char *begin, const char *end, QVector<HttpProxyHeader> &headers)
+{
+    const char *p = begin;
+    while (p < end)
+    {
+        if (*p == ' ' || *p == '\t')
+        {
+            // continuation of the previous header value
+            if (headers.isEmpty())
+            {
+                return false;
+            }
+            while (p < end && (*p == ' ' || *p == '\t'))
+            {
+                p++;
+            }
+            const char *valueEnd = findControlOr(p, end, '\r');
+            if (end - valueEnd < 2 || valueEnd[0] != '\r' || valueEnd[1] != '\n')
+            {
+                return false;
+            }
+            headers.back().value.append(p, valueEnd - p);
+            p = valueEnd + 2;
+            continue;
+        }
+
+        const char *nameEnd = findControlOr(p, end, ':');
+        if (nameEnd == p || nameEnd == end || *nameEnd != ':')
+        {
+            return false;
+        }
+        for (const char *c = p; c < nameEnd; ++c)
+        {
+            if (!isToken(*c))
+            {
+                return false;
+            }
+        }
+        // exactly one space after the colon, as in the state machine
+        if (end - nameEnd < 2 || nameEnd[1] != ' ')
+        {
+            return false;
+        }
+
+        const char *value = nameEnd + 2;
+        const char *valueEnd = findControlOr(value, end, '\r');
+        if (end - valueEnd < 2 || valueEnd[0] != '\r' || valueEnd[1] != '\n')
+        {
+            return false;
+        }
+
+        headers.push_back(HttpProxyHeader());
+        headers.back().name.assign(p, nameEnd - p);
+        headers.back().value.assign(value, valueEnd - value);
+        p = valueEnd + 2;
+    }
+    return true;
+}
+
+} // namespace HttpProxyServer
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QVector>
+#include <array>
+#include "httpproxyheader.h"
+
+namespace HttpProxyServer {
+
+// characters allowed in methods and header names
+inline constexpr std::array<bool, 256> kHttpTokenTable = []() {
+    std::array<bool, 256> table = {};
+    for (int c = 33; c < 127; ++c)
+    {
+        table[c] = true;
+    }
+    for (const char *p = "()<>@,;:\\\"/[]?={} \t"; *p; ++p)
+    {
+        table[static_cast<unsigned char>(*p)] = false;
+    }
+    return table;
+}();
+
+// Block scanning helpers for the fast path of the request and answer parsers.
+// Delimiters are searched 16 bytes at a time with SSE2 or NEON (with a scalar fallback on other CPUs),
+// and every field is copied once when its end is known, instead of a push_back for every byte.
+// The accepted grammar is the same as in the byte-by-byte state machines of the parsers.
+class HttpProxyHeaderScanner
+{
+public:
+    // Returns the position of the "\r\n\r\n" ending the header block in [begin, end), or nullptr if the block is incomplete.
+    static const char *findHeadersEnd(const char *begin, const char *end);
+
+    // Returns the first control character (0x00-0x1F, 0x7F) or delimiter in [begin, end), or end if there is none.
+    static const char *findControlOr(const char *begin, const char *end, char delimiter);
+
+    // Parses the header lines in [begin, end), every line including the last one must end with "\r\n".
+    static bool parseHeaderLines(const char *begin, const char *end, QVector<HttpProxyHeader> &headers);
+
+    // a character allowed in a method or header name (is_char() && !is_ctl() && !is_tspecial() of the parsers)
+    static bool isToken(char c) { return kHttpTokenTable[static_cast<unsigned char>(c)]; }
+};
+
+} // namespace HttpProxyServer
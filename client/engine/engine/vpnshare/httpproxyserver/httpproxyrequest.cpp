@@ -93,9 +93,31 @@ bool HttpProxyRequest::isConnectMethod() const
     return strcmp (method.c_str(), "CONNECT") == 0;
 }
 
-std::string HttpProxyRequest::getEstablishHttpConnectionMessage()
+bool HttpProxyRequest::isHeadMethod() const
+{
+    return strcmp (method.c_str(), "HEAD") == 0;
+}
+
+bool HttpProxyRequest::isKeepAlive() const
+{
+    if (http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1))
+    {
+        return !isHeaderContains("connection", "close") && !isHeaderContains("proxy-connection", "close");
+    }
+    return isHeaderContains("connection", "keep-alive") || isHeaderContains("proxy-connection", "keep-alive");
+}
+
+bool HttpProxyRequest::isChunked() const
+{
+    return isHeaderContains("transfer-encoding", "chunked");
+}
+
+std::string HttpProxyRequest::getEstablishHttpConnectionMessage(bool keepAlive)
 {
     std::string msg;
+    // HTTP/1.0 clients can't read chunked answers, so they must not get HTTP/1.1 answers
+    const char *version = (http_version_major == 1 && http_version_minor == 0) ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n";
+    const char *connection = keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
     char portbuff[7];
     char dst[sizeof(struct in6_addr)];
 
@@ -116,9 +138,9 @@ std::string HttpProxyRequest::getEstablishHttpConnectionMessage()
     if (inet_pton(AF_INET6, host.c_str(), dst) > 0)
     {
         // host is an IPv6 address literal, so surround it with []
-        msg = method + " " + path + " HTTP/1.0\r\n";
+        msg = method + " " + path + version;
         msg += "Host: [" + host + "]" + portbuff + "\r\n";
-        msg += "Connection: close\r\n";
+        msg += connection;
 
         /*return write_message (connptr->server_fd,
                                           "%s %s HTTP/1.0\r\n"
@@ -129,9 +151,9 @@ std::string HttpProxyRequest::getEstablishHttpConnectionMessage()
     }
     else
     {
-        msg = method + " " + path + " HTTP/1.0\r\n";
+        msg = method + " " + path + version;
         msg += "Host: " + host + portbuff + "\r\n";
-        msg += "Connection: close\r\n";
+        msg += connection;
 
         /*return write_message (connptr->server_fd,
                                           "%s %s HTTP/1.0\r\n"
@@ -316,4 +338,16 @@ bool HttpProxyRequest::shouldSkipHeader(const std::string &headerName)
     return false;
 }
 
+bool HttpProxyRequest::isHeaderContains(const char *headerName, const char *token) const
+{
+    for (auto it = headers.begin(); it != headers.end(); ++it)
+    {
+        if (boost::iequals(it->name, headerName) && boost::icontains(it->value, token))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace HttpProxyServer
@@ -26,7 +26,11 @@ public:
     bool extractHostAndPort();
 
     bool isConnectMethod() const;
-    std::string getEstablishHttpConnectionMessage();
+    bool isHeadMethod() const;
+    // whether the client wants the connection to stay open after the response (HTTP/1.1 default or keep-alive for HTTP/1.0)
+    bool isKeepAlive() const;
+    bool isChunked() const;
+    std::string getEstablishHttpConnectionMessage(bool keepAlive);
     long getContentLength();
     std::string processClientHeaders();
 
@@ -39,6 +43,7 @@ private:
     int stripReturnPort(std::string &hostStr);
 
     bool shouldSkipHeader(const std::string &headerName);
+    bool isHeaderContains(const char *headerName, const char *token) const;
 };
 
 } // namespace HttpProxyServer
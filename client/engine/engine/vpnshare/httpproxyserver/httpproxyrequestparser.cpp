@@ -1,16 +1,33 @@
 #include "httpproxyrequestparser.h"
+#include "httpproxyheaderscanner.h"
+#include <cstring>
 
 namespace HttpProxyServer {
 
 
-HttpProxyRequestParser::HttpProxyRequestParser() : state_(method_start)
+HttpProxyRequestParser::HttpProxyRequestParser() : bFastScan_(true), state_(method_start)
 {
 
 }
 
+void HttpProxyRequestParser::reset()
+{
+    state_ = method_start;
+    request_ = HttpProxyRequest();
+}
+
 TRI_BOOL HttpProxyRequestParser::parse(const QByteArray &arr, quint32 &outParsed)
 {
-    const char *data = arr.data();
+    const char *data = arr.constData();
+    if (bFastScan_ && state_ == method_start)
+    {
+        const char *headersEnd = HttpProxyHeaderScanner::findHeadersEnd(data, data + arr.size());
+        if (headersEnd)
+        {
+            return parseBlock(data, headersEnd, outParsed);
+        }
+    }
+
     for (int i = 0; i < arr.size(); ++i)
     {
         TRI_BOOL res = consume(data[i]);
@@ -25,6 +42,77 @@ TRI_BOOL HttpProxyRequestParser::parse(const QByteArray &arr, quint32 &outParsed
     return TRI_INDETERMINATE;
 }
 
+TRI_BOOL HttpProxyRequestParser::parseBlock(const char *begin, const char *headersEnd, quint32 &outParsed)
+{
+    // the block ends with the CRLF of the last line, the empty line is not included
+    const char *end = headersEnd + 2;
+    outParsed = headersEnd + 4 - begin;
+
+    const char *p = begin;
+    while (p < end && HttpProxyHeaderScanner::isToken(*p))
+    {
+        p++;
+    }
+    if (p == begin || *p != ' ')
+    {
+        return TRI_FALSE;
+    }
+    request_.method.assign(begin, p - begin);
+
+    const char *uriBegin = p + 1;
+    p = HttpProxyHeaderScanner::findControlOr(uriBegin, end, ' ');
+    if (p == end || *p != ' ')
+    {
+        return TRI_FALSE;
+    }
+    request_.uri.assign(uriBegin, p - uriBegin);
+    p++;
+
+    if (end - p < 5 || memcmp(p, "HTTP/", 5) != 0)
+    {
+        return TRI_FALSE;
+    }
+    p += 5;
+
+    request_.http_version_major = 0;
+    request_.http_version_minor = 0;
+    if (p == end || !is_digit(*p))
+    {
+        return TRI_FALSE;
+    }
+    while (p < end && is_digit(*p))
+    {
+        request_.http_version_major = request_.http_version_major * 10 + *p - '0';
+        p++;
+    }
+    if (p == end || *p != '.')
+    {
+        return TRI_FALSE;
+    }
+    p++;
+    if (p == end || !is_digit(*p))
+    {
+        return TRI_FALSE;
+    }
+    while (p < end && is_digit(*p))
+    {
+        request_.http_version_minor = request_.http_version_minor * 10 + *p - '0';
+        p++;
+    }
+    if (end - p < 2 || p[0] != '\r' || p[1] != '\n')
+    {
+        return TRI_FALSE;
+    }
+    p += 2;
+
+    request_.headers.reserve(16);
+    if (!HttpProxyHeaderScanner::parseHeaderLines(p, end, request_.headers))
+    {
+        return TRI_FALSE;
+    }
+    return TRI_TRUE;
+}
+
 TRI_BOOL HttpProxyRequestParser::consume(char input)
 {
     switch (state_)
@@ -13,12 +13,19 @@ public:
     HttpProxyRequestParser();
 
     TRI_BOOL parse(const QByteArray &arr, quint32 &outParsed);
+    // prepares the parser for the next message on a persistent connection
+    void reset();
+    // When enabled (default), a request whose header block is complete in the buffer is parsed with block scans
+    // (see HttpProxyHeaderScanner), otherwise it goes through the byte-by-byte state machine.
+    void setFastScanEnabled(bool enabled) { bFastScan_ = enabled; }
 
     HttpProxyRequest &getRequest() { return request_; }
 
 private:
     HttpProxyRequest request_;
+    bool bFastScan_;
 
+    TRI_BOOL parseBlock(const char *begin, const char *headersEnd, quint32 &outParsed);
     TRI_BOOL consume(char input);
 
     static bool is_char(int c);
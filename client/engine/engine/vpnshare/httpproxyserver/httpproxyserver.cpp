@@ -1,6 +1,7 @@
 #include "httpproxyserver.h"
 #include "utils/ws_assert.h"
 #include "utils/log/categories.h"
+#include "utils/extraconfig.h"
 
 namespace HttpProxyServer {
 
@@ -8,7 +9,6 @@ HttpProxyServer::HttpProxyServer(QObject *parent) : QTcpServer(parent)
 {
     usersCounter_ = new ConnectedUsersCounter(this);
     connect(usersCounter_, &ConnectedUsersCounter::usersCountChanged, this, &HttpProxyServer::usersCountChanged);
-    connectionManager_ = new HttpProxyConnectionManager(this, 4, usersCounter_);
 }
 
 HttpProxyServer::~HttpProxyServer()
@@ -20,6 +20,33 @@ bool HttpProxyServer::startServer(quint16 port)
 {
     WS_ASSERT(!isListening());
 
+#ifdef Q_OS_LINUX
+    if (ExtraConfig::instance().getProxyMultiReactor())
+    {
+        if (!reactorPool_)
+        {
+            reactorPool_ = new ProxyReactorPool(this, usersCounter_, LOG_HTTP_SERVER,
+                [](qintptr socketDescriptor, const QString &hostname, SpliceRelay *spliceRelay) -> QObject * {
+                    HttpProxyConnection *connection = new HttpProxyConnection(socketDescriptor, hostname);
+                    connection->setSpliceRelay(spliceRelay);
+                    return connection;
+                });
+        }
+        if (reactorPool_->start(port))
+        {
+            qCInfo(LOG_HTTP_SERVER) << "Http proxy server started on port" << reactorPool_->port() << "with" << reactorPool_->reactorsCount() << "reactors";
+            return true;
+        }
+        qCCritical(LOG_HTTP_SERVER) << "Can't start http proxy server on port" << port;
+        return false;
+    }
+#endif
+
+    // the reactors replace the worker threads of the connection manager, it is created only when they are not used
+    if (!connectionManager_)
+    {
+        connectionManager_ = new HttpProxyConnectionManager(this, 4, usersCounter_);
+    }
     if (listen(QHostAddress::AnyIPv4, port))
     {
         qCInfo(LOG_HTTP_SERVER) << "Http proxy server started on port" << serverPort();
@@ -39,7 +66,17 @@ void HttpProxyServer::stopServer()
         qCInfo(LOG_HTTP_SERVER) << "Http proxy server stopped on port" << serverPort();
         close();
     }
-    connectionManager_->stop();
+#ifdef Q_OS_LINUX
+    if (reactorPool_ && reactorPool_->isStarted())
+    {
+        qCInfo(LOG_HTTP_SERVER) << "Http proxy server stopped on port" << reactorPool_->port();
+        reactorPool_->stop();
+    }
+#endif
+    if (connectionManager_)
+    {
+        connectionManager_->stop();
+    }
     usersCounter_->reset();
 }
 
@@ -48,13 +85,44 @@ int HttpProxyServer::getConnectedUsersCount()
     return usersCounter_->getConnectedUsersCount();
 }
 
+int HttpProxyServer::getConnectionsCount()
+{
+    return usersCounter_->getConnectionsCount();
+}
+
+QVector<int> HttpProxyServer::getThreadLoads()
+{
+    return usersCounter_->getThreadLoads();
+}
+
+quint16 HttpProxyServer::getServerPort()
+{
+#ifdef Q_OS_LINUX
+    if (reactorPool_ && reactorPool_->isStarted())
+    {
+        return reactorPool_->port();
+    }
+#endif
+    return serverPort();
+}
+
 void HttpProxyServer::closeActiveConnections()
 {
-    connectionManager_->closeAllConnections();
+#ifdef Q_OS_LINUX
+    if (reactorPool_)
+    {
+        reactorPool_->closeAllConnections();
+    }
+#endif
+    if (connectionManager_)
+    {
+        connectionManager_->closeAllConnections();
+    }
 }
 
 void HttpProxyServer::incomingConnection(qintptr socketDescriptor)
 {
+    WS_ASSERT(connectionManager_);
     connectionManager_->newConnection(socketDescriptor);
 }
 
@@ -3,6 +3,10 @@
 #include "httpproxyconnectionmanager.h"
 #include "../connecteduserscounter.h"
 
+#ifdef Q_OS_LINUX
+    #include "../proxyreactorpool_linux.h"
+#endif
+
 #include <QTcpServer>
 
 namespace HttpProxyServer {
@@ -18,6 +22,9 @@ public:
     void stopServer();
 
     int getConnectedUsersCount();
+    int getConnectionsCount();
+    QVector<int> getThreadLoads();
+    quint16 getServerPort();
 
     void closeActiveConnections();
 
@@ -28,8 +35,11 @@ protected:
     virtual void incomingConnection(qintptr socketDescriptor);
 
 private:
-    HttpProxyConnectionManager *connectionManager_;
+    HttpProxyConnectionManager *connectionManager_ = nullptr;
     ConnectedUsersCounter *usersCounter_;
+#ifdef Q_OS_LINUX
+    ProxyReactorPool *reactorPool_ = nullptr;
+#endif
 };
 
 } // namespace HttpProxyServer
@@ -0,0 +1,125 @@
+#include "httpproxyupstreampool.h"
+#include <QDateTime>
+#include <QThreadStorage>
+#include "utils/ws_assert.h"
+
+namespace HttpProxyServer {
+
+HttpProxyUpstreamPool::HttpProxyUpstreamPool(QObject *parent) : QObject(parent)
+{
+    connect(&timer_, &QTimer::timeout, this, &HttpProxyUpstreamPool::onTimer);
+}
+
+HttpProxyUpstreamPool *HttpProxyUpstreamPool::forCurrentThread()
+{
+    static QThreadStorage<HttpProxyUpstreamPool *> pools;
+    if (!pools.hasLocalData())
+    {
+        pools.setLocalData(new HttpProxyUpstreamPool());
+    }
+    return pools.localData();
+}
+
+QTcpSocket *HttpProxyUpstreamPool::take(const QString &host, quint16 port)
+{
+    const QString key = makeKey(host, port);
+    for (int i = idleSockets_.size() - 1; i >= 0; --i)
+    {
+        if (idleSockets_[i].key == key)
+        {
+            QTcpSocket *socket = idleSockets_[i].socket;
+            idleSockets_.removeAt(i);
+            disconnect(socket, nullptr, this, nullptr);
+            socket->setParent(nullptr);
+            if (socket->state() == QAbstractSocket::ConnectedState && socket->bytesAvailable() == 0)
+            {
+                return socket;
+            }
+            socket->abort();
+            socket->deleteLater();
+        }
+    }
+    return nullptr;
+}
+
+void HttpProxyUpstreamPool::put(const QString &host, quint16 port, QTcpSocket *socket)
+{
+    WS_ASSERT(socket->bytesToWrite() == 0);
+    const QString key = makeKey(host, port);
+
+    int hostCount = 0;
+    int oldestForHost = -1;
+    for (int i = 0; i < idleSockets_.size(); ++i)
+    {
+        if (idleSockets_[i].key == key)
+        {
+            if (oldestForHost < 0)
+            {
+                oldestForHost = i;
+            }
+            hostCount++;
+        }
+    }
+    if (hostCount >= kMaxIdleSocketsPerHost)
+    {
+        drop(oldestForHost);
+    }
+    else if (idleSockets_.size() >= kMaxIdleSockets)
+    {
+        drop(0);
+    }
+
+    socket->setParent(this);
+    // a webserver sends nothing on an idle keep-alive connection, any data or a close makes it unusable
+    connect(socket, &QTcpSocket::disconnected, this, &HttpProxyUpstreamPool::onIdleSocketClosedOrReadyRead);
+    connect(socket, &QTcpSocket::readyRead, this, &HttpProxyUpstreamPool::onIdleSocketClosedOrReadyRead);
+    idleSockets_.push_back({ key, socket, QDateTime::currentMSecsSinceEpoch() });
+
+    if (!timer_.isActive())
+    {
+        timer_.start(kIdleTimeoutMs / 3);
+    }
+}
+
+void HttpProxyUpstreamPool::onIdleSocketClosedOrReadyRead()
+{
+    QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+    for (int i = 0; i < idleSockets_.size(); ++i)
+    {
+        if (idleSockets_[i].socket == socket)
+        {
+            drop(i);
+            return;
+        }
+    }
+}
+
+void HttpProxyUpstreamPool::onTimer()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    // the sockets are sorted by the time they were put in the pool
+    while (!idleSockets_.isEmpty() && now - idleSockets_.first().since >= kIdleTimeoutMs)
+    {
+        drop(0);
+    }
+    if (idleSockets_.isEmpty())
+    {
+        timer_.stop();
+    }
+}
+
+void HttpProxyUpstreamPool::drop(int index)
+{
+    QTcpSocket *socket = idleSockets_[index].socket;
+    idleSockets_.removeAt(index);
+    disconnect(socket, nullptr, this, nullptr);
+    socket->abort();
+    socket->deleteLater();
+}
+
+QString HttpProxyUpstreamPool::makeKey(const QString &host, quint16 port)
+{
+    return host.toLower() + ":" + QString::number(port);
+}
+
+} // namespace HttpProxyServer
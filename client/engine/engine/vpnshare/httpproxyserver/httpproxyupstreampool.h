@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVector>
+
+namespace HttpProxyServer {
+
+// Idle keep-alive connections to webservers, reused by the next request to the same host:port from any client connection.
+// A QTcpSocket can only be used in the thread it lives in, so every connection thread has its own pool (see forCurrentThread()).
+class HttpProxyUpstreamPool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HttpProxyUpstreamPool(QObject *parent = nullptr);
+
+    // the pool of the calling thread, created on first use and deleted when the thread finishes
+    static HttpProxyUpstreamPool *forCurrentThread();
+
+    // Returns a connected idle socket to host:port or nullptr. The socket no longer belongs to the pool.
+    QTcpSocket *take(const QString &host, quint16 port);
+    // Keeps the socket for reuse. The socket must be connected, have no unread data and nothing left to write,
+    // and must not have signal connections to the previous owner.
+    void put(const QString &host, quint16 port, QTcpSocket *socket);
+
+    int idleCount() const { return idleSockets_.size(); }
+
+    static constexpr int kMaxIdleSockets = 32;
+    static constexpr int kMaxIdleSocketsPerHost = 4;
+    // should be below the keep-alive timeout of most webservers, so the pool rarely hands out a connection being closed
+    static constexpr int kIdleTimeoutMs = 15000;
+
+private slots:
+    void onIdleSocketClosedOrReadyRead();
+    void onTimer();
+
+private:
+    struct IdleSocket
+    {
+        QString key;
+        QTcpSocket *socket;
+        qint64 since;
+    };
+
+    // the most recently used sockets are at the end
+    QVector<IdleSocket> idleSockets_;
+    QTimer timer_;
+
+    void drop(int index);
+    static QString makeKey(const QString &host, quint16 port);
+};
+
+} // namespace HttpProxyServer
@@ -18,7 +18,32 @@ long HttpProxyWebAnswer::getContentLength()
     return -1;
 }
 
-std::string HttpProxyWebAnswer::processServerHeaders(unsigned int major, unsigned int minor)
+int HttpProxyWebAnswer::getStatusCode() const
+{
+    unsigned int major, minor;
+    int code;
+    if (sscanf(answer.c_str(), "HTTP/%u.%u %d", &major, &minor, &code) != 3)
+    {
+        return 0;
+    }
+    return code;
+}
+
+bool HttpProxyWebAnswer::isKeepAlive() const
+{
+    if (boost::istarts_with(answer, "HTTP/1.0"))
+    {
+        return isHeaderContains("connection", "keep-alive");
+    }
+    return !isHeaderContains("connection", "close");
+}
+
+bool HttpProxyWebAnswer::isChunked() const
+{
+    return isHeaderContains("transfer-encoding", "chunked");
+}
+
+std::string HttpProxyWebAnswer::processServerHeaders(unsigned int major, unsigned int minor, const char *connection)
 {
     std::string ret;
     //todo: check buffer bounds
@@ -58,6 +83,11 @@ std::string HttpProxyWebAnswer::processServerHeaders(unsigned int major, unsigne
         ret += buf;
     }
 
+    if (connection)
+    {
+        ret += std::string("Connection: ") + connection + "\r\n";
+    }
+
     ret += "\r\n";
 
     return ret;
@@ -79,4 +109,16 @@ bool HttpProxyWebAnswer::shouldSkipHeader(const std::string &headerName)
     return false;
 }
 
+bool HttpProxyWebAnswer::isHeaderContains(const char *headerName, const char *token) const
+{
+    for (auto it = headers.begin(); it != headers.end(); ++it)
+    {
+        if (boost::iequals(it->name, headerName) && boost::icontains(it->value, token))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace HttpProxyServer
@@ -14,10 +14,17 @@ struct HttpProxyWebAnswer
   QVector<HttpProxyHeader> headers;
 
   long getContentLength();
-  std::string processServerHeaders(unsigned int major, unsigned int minor);
+  // status code from the answer line ("HTTP/1.1 200 OK"), 0 if it can't be parsed
+  int getStatusCode() const;
+  // whether the webserver keeps the connection open after this answer
+  bool isKeepAlive() const;
+  bool isChunked() const;
+  // connection is the value of the Connection header sent to the client, nullptr for interim (1xx) answers
+  std::string processServerHeaders(unsigned int major, unsigned int minor, const char *connection);
 
 private:
   bool shouldSkipHeader(const std::string &headerName);
+  bool isHeaderContains(const char *headerName, const char *token) const;
 
 };
 
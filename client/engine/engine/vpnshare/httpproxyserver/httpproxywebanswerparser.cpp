@@ -1,15 +1,32 @@
 #include "httpproxywebanswerparser.h"
+#include "httpproxyheaderscanner.h"
+#include <cstring>
 
 namespace HttpProxyServer {
 
-HttpProxyWebAnswerParser::HttpProxyWebAnswerParser() : state_(method_start)
+HttpProxyWebAnswerParser::HttpProxyWebAnswerParser() : bFastScan_(true), state_(method_start)
 {
 
 }
 
+void HttpProxyWebAnswerParser::reset()
+{
+    state_ = method_start;
+    answer_ = HttpProxyWebAnswer();
+}
+
 TRI_BOOL HttpProxyWebAnswerParser::parse(const QByteArray &arr, quint32 &outParsed)
 {
-    const char *data = arr.data();
+    const char *data = arr.constData();
+    if (bFastScan_ && state_ == method_start)
+    {
+        const char *headersEnd = HttpProxyHeaderScanner::findHeadersEnd(data, data + arr.size());
+        if (headersEnd)
+        {
+            return parseBlock(data, headersEnd, outParsed);
+        }
+    }
+
     for (int i = 0; i < arr.size(); ++i)
     {
         TRI_BOOL res = consume(data[i]);
@@ -24,6 +41,33 @@ TRI_BOOL HttpProxyWebAnswerParser::parse(const QByteArray &arr, quint32 &outPars
     return TRI_INDETERMINATE;
 }
 
+TRI_BOOL HttpProxyWebAnswerParser::parseBlock(const char *begin, const char *headersEnd, quint32 &outParsed)
+{
+    // the block ends with the CRLF of the last line, the empty line is not included
+    const char *end = headersEnd + 2;
+    outParsed = headersEnd + 4 - begin;
+
+    if (!HttpProxyHeaderScanner::isToken(*begin))
+    {
+        return TRI_FALSE;
+    }
+    // the status line is everything up to the first CR
+    const char *p = static_cast<const char *>(memchr(begin, '\r', end - begin));
+    if (!p || p[1] != '\n')
+    {
+        return TRI_FALSE;
+    }
+    answer_.answer.assign(begin, p - begin);
+    p += 2;
+
+    answer_.headers.reserve(16);
+    if (!HttpProxyHeaderScanner::parseHeaderLines(p, end, answer_.headers))
+    {
+        return TRI_FALSE;
+    }
+    return TRI_TRUE;
+}
+
 TRI_BOOL HttpProxyWebAnswerParser::consume(char input)
 {
     switch (state_)
@@ -12,12 +12,18 @@ public:
     HttpProxyWebAnswerParser();
 
     TRI_BOOL parse(const QByteArray &arr, quint32 &outParsed);
+    // prepares the parser for the next message on a persistent connection
+    void reset();
+    // same as HttpProxyRequestParser::setFastScanEnabled()
+    void setFastScanEnabled(bool enabled) { bFastScan_ = enabled; }
 
     HttpProxyWebAnswer &getAnswer() { return answer_; }
 
 private:
     HttpProxyWebAnswer answer_;
+    bool bFastScan_;
 
+    TRI_BOOL parseBlock(const char *begin, const char *headersEnd, quint32 &outParsed);
     TRI_BOOL consume(char input);
 
     static bool is_char(int c);
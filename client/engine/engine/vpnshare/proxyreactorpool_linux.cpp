@@ -0,0 +1,218 @@
+#include "proxyreactorpool_linux.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "utils/ws_assert.h"
+
+ProxyReactor::ProxyReactor(int index, int listenSocket, SpliceRelay *spliceRelay, ProxyLogCategory logCategory,
+                           ProxyConnectionFactory factory) : QTcpServer(nullptr),
+    index_(index), listenSocket_(listenSocket), spliceRelay_(spliceRelay), logCategory_(logCategory), factory_(factory)
+{
+}
+
+bool ProxyReactor::start()
+{
+    // the socket notifier is created in the calling thread, so this must run in the reactor's thread
+    const bool result = setSocketDescriptor(listenSocket_);
+    if (!result)
+    {
+        qCCritical(logCategory_) << "Reactor" << index_ << "can't use the listen socket:" << errorString();
+        ::close(listenSocket_);
+    }
+    listenSocket_ = -1;
+    return result;
+}
+
+void ProxyReactor::closeAllConnections()
+{
+    // forceClose() emits finished() synchronously, which modifies connections_
+    const QSet<QObject *> connections = connections_;
+    for (QObject *c : connections)
+    {
+        QMetaObject::invokeMethod(c, "forceClose", Qt::DirectConnection);
+    }
+}
+
+void ProxyReactor::stop()
+{
+    close();
+    closeAllConnections();
+}
+
+void ProxyReactor::incomingConnection(qintptr socketDescriptor)
+{
+    sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    getpeername(socketDescriptor, (sockaddr*)&addr, &addr_len);
+    char *ip = inet_ntoa(addr.sin_addr);
+
+    QObject *connection = factory_(socketDescriptor, ip, spliceRelay_->isStarted() ? spliceRelay_ : nullptr);
+    connect(connection, SIGNAL(finished(QString)), this, SLOT(onConnectionFinished(QString)));
+    connections_.insert(connection);
+    emit userConnected(ip);
+    emit connectionsCountChanged(index_, connections_.count());
+
+    // the connection lives in this thread from the start, no moveToThread() hop
+    QMetaObject::invokeMethod(connection, "start", Qt::DirectConnection);
+}
+
+void ProxyReactor::onConnectionFinished(const QString &hostname)
+{
+    QObject *connection = sender();
+    WS_ASSERT(connections_.contains(connection));
+    connections_.remove(connection);
+    connection->deleteLater();
+    emit userDisconnected(hostname);
+    emit connectionsCountChanged(index_, connections_.count());
+}
+
+
+ProxyReactorPool::ProxyReactorPool(QObject *parent, ConnectedUsersCounter *usersCounter, ProxyLogCategory logCategory,
+                                   ProxyConnectionFactory factory) : QObject(parent),
+    usersCounter_(usersCounter), logCategory_(logCategory), factory_(factory), port_(0)
+{
+}
+
+ProxyReactorPool::~ProxyReactorPool()
+{
+    stop();
+}
+
+bool ProxyReactorPool::start(quint16 port)
+{
+    WS_ASSERT(!isStarted());
+
+    const int count = qMax(1, QThread::idealThreadCount());
+    usersCounter_->setThreadsCount(count);
+    port_ = port;
+    for (int i = 0; i < count; ++i)
+    {
+        int fd = createListenSocket(port_);
+        if (fd < 0)
+        {
+            qCCritical(logCategory_) << "Can't create the listen socket for reactor" << i << "on port" << port_ << "errno:" << errno;
+            stop();
+            return false;
+        }
+        if (port_ == 0)
+        {
+            // the first listener got an ephemeral port, the others join it
+            sockaddr_in addr;
+            socklen_t addr_len = sizeof(addr);
+            getsockname(fd, (sockaddr*)&addr, &addr_len);
+            port_ = ntohs(addr.sin_port);
+        }
+
+        Reactor r;
+        r.spliceRelay = std::make_unique<SpliceRelay>();
+        if (!r.spliceRelay->start())
+        {
+            qCWarning(logCategory_) << "Can't start the splice relay for reactor" << i << ", its connections will be relayed in user space";
+        }
+        r.thread = new QThread(this);
+        r.reactor = new ProxyReactor(i, fd, r.spliceRelay.get(), logCategory_, factory_);
+        r.reactor->moveToThread(r.thread);
+        connect(r.thread, &QThread::finished, r.reactor, &QObject::deleteLater);
+        connect(r.reactor, &ProxyReactor::connectionsCountChanged, this, &ProxyReactorPool::onConnectionsCountChanged);
+        connect(r.reactor, &ProxyReactor::userConnected, this, &ProxyReactorPool::onUserConnected);
+        connect(r.reactor, &ProxyReactor::userDisconnected, this, &ProxyReactorPool::onUserDisconnected);
+        r.thread->start();
+        ProxyReactor *reactor = r.reactor;
+        reactors_.push_back(std::move(r));
+
+        bool isListening = false;
+        QMetaObject::invokeMethod(reactor, "start", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, isListening));
+        if (!isListening)
+        {
+            stop();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ProxyReactorPool::stop()
+{
+    for (Reactor &r : reactors_)
+    {
+        QMetaObject::invokeMethod(r.reactor, "stop", Qt::BlockingQueuedConnection);
+        r.thread->quit();
+    }
+    for (Reactor &r : reactors_)
+    {
+        r.thread->wait();
+        r.spliceRelay->stop();
+        r.thread->deleteLater();
+    }
+    if (!reactors_.empty())
+    {
+        reactors_.clear();
+        usersCounter_->reset();
+    }
+}
+
+void ProxyReactorPool::closeAllConnections()
+{
+    for (const Reactor &r : reactors_)
+    {
+        QMetaObject::invokeMethod(r.reactor, "closeAllConnections", Qt::QueuedConnection);
+    }
+}
+
+void ProxyReactorPool::onConnectionsCountChanged(int reactorIndex, int count)
+{
+    // late notifications from a stopped pool are ignored
+    if (reactorIndex < reactorsCount())
+    {
+        usersCounter_->setThreadLoad(reactorIndex, count);
+    }
+}
+
+void ProxyReactorPool::onUserConnected(const QString &hostname)
+{
+    if (isStarted())
+    {
+        usersCounter_->newUserConnected(hostname);
+    }
+}
+
+void ProxyReactorPool::onUserDisconnected(const QString &hostname)
+{
+    // the counter is reset by the server when the pool is stopped
+    if (isStarted())
+    {
+        usersCounter_->userDiconnected(hostname);
+    }
+}
+
+int ProxyReactorPool::createListenSocket(quint16 port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    int on = 1;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0 ||
+        bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(fd, SOMAXCONN) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QLoggingCategory>
+#include <QObject>
+#include <QSet>
+#include <QTcpServer>
+#include <QThread>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "connecteduserscounter.h"
+#include "socketutils/splicerelay_linux.h"
+
+// Alternative connection engine for the proxy servers (Linux only).
+// Instead of accepting in one thread and moving every connection to the least busy of 4 threads, the pool runs
+// one reactor per core. Every reactor has its own SO_REUSEPORT listener on the proxy port, so the kernel spreads
+// incoming connections between them, the connection object is created directly in the reactor's thread,
+// and its relay phase goes to the reactor's own splice relay.
+
+// Creates a connection object (HttpProxyConnection or SocksProxyConnection) in the calling reactor's thread.
+// The object must have the finished(QString) signal and the start() and forceClose() slots.
+typedef std::function<QObject *(qintptr socketDescriptor, const QString &hostname, SpliceRelay *spliceRelay)> ProxyConnectionFactory;
+typedef const QLoggingCategory &(*ProxyLogCategory)();
+
+class ProxyReactor : public QTcpServer
+{
+    Q_OBJECT
+public:
+    ProxyReactor(int index, int listenSocket, SpliceRelay *spliceRelay, ProxyLogCategory logCategory, ProxyConnectionFactory factory);
+
+public slots:
+    // must run in the reactor's thread, returns false if the listen socket can't be used
+    bool start();
+    void closeAllConnections();
+    void stop();
+
+signals:
+    void connectionsCountChanged(int reactorIndex, int count);
+    void userConnected(const QString &hostname);
+    void userDisconnected(const QString &hostname);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private slots:
+    void onConnectionFinished(const QString &hostname);
+
+private:
+    int index_;
+    int listenSocket_;
+    SpliceRelay *spliceRelay_;
+    ProxyLogCategory logCategory_;
+    ProxyConnectionFactory factory_;
+    QSet<QObject *> connections_;
+};
+
+class ProxyReactorPool : public QObject
+{
+    Q_OBJECT
+public:
+    ProxyReactorPool(QObject *parent, ConnectedUsersCounter *usersCounter, ProxyLogCategory logCategory, ProxyConnectionFactory factory);
+    ~ProxyReactorPool();
+
+    bool start(quint16 port);
+    void stop();
+    void closeAllConnections();
+
+    bool isStarted() const { return !reactors_.empty(); }
+    quint16 port() const { return port_; }
+    int reactorsCount() const { return static_cast<int>(reactors_.size()); }
+
+private slots:
+    void onConnectionsCountChanged(int reactorIndex, int count);
+    void onUserConnected(const QString &hostname);
+    void onUserDisconnected(const QString &hostname);
+
+private:
+    struct Reactor
+    {
+        QThread *thread = nullptr;
+        ProxyReactor *reactor = nullptr;
+        std::unique_ptr<SpliceRelay> spliceRelay;
+    };
+
+    ConnectedUsersCounter *usersCounter_;
+    ProxyLogCategory logCategory_;
+    ProxyConnectionFactory factory_;
+    std::vector<Reactor> reactors_;
+    quint16 port_;
+
+    static int createListenSocket(quint16 port);
+};
@@ -1,45 +1,107 @@
 #include "socketwriteall.h"
+#include "utils/ws_assert.h"
 
 SocketWriteAll::SocketWriteAll(QObject *parent, QTcpSocket *socket) : QObject(parent),
-    socket_(socket), bEmitAllDataWritten_(false)
+    socket_(socket), frontOffset_(0), queuedBytes_(0), bEmitAllDataWritten_(false),
+    highWaterMark_(kDefaultHighWaterMark), lowWaterMark_(kDefaultLowWaterMark), bFull_(false),
+    peakBufferedBytes_(0), pauseCount_(0)
 {
     connect(socket_, &QTcpSocket::bytesWritten, this, &SocketWriteAll::onBytesWritten);
 }
 
 void SocketWriteAll::write(const QByteArray &arr)
 {
-    if (arr_.isEmpty())
+    if (arr.isEmpty())
     {
-        arr_ = arr;
-        socket_->write(arr_);
+        return;
     }
-    else
+
+    // QByteArray is implicitly shared, so queuing it doesn't copy the data
+    segments_.push_back(arr);
+    queuedBytes_ += arr.size();
+    writeToSocket();
+
+    const qint64 buffered = bufferedBytes();
+    peakBufferedBytes_ = qMax(peakBufferedBytes_, buffered);
+    if (!bFull_ && buffered >= highWaterMark_)
     {
-        arr_.append(arr);
+        bFull_ = true;
+        pauseCount_++;
+        emit highWaterMarkReached();
     }
 }
 
 void SocketWriteAll::setEmitAllDataWritten()
 {
-    if (arr_.isEmpty())
+    if (isAllDataWritten())
     {
         emit allDataWriteFinished();
     }
     bEmitAllDataWritten_ = true;
 }
 
+void SocketWriteAll::setWaterMarks(qint64 highWaterMark, qint64 lowWaterMark)
+{
+    WS_ASSERT(lowWaterMark < highWaterMark);
+    highWaterMark_ = highWaterMark;
+    lowWaterMark_ = lowWaterMark;
+}
+
+qint64 SocketWriteAll::bufferedBytes() const
+{
+    return queuedBytes_ + socket_->bytesToWrite();
+}
+
+SocketWriteAllStats SocketWriteAll::stats() const
+{
+    SocketWriteAllStats s;
+    s.bufferedBytes = bufferedBytes();
+    s.peakBufferedBytes = peakBufferedBytes_;
+    s.pauseCount = pauseCount_;
+    return s;
+}
+
 void SocketWriteAll::onBytesWritten(qint64 bytes)
 {
-    arr_.remove(0, bytes);
-    if (!arr_.isEmpty())
+    Q_UNUSED(bytes);
+    writeToSocket();
+
+    if (bFull_ && bufferedBytes() <= lowWaterMark_)
     {
-        socket_->write(arr_);
+        bFull_ = false;
+        emit lowWaterMarkReached();
     }
-    else
+
+    if (bEmitAllDataWritten_ && isAllDataWritten())
+    {
+        emit allDataWriteFinished();
+    }
+}
+
+bool SocketWriteAll::isAllDataWritten() const
+{
+    // the socket's own buffer must be drained too, closing the socket earlier would lose the tail of the data
+    return segments_.empty() && socket_->bytesToWrite() == 0;
+}
+
+void SocketWriteAll::writeToSocket()
+{
+    // keep only a bounded amount of data in the socket's own buffer, the rest stays in the segments
+    while (!segments_.empty() && socket_->bytesToWrite() < kMaxInSocketBuffer)
     {
-        if (bEmitAllDataWritten_)
+        const QByteArray &front = segments_.front();
+        qint64 len = qMin<qint64>(front.size() - frontOffset_, kMaxInSocketBuffer - socket_->bytesToWrite());
+        qint64 written = socket_->write(front.constData() + frontOffset_, len);
+        if (written <= 0)
+        {
+            break;
+        }
+        frontOffset_ += written;
+        queuedBytes_ -= written;
+        if (frontOffset_ == front.size())
         {
-            emit allDataWriteFinished();
+            segments_.pop_front();
+            frontOffset_ = 0;
         }
     }
 }
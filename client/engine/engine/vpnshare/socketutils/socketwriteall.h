@@ -2,7 +2,20 @@
 
 #include <QObject>
 #include <QTcpSocket>
+#include <deque>
 
+// Per-connection statistics of the write buffer
+struct SocketWriteAllStats
+{
+    qint64 bufferedBytes = 0;
+    qint64 peakBufferedBytes = 0;
+    quint32 pauseCount = 0;
+};
+
+// Queues data for a socket and writes it in chunks as the socket drains.
+// The queue is a list of segments, so a partial write never moves the backlog in memory.
+// When the buffered amount reaches the high-water mark highWaterMarkReached() is emitted, the producer is expected
+// to stop reading from the opposite socket until lowWaterMarkReached() is emitted.
 class SocketWriteAll : public QObject
 {
     Q_OBJECT
@@ -10,16 +23,47 @@ public:
     explicit SocketWriteAll(QObject *parent, QTcpSocket *socket);
     void write(const QByteArray &arr);
 
+    // allDataWriteFinished() is emitted once the queue and the socket's buffer are empty
     void setEmitAllDataWritten();
+    bool isEmpty() const { return segments_.empty(); }
+
+    void setWaterMarks(qint64 highWaterMark, qint64 lowWaterMark);
+    bool isFull() const { return bFull_; }
+
+    // queued data plus data already handed to the socket but not yet written to the OS
+    qint64 bufferedBytes() const;
+    SocketWriteAllStats stats() const;
+
+    static constexpr qint64 kDefaultHighWaterMark = 1024 * 1024;
+    static constexpr qint64 kDefaultLowWaterMark = 256 * 1024;
+    // read buffer size for the socket feeding this writer, so Qt stops reading from the OS while the producer is paused
+    static constexpr qint64 kSourceReadBufferSize = 256 * 1024;
 
 signals:
     void allDataWriteFinished();
+    void highWaterMarkReached();
+    void lowWaterMarkReached();
 
 private slots:
     void onBytesWritten(qint64 bytes);
 
 private:
+    // how much data is handed to the QTcpSocket internal buffer at once
+    static constexpr qint64 kMaxInSocketBuffer = 64 * 1024;
+
     QTcpSocket *socket_;
-    QByteArray arr_;
+    std::deque<QByteArray> segments_;
+    qsizetype frontOffset_;
+    qint64 queuedBytes_;
     bool bEmitAllDataWritten_;
+
+    qint64 highWaterMark_;
+    qint64 lowWaterMark_;
+    bool bFull_;
+
+    qint64 peakBufferedBytes_;
+    quint32 pauseCount_;
+
+    void writeToSocket();
+    bool isAllDataWritten() const;
 };
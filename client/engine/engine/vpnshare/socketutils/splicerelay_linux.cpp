@@ -0,0 +1,321 @@
+#include "splicerelay_linux.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+SpliceRelay::SpliceRelay()
+{
+}
+
+SpliceRelay::~SpliceRelay()
+{
+    stop();
+}
+
+bool SpliceRelay::start()
+{
+    if (isStarted())
+        return true;
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd_ < 0)
+        return false;
+
+    wakeupFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd_ < 0) {
+        close(epollFd_);
+        epollFd_ = -1;
+        return false;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kWakeupTag;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeupFd_, &ev) < 0) {
+        close(wakeupFd_);
+        close(epollFd_);
+        wakeupFd_ = epollFd_ = -1;
+        return false;
+    }
+
+    stop_ = false;
+    thread_ = std::thread(&SpliceRelay::run, this);
+    return true;
+}
+
+void SpliceRelay::stop()
+{
+    if (thread_.joinable()) {
+        stop_ = true;
+        uint64_t one = 1;
+        ssize_t ret = write(wakeupFd_, &one, sizeof(one));
+        (void)ret;
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    for (Relay &relay : slab_) {
+        if (relay.id != 0)
+            releaseRelay(&relay);
+    }
+
+    if (wakeupFd_ >= 0) {
+        close(wakeupFd_);
+        wakeupFd_ = -1;
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+        epollFd_ = -1;
+    }
+}
+
+uint64_t SpliceRelay::add(int fd1, int fd2, FinishedCallback onFinished)
+{
+    Relay relay;
+    relay.fd[0] = fd1;
+    relay.fd[1] = fd2;
+    relay.onFinished = std::move(onFinished);
+
+    bool ok = isStarted();
+    for (int i = 0; ok && i < 2; ++i) {
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+            ok = false;
+            break;
+        }
+        Direction &d = relay.dir[i];
+        d.from = relay.fd[i];
+        d.to = relay.fd[1 - i];
+        d.pipeRead = fds[0];
+        d.pipeWrite = fds[1];
+    }
+    for (int i = 0; ok && i < 2; ++i) {
+        int flags = fcntl(relay.fd[i], F_GETFL);
+        ok = flags >= 0 && fcntl(relay.fd[i], F_SETFL, flags | O_NONBLOCK) >= 0;
+    }
+    if (!ok) {
+        closeRelay(&relay);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    uint32_t slot;
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slab_.size());
+        slab_.emplace_back();
+    }
+    generation_ = (generation_ + 1) & 0x7FFFFFFF;
+    if (generation_ == 0)
+        generation_ = 1;
+    relay.id = (static_cast<uint64_t>(generation_) << 32) | slot;
+
+    for (int i = 0; i < 2; ++i) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = (relay.id << 1) | i;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, relay.fd[i], &ev) < 0) {
+            closeRelay(&relay);
+            freeSlots_.push_back(slot);
+            return 0;
+        }
+        relay.events[i] = ev.events;
+    }
+
+    slab_[slot] = std::move(relay);
+    count_++;
+    return slab_[slot].id;
+}
+
+void SpliceRelay::remove(uint64_t id)
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    Relay *relay = findRelay(id);
+    if (relay)
+        releaseRelay(relay);
+}
+
+size_t SpliceRelay::count() const
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    return count_;
+}
+
+void SpliceRelay::run()
+{
+    const int kMaxEvents = 64;
+    struct epoll_event events[kMaxEvents];
+
+    while (!stop_) {
+        int n = epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        // The lock is held for the whole batch, this way remove() called from a connection's thread
+        // either happens before we touch the relay or after its callback has already been delivered.
+        std::lock_guard<std::mutex> locker(mutex_);
+        for (int i = 0; i < n && !stop_; ++i) {
+            if (events[i].data.u64 == kWakeupTag)
+                continue;
+
+            Relay *relay = findRelay(events[i].data.u64 >> 1);
+            if (!relay)
+                continue;   // already removed by an event earlier in this batch
+
+            const int index = events[i].data.u64 & 1;
+            bool alive = pump(relay);
+            if (alive && (events[i].events & EPOLLERR))
+                alive = false;
+            else if (alive && (events[i].events & EPOLLHUP))
+                alive = onHangup(relay, index);
+            if (!alive) {
+                FinishedCallback callback = std::move(relay->onFinished);
+                releaseRelay(relay);
+                if (callback)
+                    callback();
+            }
+        }
+    }
+}
+
+// returns false if the relay is finished (closed by both peers or failed)
+bool SpliceRelay::pump(Relay *relay)
+{
+    for (int i = 0; i < 2; ++i) {
+        if (!transfer(relay->dir[i], relay->detached[i]))
+            return false;
+    }
+    if (relay->dir[0].done && relay->dir[1].done)
+        return false;
+
+    updateInterest(relay);
+    return true;
+}
+
+// EPOLLHUP is reported regardless of the interest mask, so a hung up socket is taken out of the epoll set
+// to avoid spinning. Nothing can be written to it anymore, what is left to read from it is pumped
+// while serving events of the other socket.
+bool SpliceRelay::onHangup(Relay *relay, int index)
+{
+    relay->dir[1 - index].done = true;
+    if (!relay->detached[index]) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, relay->fd[index], nullptr);
+        relay->detached[index] = true;
+    }
+    return pump(relay);
+}
+
+bool SpliceRelay::transfer(Direction &d, bool sourceDetached)
+{
+    if (d.done)
+        return true;
+
+    // a detached source produces no more events, so it is read until EOF or until the destination blocks
+    for (int round = 0; sourceDetached || round < kMaxRoundsPerEvent; ++round) {
+        // flush what is already in the pipe before reading more
+        while (d.inPipe > 0) {
+            ssize_t n = splice(d.pipeRead, nullptr, d.to, nullptr, d.inPipe, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0) {
+                d.inPipe -= n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && errno == EAGAIN) {
+                return true;    // wait for EPOLLOUT on the destination
+            } else {
+                return false;
+            }
+        }
+
+        if (d.eof) {
+            // propagate the half-close to the other side
+            shutdown(d.to, SHUT_WR);
+            d.done = true;
+            return true;
+        }
+
+        ssize_t n = splice(d.from, nullptr, d.pipeWrite, nullptr, kSpliceChunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            d.inPipe += n;
+        } else if (n == 0) {
+            d.eof = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN) {
+            return true;        // the pipe is empty here, so the source has no data
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SpliceRelay::updateInterest(Relay *relay)
+{
+    for (int i = 0; i < 2; ++i) {
+        if (relay->detached[i])
+            continue;
+        // relay->dir[i] reads from fd[i], relay->dir[1 - i] writes to fd[i]
+        const Direction &reader = relay->dir[i];
+        const Direction &writer = relay->dir[1 - i];
+        uint32_t events = 0;
+        if (!reader.done && !reader.eof && reader.inPipe == 0)
+            events |= EPOLLIN;
+        if (!writer.done && writer.inPipe > 0)
+            events |= EPOLLOUT;
+
+        if (events != relay->events[i]) {
+            struct epoll_event ev = {};
+            ev.events = events;
+            ev.data.u64 = (relay->id << 1) | i;
+            if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, relay->fd[i], &ev) == 0)
+                relay->events[i] = events;
+        }
+    }
+}
+
+void SpliceRelay::closeRelay(Relay *relay)
+{
+    for (int i = 0; i < 2; ++i) {
+        if (relay->fd[i] >= 0) {
+            if (epollFd_ >= 0 && !relay->detached[i])
+                epoll_ctl(epollFd_, EPOLL_CTL_DEL, relay->fd[i], nullptr);
+            close(relay->fd[i]);
+            relay->fd[i] = -1;
+        }
+        Direction &d = relay->dir[i];
+        if (d.pipeRead >= 0) {
+            close(d.pipeRead);
+            d.pipeRead = -1;
+        }
+        if (d.pipeWrite >= 0) {
+            close(d.pipeWrite);
+            d.pipeWrite = -1;
+        }
+    }
+}
+
+SpliceRelay::Relay *SpliceRelay::findRelay(uint64_t id)
+{
+    const uint32_t slot = static_cast<uint32_t>(id & 0xFFFFFFFF);
+    if (id == 0 || slot >= slab_.size() || slab_[slot].id != id)
+        return nullptr;
+    return &slab_[slot];
+}
+
+void SpliceRelay::releaseRelay(Relay *relay)
+{
+    const uint32_t slot = static_cast<uint32_t>(relay->id & 0xFFFFFFFF);
+    closeRelay(relay);
+    *relay = Relay();
+    freeSlots_.push_back(slot);
+    count_--;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Relays data between pairs of connected TCP sockets entirely in the kernel (Linux only).
+// Each direction is moved with splice() through its own pipe, so the payload is never copied into user space.
+// All relays share one epoll thread, the Qt event loop is not involved after the sockets are handed over.
+class SpliceRelay
+{
+public:
+    typedef std::function<void()> FinishedCallback;
+
+    SpliceRelay();
+    ~SpliceRelay();
+
+    bool start();
+    // closes all active relays without calling their callbacks
+    void stop();
+    bool isStarted() const { return thread_.joinable(); }
+
+    // Takes ownership of both descriptors (they are closed on failure too).
+    // Returns the relay id, or 0 if the relay could not be created.
+    // onFinished is called from the relay thread when both directions are closed or an error occurred.
+    uint64_t add(int fd1, int fd2, FinishedCallback onFinished);
+    // After return, the relay's descriptors are closed and its callback is guaranteed not to be called.
+    void remove(uint64_t id);
+
+    size_t count() const;
+
+private:
+    struct Direction
+    {
+        int from = -1;
+        int to = -1;
+        int pipeRead = -1;
+        int pipeWrite = -1;
+        size_t inPipe = 0;
+        bool eof = false;
+        bool done = false;
+    };
+
+    // relays live in a flat slab, the id is the slot index plus a generation counter to catch stale ids
+    struct Relay
+    {
+        uint64_t id = 0;    // 0 for a free slot
+        int fd[2] = { -1, -1 };
+        uint32_t events[2] = { 0, 0 };
+        bool detached[2] = { false, false };
+        Direction dir[2];
+        FinishedCallback onFinished;
+    };
+
+    static constexpr size_t kSpliceChunk = 64 * 1024;
+    static constexpr int kMaxRoundsPerEvent = 16;
+    static constexpr uint64_t kWakeupTag = UINT64_MAX;
+
+    int epollFd_ = -1;
+    int wakeupFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> stop_ = false;
+
+    mutable std::mutex mutex_;
+    std::vector<Relay> slab_;
+    std::vector<uint32_t> freeSlots_;
+    uint32_t generation_ = 0;
+    size_t count_ = 0;
+
+    void run();
+    bool pump(Relay *relay);
+    bool onHangup(Relay *relay, int index);
+    bool transfer(Direction &d, bool sourceDetached);
+    void updateInterest(Relay *relay);
+    void closeRelay(Relay *relay);
+    Relay *findRelay(uint64_t id);
+    void releaseRelay(Relay *relay);
+};
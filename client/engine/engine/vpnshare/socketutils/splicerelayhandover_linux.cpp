@@ -0,0 +1,42 @@
+#include "splicerelayhandover_linux.h"
+
+#include <unistd.h>
+
+namespace SpliceRelayHandover {
+
+bool isReady(QTcpSocket *socket1, const SocketWriteAll *writeAll1, QTcpSocket *socket2, const SocketWriteAll *writeAll2)
+{
+    return writeAll1->isEmpty() && writeAll2->isEmpty() &&
+           socket1->bytesToWrite() == 0 && socket2->bytesToWrite() == 0 &&
+           socket1->bytesAvailable() == 0 && socket2->bytesAvailable() == 0 &&
+           socket1->state() == QAbstractSocket::ConnectedState && socket2->state() == QAbstractSocket::ConnectedState;
+}
+
+quint64 handOver(SpliceRelay *relay, QTcpSocket *socket1, QTcpSocket *socket2, QObject *receiver, std::function<void()> onFinished)
+{
+    int fd1 = ::dup(socket1->socketDescriptor());
+    if (fd1 < 0) {
+        return 0;
+    }
+    int fd2 = ::dup(socket2->socketDescriptor());
+    if (fd2 < 0) {
+        ::close(fd1);
+        return 0;
+    }
+
+    // The Qt socket notifiers belong to this thread, so Qt won't touch the descriptors until we return
+    // to the event loop, and by then the QTcpSockets are already aborted.
+    quint64 id = relay->add(fd1, fd2, std::move(onFinished));
+    if (id == 0) {
+        return 0;
+    }
+
+    // abort() only closes Qt's copy of the descriptor, the connection stays open through the duplicate
+    socket1->disconnect(receiver);
+    socket2->disconnect(receiver);
+    socket1->abort();
+    socket2->abort();
+    return id;
+}
+
+} // namespace SpliceRelayHandover
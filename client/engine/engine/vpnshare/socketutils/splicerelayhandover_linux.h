@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QTcpSocket>
+#include <functional>
+#include "socketwriteall.h"
+#include "splicerelay_linux.h"
+
+// Helpers to move a pair of connected QTcpSockets from the Qt event loop to the SpliceRelay.
+namespace SpliceRelayHandover {
+
+// the handover is only safe when neither Qt nor SocketWriteAll still buffer data in either direction
+bool isReady(QTcpSocket *socket1, const SocketWriteAll *writeAll1, QTcpSocket *socket2, const SocketWriteAll *writeAll2);
+
+// Duplicates the descriptors into the relay, then disconnects the sockets from the receiver and aborts them.
+// Returns the relay id or 0 if the relay could not take the sockets (in this case they are left untouched).
+quint64 handOver(SpliceRelay *relay, QTcpSocket *socket1, QTcpSocket *socket2, QObject *receiver, std::function<void()> onFinished);
+
+} // namespace SpliceRelayHandover
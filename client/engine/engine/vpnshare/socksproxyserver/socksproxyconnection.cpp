@@ -4,6 +4,10 @@
 #include "utils/ws_assert.h"
 #include "utils/log/categories.h"
 
+#ifdef Q_OS_LINUX
+    #include "../socketutils/splicerelayhandover_linux.h"
+#endif
+
 namespace SocksProxyServer {
 
 
@@ -25,9 +29,12 @@ void SocksProxyConnection::start()
     }
     state_ = READ_IDENT_REQ;
     readExactly_.reset(new SocksProxyReadExactly(sizeof(socks5_ident_req)));
+    socket_->setReadBufferSize(SocketWriteAll::kSourceReadBufferSize);
     connect(socket_, &QTcpSocket::disconnected, this, &SocksProxyConnection::onSocketDisconnected);
     connect(socket_, &QTcpSocket::readyRead, this, &SocksProxyConnection::onSocketReadyRead);
     writeAllSocket_ = new SocketWriteAll(this, socket_);
+    // the client is slower than the remote host, stop reading from the remote host until the client catches up
+    connect(writeAllSocket_, &SocketWriteAll::lowWaterMarkReached, this, &SocksProxyConnection::onExternalSocketReadyRead);
 }
 
 void SocksProxyConnection::forceClose()
@@ -43,6 +50,16 @@ void SocksProxyConnection::onSocketDisconnected()
 
 void SocksProxyConnection::onSocketReadyRead()
 {
+    // reading is paused, the data stays in the socket buffers until lowWaterMarkReached()
+    if (writeAllSocketExternal_ && writeAllSocketExternal_->isFull())
+    {
+        return;
+    }
+    if (socket_->bytesAvailable() == 0)
+    {
+        return;
+    }
+
     socketReadArr_.append(socket_->readAll());
 
     if (state_ == READ_IDENT_REQ)
@@ -104,6 +121,7 @@ void SocksProxyConnection::onSocketReadyRead()
             {
                 WS_ASSERT(socketExternal_ == NULL);
                 socketExternal_ = new QTcpSocket(this);
+                socketExternal_->setReadBufferSize(SocketWriteAll::kSourceReadBufferSize);
 
                 connect(socketExternal_, &QTcpSocket::connected, this, &SocksProxyConnection::onExternalSocketConnected);
                 connect(socketExternal_, &QTcpSocket::disconnected, this, &SocksProxyConnection::onExternalSocketDisconnected);
@@ -111,6 +129,7 @@ void SocksProxyConnection::onSocketReadyRead()
                 connect(socketExternal_, &QTcpSocket::errorOccurred, this, &SocksProxyConnection::onExternalSocketError);
 
                 writeAllSocketExternal_ = new SocketWriteAll(this, socketExternal_);
+                connect(writeAllSocketExternal_, &SocketWriteAll::lowWaterMarkReached, this, &SocksProxyConnection::onSocketReadyRead);
                 state_ = CONNECT_TO_HOST;
 
                 if (commandParser_.cmd().AddrType == 0x01)  // ip4
@@ -137,7 +156,11 @@ void SocksProxyConnection::onSocketReadyRead()
             }
             else if (commandParser_.cmd().Cmd == 0x03)  // udp associate
             {
-                WS_ASSERT(false);
+#ifdef Q_OS_LINUX
+                startUdpAssociate();
+#else
+                writeReplyAndClose(0x07);   // command not supported
+#endif
             }
             else
             {
@@ -162,6 +185,11 @@ void SocksProxyConnection::onSocketReadyRead()
         writeAllSocketExternal_->write(socketReadArr_);
         socketReadArr_.clear();
     }
+    else if (state_ == UDP_ASSOCIATED)
+    {
+        // the TCP connection only controls the lifetime of the UDP association, nothing is expected on it
+        socketReadArr_.clear();
+    }
     else
     {
         qCCritical(LOG_SOCKS_SERVER) << "SocksProxyConnection::onSocketReadyRead() unknown state:" << state_;
@@ -187,6 +215,9 @@ void SocksProxyConnection::onExternalSocketConnected()
         //memset(&resp.BindAddr.IPv4, 0, sizeof(resp.BindAddr.IPv4));
         writeAllSocket_->write(getByteArrayFromSocks5Resp(resp));
         state_ = RELAY_BETWEEN_CLIENT_SERVER;
+#ifdef Q_OS_LINUX
+        startWaitingForSpliceRelay();
+#endif
     }
     else
     {
@@ -210,6 +241,11 @@ void SocksProxyConnection::onExternalSocketDisconnected()
 
 void SocksProxyConnection::onExternalSocketReadyRead()
 {
+    if (!socketExternal_ || writeAllSocket_->isFull() || socketExternal_->bytesAvailable() == 0)
+    {
+        return;
+    }
+
     QByteArray arr = socketExternal_->readAll();
     if (state_ == RELAY_BETWEEN_CLIENT_SERVER)
     {
@@ -268,6 +304,19 @@ void SocksProxyConnection::closeSocketsAndEmitFinished()
     if (!bAlreadyClosedAndEmitFinished_)
     {
         bAlreadyClosedAndEmitFinished_ = true;
+        logBufferStats();
+#ifdef Q_OS_LINUX
+        if (spliceRelayId_)
+        {
+            spliceRelay_->remove(spliceRelayId_);
+            spliceRelayId_ = 0;
+        }
+        if (udpAssociationId_)
+        {
+            udpRelay_->close(udpAssociationId_);
+            udpAssociationId_ = 0;
+        }
+#endif
         if (socket_)
         {
             socket_->close();
@@ -280,6 +329,50 @@ void SocksProxyConnection::closeSocketsAndEmitFinished()
     }
 }
 
+void SocksProxyConnection::logBufferStats()
+{
+    const SocketWriteAllStats toClient = writeAllSocket_ ? writeAllSocket_->stats() : SocketWriteAllStats();
+    const SocketWriteAllStats toServer = writeAllSocketExternal_ ? writeAllSocketExternal_->stats() : SocketWriteAllStats();
+    // only the connections that reached the high-water mark (and paused the producer) are logged
+    if (toClient.pauseCount == 0 && toServer.pauseCount == 0)
+    {
+        return;
+    }
+    qCDebug(LOG_SOCKS_SERVER) << "Connection from" << hostname_ << "closed, to client: peak buffered" << toClient.peakBufferedBytes
+                              << "bytes, paused" << toClient.pauseCount << "times; to server: peak buffered" << toServer.peakBufferedBytes
+                              << "bytes, paused" << toServer.pauseCount << "times";
+}
+
+QByteArray SocksProxyConnection::makeSocks5Reply(unsigned char reply, const QHostAddress &bindAddr, quint16 bindPort)
+{
+    QByteArray arr;
+    arr.append((char)0x05);
+    arr.append((char)reply);
+    arr.append((char)0x00);
+    if (bindAddr.protocol() == QAbstractSocket::IPv6Protocol)
+    {
+        arr.append((char)0x04);
+        Q_IPV6ADDR ip6 = bindAddr.toIPv6Address();
+        arr.append((const char *)&ip6, sizeof(ip6));
+    }
+    else
+    {
+        arr.append((char)0x01);
+        quint32 ip4 = htonl(bindAddr.toIPv4Address());
+        arr.append((const char *)&ip4, sizeof(ip4));
+    }
+    quint16 port = htons(bindPort);
+    arr.append((const char *)&port, sizeof(port));
+    return arr;
+}
+
+void SocksProxyConnection::writeReplyAndClose(unsigned char reply)
+{
+    writeAllSocket_->write(makeSocks5Reply(reply, QHostAddress(QHostAddress::AnyIPv4), 0));
+    connect(writeAllSocket_, &SocketWriteAll::allDataWriteFinished, this, &SocksProxyConnection::closeSocketsAndEmitFinished);
+    writeAllSocket_->setEmitAllDataWritten();
+}
+
 QByteArray SocksProxyConnection::getByteArrayFromSocks5Resp(const socks5_resp &resp)
 {
     QByteArray arr;
@@ -323,5 +416,92 @@ QByteArray SocksProxyConnection::getByteArrayFromSocks5Resp(const socks5_resp &r
     return arr;
 }
 
+#ifdef Q_OS_LINUX
+void SocksProxyConnection::startWaitingForSpliceRelay()
+{
+    if (!spliceRelay_ || !spliceRelay_->isStarted())
+    {
+        return;
+    }
+    // the handover happens as soon as the socks reply and any data received so far have been flushed
+    if (!socketReadArr_.isEmpty())
+    {
+        writeAllSocketExternal_->write(socketReadArr_);
+        socketReadArr_.clear();
+    }
+    bWaitingForSpliceRelay_ = true;
+    connect(socket_, &QTcpSocket::bytesWritten, this, &SocksProxyConnection::tryHandOverToSpliceRelay);
+    connect(socketExternal_, &QTcpSocket::bytesWritten, this, &SocksProxyConnection::tryHandOverToSpliceRelay);
+    tryHandOverToSpliceRelay();
+}
+
+void SocksProxyConnection::tryHandOverToSpliceRelay()
+{
+    if (!bWaitingForSpliceRelay_ || state_ != RELAY_BETWEEN_CLIENT_SERVER || bAlreadyClosedAndEmitFinished_)
+    {
+        return;
+    }
+    if (!SpliceRelayHandover::isReady(socket_, writeAllSocket_, socketExternal_, writeAllSocketExternal_))
+    {
+        return;
+    }
+
+    bWaitingForSpliceRelay_ = false;
+    spliceRelayId_ = SpliceRelayHandover::handOver(spliceRelay_, socket_, socketExternal_, this, [this]() {
+        QMetaObject::invokeMethod(this, "closeSocketsAndEmitFinished", Qt::QueuedConnection);
+    });
+    if (spliceRelayId_ == 0)
+    {
+        qCWarning(LOG_SOCKS_SERVER) << "Can't hand over the connection to the splice relay, continue relaying in user space";
+    }
+}
+
+void SocksProxyConnection::startUdpAssociate()
+{
+    if (!udpRelay_ || !udpRelay_->isStarted())
+    {
+        qCWarning(LOG_SOCKS_SERVER) << "UDP associate requested, but the UDP relay is not available";
+        writeReplyAndClose(0x01);   // general failure
+        return;
+    }
+
+    auto toSockaddr = [](const QHostAddress &address) {
+        sockaddr_storage addr;
+        memset(&addr, 0, sizeof(addr));
+        bool isIPv4 = false;
+        quint32 ip4 = address.toIPv4Address(&isIPv4);
+        if (isIPv4)
+        {
+            sockaddr_in &a4 = reinterpret_cast<sockaddr_in &>(addr);
+            a4.sin_family = AF_INET;
+            a4.sin_addr.s_addr = htonl(ip4);
+        }
+        else
+        {
+            sockaddr_in6 &a6 = reinterpret_cast<sockaddr_in6 &>(addr);
+            a6.sin6_family = AF_INET6;
+            Q_IPV6ADDR ip6 = address.toIPv6Address();
+            memcpy(&a6.sin6_addr, &ip6, sizeof(ip6));
+        }
+        return addr;
+    };
+
+    // DST.ADDR/DST.PORT of the request is where the client will send from, all zeros if it doesn't know yet (RFC 1928)
+    const quint16 clientPort = commandParser_.cmd().DestPort;
+    quint16 boundPort = 0;
+    udpAssociationId_ = udpRelay_->open(toSockaddr(socket_->localAddress()), toSockaddr(socket_->peerAddress()), clientPort, boundPort, [this]() {
+        QMetaObject::invokeMethod(this, "closeSocketsAndEmitFinished", Qt::QueuedConnection);
+    });
+    if (udpAssociationId_ == 0)
+    {
+        qCWarning(LOG_SOCKS_SERVER) << "Can't open UDP association for" << hostname_;
+        writeReplyAndClose(0x01);   // general failure
+        return;
+    }
+
+    writeAllSocket_->write(makeSocks5Reply(0x00, socket_->localAddress(), boundPort));
+    state_ = UDP_ASSOCIATED;
+}
+#endif
 
 } // namespace SocksProxyServer
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QObject>
+#include <QHostAddress>
 #include <QTcpSocket>
 
 #include "socksstructs.h"
@@ -9,6 +10,11 @@
 #include "../socketutils/socketwriteall.h"
 #include "socksproxycommandparser.h"
 
+#ifdef Q_OS_LINUX
+    #include "../socketutils/splicerelay_linux.h"
+    #include "socksudprelay_linux.h"
+#endif
+
 namespace SocksProxyServer {
 
 class SocksProxyConnection : public QObject
@@ -16,6 +22,12 @@ class SocksProxyConnection : public QObject
     Q_OBJECT
 public:
     explicit SocksProxyConnection(qintptr socketDescriptor, const QString &hostname, QObject *parent = nullptr);
+#ifdef Q_OS_LINUX
+    // if set, the established connection is handed over to the kernel splice() relay
+    void setSpliceRelay(SpliceRelay *spliceRelay) { spliceRelay_ = spliceRelay; }
+    // if set, UDP ASSOCIATE requests are served by this relay
+    void setUdpRelay(SocksUdpRelay *udpRelay) { udpRelay_ = udpRelay; }
+#endif
 
     bool start(qintptr socketDescriptor);
 
@@ -38,13 +50,16 @@ private slots:
     void onExternalSocketError(QAbstractSocket::SocketError socketError);
 private slots:
     void closeSocketsAndEmitFinished();
+#ifdef Q_OS_LINUX
+    void tryHandOverToSpliceRelay();
+#endif
 private:
     QTcpSocket *socket_;
     QTcpSocket *socketExternal_;
     qintptr socketDescriptor_;
     QString hostname_;
 
-    enum { READ_IDENT_REQ, READ_COMMANDS, CONNECT_TO_HOST, RELAY_BETWEEN_CLIENT_SERVER } state_;
+    enum { READ_IDENT_REQ, READ_COMMANDS, CONNECT_TO_HOST, RELAY_BETWEEN_CLIENT_SERVER, UDP_ASSOCIATED } state_;
 
     QByteArray socketReadArr_;
     SocketWriteAll *writeAllSocket_;
@@ -57,6 +72,20 @@ private:
     bool bAlreadyClosedAndEmitFinished_;
 
     QByteArray getByteArrayFromSocks5Resp(const socks5_resp &resp);
+    QByteArray makeSocks5Reply(unsigned char reply, const QHostAddress &bindAddr, quint16 bindPort);
+    void writeReplyAndClose(unsigned char reply);
+    void logBufferStats();
+
+#ifdef Q_OS_LINUX
+    SpliceRelay *spliceRelay_ = nullptr;
+    quint64 spliceRelayId_ = 0;
+    bool bWaitingForSpliceRelay_ = false;
+    void startWaitingForSpliceRelay();
+
+    SocksUdpRelay *udpRelay_ = nullptr;
+    quint64 udpAssociationId_ = 0;
+    void startUdpAssociate();
+#endif
 
 };
 
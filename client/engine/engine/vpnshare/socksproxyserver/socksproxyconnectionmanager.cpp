@@ -3,6 +3,7 @@
 #include <QThread>
 #include <QTimer>
 #include "utils/ws_assert.h"
+#include "utils/log/categories.h"
 
 namespace SocksProxyServer {
 
@@ -16,6 +17,16 @@ SocksProxyConnectionManager::SocksProxyConnectionManager(QObject *parent, int th
         threads_[thread] = 0;
         thread->start(QThread::LowPriority);
     }
+#ifdef Q_OS_LINUX
+    if (!spliceRelay_.start())
+    {
+        qCWarning(LOG_SOCKS_SERVER) << "Can't start the splice relay, the connections will be relayed in user space";
+    }
+    if (!udpRelay_.start())
+    {
+        qCWarning(LOG_SOCKS_SERVER) << "Can't start the UDP relay, UDP associate requests will be rejected";
+    }
+#endif
 }
 
 void SocksProxyConnectionManager::newConnection(qintptr socketDescriptor)
@@ -33,6 +44,10 @@ void SocksProxyConnectionManager::newConnection(qintptr socketDescriptor)
 
     QThread *thread = getLessBusyThread();
     SocksProxyConnection *connection = new SocksProxyConnection(socketDescriptor, ip);
+#ifdef Q_OS_LINUX
+    connection->setSpliceRelay(&spliceRelay_);
+    connection->setUdpRelay(&udpRelay_);
+#endif
     connect(connection, &SocksProxyConnection::finished, this, &SocksProxyConnectionManager::onConnectionFinished);
     addConnectionToThread(thread, connection);
 }
@@ -55,6 +70,10 @@ void SocksProxyConnectionManager::stop()
     {
         thread->wait();
     }
+#ifdef Q_OS_LINUX
+    spliceRelay_.stop();
+    udpRelay_.stop();
+#endif
 }
 
 void SocksProxyConnectionManager::onConnectionFinished(const QString &hostname)
@@ -17,6 +17,9 @@ public:
     void newConnection(qintptr socketDescriptor);
     void closeAllConnections();
     void stop();
+#ifdef Q_OS_LINUX
+    SocksUdpRelay *udpRelay() { return &udpRelay_; }
+#endif
 
 private slots:
     void onConnectionFinished(const QString &hostname);
@@ -25,6 +28,10 @@ private:
     QMap<QThread *, quint32> threads_;
     QMap<SocksProxyConnection *, QThread *> connections_;
     ConnectedUsersCounter *usersCounter_;
+#ifdef Q_OS_LINUX
+    SpliceRelay spliceRelay_;
+    SocksUdpRelay udpRelay_;
+#endif
 
     QThread *getLessBusyThread();
     void addConnectionToThread(QThread *thread, SocksProxyConnection *connection);
@@ -1,6 +1,7 @@
 #include "socksproxyserver.h"
 #include "utils/ws_assert.h"
 #include "utils/log/categories.h"
+#include "utils/extraconfig.h"
 
 namespace SocksProxyServer {
 
@@ -8,7 +9,6 @@ SocksProxyServer::SocksProxyServer(QObject *parent) : QTcpServer(parent)
 {
     usersCounter_ = new ConnectedUsersCounter(this);
     connect(usersCounter_, &ConnectedUsersCounter::usersCountChanged, this, &SocksProxyServer::usersCountChanged);
-    connectionManager_ = new SocksProxyConnectionManager(this, 4, usersCounter_);
 }
 
 SocksProxyServer::~SocksProxyServer()
@@ -20,6 +20,39 @@ bool SocksProxyServer::startServer(quint16 port)
 {
     WS_ASSERT(!isListening());
 
+#ifdef Q_OS_LINUX
+    if (ExtraConfig::instance().getProxyMultiReactor())
+    {
+        if (!reactorPool_)
+        {
+            reactorPool_ = new ProxyReactorPool(this, usersCounter_, LOG_SOCKS_SERVER,
+                [udpRelay = &udpRelay_](qintptr socketDescriptor, const QString &hostname, SpliceRelay *spliceRelay) -> QObject * {
+                    SocksProxyConnection *connection = new SocksProxyConnection(socketDescriptor, hostname);
+                    connection->setSpliceRelay(spliceRelay);
+                    connection->setUdpRelay(udpRelay);
+                    return connection;
+                });
+        }
+        if (!udpRelay_.start())
+        {
+            qCWarning(LOG_SOCKS_SERVER) << "Can't start the UDP relay, UDP associate requests will be rejected";
+        }
+        if (reactorPool_->start(port))
+        {
+            qCInfo(LOG_SOCKS_SERVER) << "Socks proxy server started on port" << reactorPool_->port() << "with" << reactorPool_->reactorsCount() << "reactors";
+            return true;
+        }
+        udpRelay_.stop();
+        qCCritical(LOG_SOCKS_SERVER) << "Can't start socks proxy server on port" << port;
+        return false;
+    }
+#endif
+
+    // the reactors replace the worker threads of the connection manager, it is created only when they are not used
+    if (!connectionManager_)
+    {
+        connectionManager_ = new SocksProxyConnectionManager(this, 4, usersCounter_);
+    }
     if (listen(QHostAddress::AnyIPv4, port))
     {
         qCInfo(LOG_SOCKS_SERVER) << "Socks proxy server started on port" << serverPort();
@@ -39,7 +72,18 @@ void SocksProxyServer::stopServer()
         qCInfo(LOG_SOCKS_SERVER) << "Socks proxy server stopped on port" << serverPort();
         close();
     }
-    connectionManager_->stop();
+#ifdef Q_OS_LINUX
+    if (reactorPool_ && reactorPool_->isStarted())
+    {
+        qCInfo(LOG_SOCKS_SERVER) << "Socks proxy server stopped on port" << reactorPool_->port();
+        reactorPool_->stop();
+    }
+    udpRelay_.stop();
+#endif
+    if (connectionManager_)
+    {
+        connectionManager_->stop();
+    }
 }
 
 int SocksProxyServer::getConnectedUsersCount()
@@ -47,13 +91,44 @@ int SocksProxyServer::getConnectedUsersCount()
     return usersCounter_->getConnectedUsersCount();
 }
 
+int SocksProxyServer::getConnectionsCount()
+{
+    return usersCounter_->getConnectionsCount();
+}
+
+QVector<int> SocksProxyServer::getThreadLoads()
+{
+    return usersCounter_->getThreadLoads();
+}
+
+quint16 SocksProxyServer::getServerPort()
+{
+#ifdef Q_OS_LINUX
+    if (reactorPool_ && reactorPool_->isStarted())
+    {
+        return reactorPool_->port();
+    }
+#endif
+    return serverPort();
+}
+
 void SocksProxyServer::closeActiveConnections()
 {
-    connectionManager_->closeAllConnections();
+#ifdef Q_OS_LINUX
+    if (reactorPool_)
+    {
+        reactorPool_->closeAllConnections();
+    }
+#endif
+    if (connectionManager_)
+    {
+        connectionManager_->closeAllConnections();
+    }
 }
 
 void SocksProxyServer::incomingConnection(qintptr socketDescriptor)
 {
+    WS_ASSERT(connectionManager_);
     connectionManager_->newConnection(socketDescriptor);
 }
 
@@ -3,6 +3,10 @@
 #include "socksproxyconnectionmanager.h"
 #include "../connecteduserscounter.h"
 
+#ifdef Q_OS_LINUX
+    #include "../proxyreactorpool_linux.h"
+#endif
+
 #include <QTcpServer>
 
 namespace SocksProxyServer {
@@ -18,6 +22,9 @@ public:
     void stopServer();
 
     int getConnectedUsersCount();
+    int getConnectionsCount();
+    QVector<int> getThreadLoads();
+    quint16 getServerPort();
 
     void closeActiveConnections();
 
@@ -29,8 +36,13 @@ protected:
 
 
 private:
-    SocksProxyConnectionManager *connectionManager_;
+    SocksProxyConnectionManager *connectionManager_ = nullptr;
     ConnectedUsersCounter *usersCounter_;
+#ifdef Q_OS_LINUX
+    ProxyReactorPool *reactorPool_ = nullptr;
+    // the UDP relay of the connections accepted by the reactors
+    SocksUdpRelay udpRelay_;
+#endif
 };
 
 } // namespace SocksProxyServer
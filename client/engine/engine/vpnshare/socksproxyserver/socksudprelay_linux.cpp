@@ -0,0 +1,435 @@
+#include "socksudprelay_linux.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace SocksProxyServer {
+
+namespace {
+
+uint16_t portOf(const sockaddr_storage &addr)
+{
+    if (addr.ss_family == AF_INET)
+        return ntohs(reinterpret_cast<const sockaddr_in &>(addr).sin_port);
+    if (addr.ss_family == AF_INET6)
+        return ntohs(reinterpret_cast<const sockaddr_in6 &>(addr).sin6_port);
+    return 0;
+}
+
+void setPort(sockaddr_storage &addr, uint16_t port)
+{
+    if (addr.ss_family == AF_INET)
+        reinterpret_cast<sockaddr_in &>(addr).sin_port = htons(port);
+    else if (addr.ss_family == AF_INET6)
+        reinterpret_cast<sockaddr_in6 &>(addr).sin6_port = htons(port);
+}
+
+socklen_t addrLen(const sockaddr_storage &addr)
+{
+    return addr.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+}
+
+} // namespace
+
+SocksUdpRelay::SocksUdpRelay()
+{
+}
+
+SocksUdpRelay::~SocksUdpRelay()
+{
+    stop();
+}
+
+bool SocksUdpRelay::start()
+{
+    if (isStarted())
+        return true;
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeupFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeupFd_ < 0 || timerFd_ < 0) {
+        stop();
+        return false;
+    }
+
+    struct itimerspec spec = {};
+    spec.it_interval.tv_sec = kIdleCheckIntervalSec;
+    spec.it_value.tv_sec = kIdleCheckIntervalSec;
+    timerfd_settime(timerFd_, 0, &spec, nullptr);
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kWakeupTag;
+    bool ok = epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeupFd_, &ev) == 0;
+    ev.data.u64 = kTimerTag;
+    ok = ok && epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &ev) == 0;
+    if (!ok) {
+        stop();
+        return false;
+    }
+
+    buffers_.resize(kBatchSize * kMaxDatagramSize);
+    headers_.resize(kBatchSize * kMaxHeaderSize);
+    stop_ = false;
+    thread_ = std::thread(&SocksUdpRelay::run, this);
+    return true;
+}
+
+void SocksUdpRelay::stop()
+{
+    if (thread_.joinable()) {
+        stop_ = true;
+        uint64_t one = 1;
+        ssize_t ret = write(wakeupFd_, &one, sizeof(one));
+        (void)ret;
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    for (Association &a : table_) {
+        if (a.id != 0)
+            releaseAssociation(a);
+    }
+    for (int *fd : { &timerFd_, &wakeupFd_, &epollFd_ }) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+uint64_t SocksUdpRelay::open(const sockaddr_storage &bindAddr, const sockaddr_storage &clientAddr, uint16_t clientPort,
+                             uint16_t &outBoundPort, IdleCallback onIdle)
+{
+    if (!isStarted())
+        return 0;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    size_t slot = 0;
+    while (slot < table_.size() && table_[slot].id != 0)
+        ++slot;
+    if (slot == table_.size())
+        return 0;
+
+    Association a;
+    a.clientSocket = socket(bindAddr.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    // the outbound socket is dual-stack, so IPv4 and IPv6 destinations go through the same socket
+    a.outSocket = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    a.outFamily = AF_INET6;
+    if (a.outSocket >= 0) {
+        int off = 0;
+        setsockopt(a.outSocket, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    } else {
+        a.outSocket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        a.outFamily = AF_INET;
+    }
+
+    sockaddr_storage bound = bindAddr;
+    setPort(bound, 0);
+    socklen_t boundLen = addrLen(bound);
+    if (a.clientSocket < 0 || a.outSocket < 0 ||
+        bind(a.clientSocket, reinterpret_cast<const sockaddr *>(&bound), addrLen(bound)) < 0 ||
+        getsockname(a.clientSocket, reinterpret_cast<sockaddr *>(&bound), &boundLen) < 0) {
+        releaseAssociation(a);
+        return 0;
+    }
+    outBoundPort = portOf(bound);
+
+    a.clientAddr = clientAddr;
+    a.clientAddrLen = addrLen(clientAddr);
+    a.isClientPortKnown = clientPort != 0;
+    setPort(a.clientAddr, clientPort);
+    a.lastActivity = now();
+    a.onIdle = std::move(onIdle);
+
+    generation_ = (generation_ + 1) & 0x7FFFFFFF;
+    if (generation_ == 0)
+        generation_ = 1;
+    a.id = (static_cast<uint64_t>(generation_) << 16) | slot;
+
+    for (int i = 0; i < 2; ++i) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = (a.id << 1) | i;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, i == 0 ? a.clientSocket : a.outSocket, &ev) < 0) {
+            a.id = 0;   // not in the table yet, closing the sockets also removes them from the epoll set
+            releaseAssociation(a);
+            return 0;
+        }
+    }
+
+    table_[slot] = std::move(a);
+    count_++;
+    return table_[slot].id;
+}
+
+void SocksUdpRelay::close(uint64_t id)
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    Association *a = findAssociation(id);
+    if (a)
+        releaseAssociation(*a);
+}
+
+size_t SocksUdpRelay::count() const
+{
+    std::lock_guard<std::mutex> locker(mutex_);
+    return count_;
+}
+
+void SocksUdpRelay::run()
+{
+    const int kMaxEvents = 64;
+    struct epoll_event events[kMaxEvents];
+
+    while (!stop_) {
+        int n = epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        std::lock_guard<std::mutex> locker(mutex_);
+        for (int i = 0; i < n && !stop_; ++i) {
+            const uint64_t tag = events[i].data.u64;
+            if (tag == kWakeupTag)
+                continue;
+            if (tag == kTimerTag) {
+                uint64_t expirations;
+                ssize_t ret = read(timerFd_, &expirations, sizeof(expirations));
+                (void)ret;
+                evictIdle();
+                continue;
+            }
+
+            Association *a = findAssociation(tag >> 1);
+            if (!a)
+                continue;
+            if (tag & 1)
+                relayToClient(*a);
+            else
+                relayFromClient(*a);
+        }
+    }
+}
+
+void SocksUdpRelay::prepareReceive()
+{
+    for (int i = 0; i < kBatchSize; ++i) {
+        inIov_[i].iov_base = buffers_.data() + i * kMaxDatagramSize;
+        inIov_[i].iov_len = kMaxDatagramSize;
+        memset(&inMsgs_[i].msg_hdr, 0, sizeof(inMsgs_[i].msg_hdr));
+        inMsgs_[i].msg_hdr.msg_iov = &inIov_[i];
+        inMsgs_[i].msg_hdr.msg_iovlen = 1;
+        inMsgs_[i].msg_hdr.msg_name = &inAddrs_[i];
+        inMsgs_[i].msg_hdr.msg_namelen = sizeof(inAddrs_[i]);
+    }
+}
+
+// client -> destination: strip the SOCKS UDP header and send the payload to DST.ADDR:DST.PORT
+void SocksUdpRelay::relayFromClient(Association &a)
+{
+    prepareReceive();
+    int received = recvmmsg(a.clientSocket, inMsgs_.data(), kBatchSize, MSG_DONTWAIT, nullptr);
+    if (received <= 0)
+        return;
+
+    int out = 0;
+    for (int i = 0; i < received; ++i) {
+        const uint8_t *data = static_cast<const uint8_t *>(inIov_[i].iov_base);
+        const size_t len = inMsgs_[i].msg_len;
+        if (!isFromClient(a, inAddrs_[i]))
+            continue;
+        // fragmentation is not supported, such datagrams must be dropped (RFC 1928, section 7)
+        if (len < 4 || data[0] != 0 || data[1] != 0 || data[2] != 0)
+            continue;
+
+        sockaddr_storage &dest = outAddrs_[out];
+        memset(&dest, 0, sizeof(dest));
+        size_t headerLen;
+        if (data[3] == 0x01 && len >= 10) {
+            headerLen = 10;
+            if (a.outFamily == AF_INET6) {
+                sockaddr_in6 &d6 = reinterpret_cast<sockaddr_in6 &>(dest);
+                d6.sin6_family = AF_INET6;
+                d6.sin6_addr.s6_addr[10] = 0xFF;
+                d6.sin6_addr.s6_addr[11] = 0xFF;
+                memcpy(&d6.sin6_addr.s6_addr[12], data + 4, 4);
+                memcpy(&d6.sin6_port, data + 8, 2);
+            } else {
+                sockaddr_in &d4 = reinterpret_cast<sockaddr_in &>(dest);
+                d4.sin_family = AF_INET;
+                memcpy(&d4.sin_addr, data + 4, 4);
+                memcpy(&d4.sin_port, data + 8, 2);
+            }
+        } else if (data[3] == 0x04 && len >= 22 && a.outFamily == AF_INET6) {
+            headerLen = 22;
+            sockaddr_in6 &d6 = reinterpret_cast<sockaddr_in6 &>(dest);
+            d6.sin6_family = AF_INET6;
+            memcpy(&d6.sin6_addr, data + 4, 16);
+            memcpy(&d6.sin6_port, data + 20, 2);
+        } else {
+            // domain names are not resolved on the relay thread, such datagrams are dropped
+            continue;
+        }
+
+        outIov_[out].iov_base = const_cast<uint8_t *>(data + headerLen);
+        outIov_[out].iov_len = len - headerLen;
+        memset(&outMsgs_[out].msg_hdr, 0, sizeof(outMsgs_[out].msg_hdr));
+        outMsgs_[out].msg_hdr.msg_iov = &outIov_[out];
+        outMsgs_[out].msg_hdr.msg_iovlen = 1;
+        outMsgs_[out].msg_hdr.msg_name = &dest;
+        outMsgs_[out].msg_hdr.msg_namelen = a.outFamily == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+        out++;
+    }
+
+    if (out > 0) {
+        a.lastActivity = now();
+        sendBatch(a.outSocket, out);
+    }
+}
+
+// destination -> client: prepend the SOCKS UDP header with the source address
+void SocksUdpRelay::relayToClient(Association &a)
+{
+    prepareReceive();
+    int received = recvmmsg(a.outSocket, inMsgs_.data(), kBatchSize, MSG_DONTWAIT, nullptr);
+    if (received <= 0 || !a.isClientPortKnown)
+        return;
+
+    for (int i = 0; i < received; ++i) {
+        uint8_t *header = headers_.data() + i * kMaxHeaderSize;
+        size_t headerLen;
+        header[0] = header[1] = header[2] = 0;
+        const sockaddr_storage &from = inAddrs_[i];
+        if (from.ss_family == AF_INET6) {
+            const sockaddr_in6 &s6 = reinterpret_cast<const sockaddr_in6 &>(from);
+            if (IN6_IS_ADDR_V4MAPPED(&s6.sin6_addr)) {
+                header[3] = 0x01;
+                memcpy(header + 4, &s6.sin6_addr.s6_addr[12], 4);
+                memcpy(header + 8, &s6.sin6_port, 2);
+                headerLen = 10;
+            } else {
+                header[3] = 0x04;
+                memcpy(header + 4, &s6.sin6_addr, 16);
+                memcpy(header + 20, &s6.sin6_port, 2);
+                headerLen = 22;
+            }
+        } else {
+            const sockaddr_in &s4 = reinterpret_cast<const sockaddr_in &>(from);
+            header[3] = 0x01;
+            memcpy(header + 4, &s4.sin_addr, 4);
+            memcpy(header + 8, &s4.sin_port, 2);
+            headerLen = 10;
+        }
+
+        outIov_[i * 2].iov_base = header;
+        outIov_[i * 2].iov_len = headerLen;
+        outIov_[i * 2 + 1].iov_base = inIov_[i].iov_base;
+        outIov_[i * 2 + 1].iov_len = inMsgs_[i].msg_len;
+        memset(&outMsgs_[i].msg_hdr, 0, sizeof(outMsgs_[i].msg_hdr));
+        outMsgs_[i].msg_hdr.msg_iov = &outIov_[i * 2];
+        outMsgs_[i].msg_hdr.msg_iovlen = 2;
+        outMsgs_[i].msg_hdr.msg_name = &a.clientAddr;
+        outMsgs_[i].msg_hdr.msg_namelen = a.clientAddrLen;
+    }
+
+    a.lastActivity = now();
+    sendBatch(a.clientSocket, received);
+}
+
+void SocksUdpRelay::sendBatch(int socket, int count)
+{
+    int sent = 0;
+    while (sent < count) {
+        int ret = sendmmsg(socket, outMsgs_.data() + sent, count - sent, MSG_DONTWAIT);
+        if (ret > 0) {
+            sent += ret;
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && errno != EAGAIN && errno != ENOBUFS) {
+            // a single unreachable destination must not drop the rest of the batch
+            sent++;
+        } else {
+            break;      // the socket buffer is full, UDP semantics allow dropping the rest
+        }
+    }
+}
+
+void SocksUdpRelay::evictIdle()
+{
+    const int64_t current = now();
+    for (Association &a : table_) {
+        if (a.id != 0 && current - a.lastActivity > kIdleTimeoutSec) {
+            IdleCallback callback = std::move(a.onIdle);
+            releaseAssociation(a);
+            if (callback)
+                callback();
+        }
+    }
+}
+
+SocksUdpRelay::Association *SocksUdpRelay::findAssociation(uint64_t id)
+{
+    const size_t slot = id & 0xFFFF;
+    if (id == 0 || slot >= table_.size() || table_[slot].id != id)
+        return nullptr;
+    return &table_[slot];
+}
+
+void SocksUdpRelay::releaseAssociation(Association &a)
+{
+    const bool isInTable = a.id != 0;
+    for (int fd : { a.clientSocket, a.outSocket }) {
+        if (fd >= 0) {
+            if (epollFd_ >= 0 && isInTable)
+                epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+        }
+    }
+    a = Association();
+    if (isInTable && count_ > 0)
+        count_--;
+}
+
+bool SocksUdpRelay::isFromClient(Association &a, const sockaddr_storage &from)
+{
+    if (from.ss_family != a.clientAddr.ss_family)
+        return false;
+
+    bool isSameHost;
+    if (from.ss_family == AF_INET) {
+        isSameHost = reinterpret_cast<const sockaddr_in &>(from).sin_addr.s_addr ==
+                     reinterpret_cast<const sockaddr_in &>(a.clientAddr).sin_addr.s_addr;
+    } else {
+        isSameHost = memcmp(&reinterpret_cast<const sockaddr_in6 &>(from).sin6_addr,
+                            &reinterpret_cast<const sockaddr_in6 &>(a.clientAddr).sin6_addr, sizeof(in6_addr)) == 0;
+    }
+    if (!isSameHost)
+        return false;
+
+    if (!a.isClientPortKnown) {
+        // the client's UDP port was not announced in the request, lock to the first datagram's port
+        setPort(a.clientAddr, portOf(from));
+        a.isClientPortKnown = true;
+        return true;
+    }
+    return portOf(from) == portOf(a.clientAddr);
+}
+
+int64_t SocksUdpRelay::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+} // namespace SocksProxyServer
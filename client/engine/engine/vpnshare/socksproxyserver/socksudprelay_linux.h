@@ -0,0 +1,105 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SocksProxyServer {
+
+// Datagram relay for SOCKS5 UDP ASSOCIATE (Linux only).
+// Every association has a client-facing socket (its address is returned in the UDP ASSOCIATE reply) and an outbound
+// socket. Datagrams are moved in batches with recvmmsg()/sendmmsg() by a single epoll thread shared by all
+// associations, the SOCKS UDP header is stripped or prepended with scatter/gather I/O, so the payload is not copied.
+// Associations live in a fixed-size table and are evicted after kIdleTimeoutSec without traffic.
+class SocksUdpRelay
+{
+public:
+    typedef std::function<void()> IdleCallback;
+
+    SocksUdpRelay();
+    ~SocksUdpRelay();
+
+    bool start();
+    // closes all associations without calling their callbacks
+    void stop();
+    bool isStarted() const { return thread_.joinable(); }
+
+    // Opens an association for a client whose TCP connection comes from clientAddr (the port is ignored).
+    // The client-facing socket is bound to bindAddr (the proxy address the client connected to) with an ephemeral port.
+    // Datagrams from other hosts are dropped. If clientPort is 0, the client port is learned from the first datagram.
+    // Returns the association id, or 0 if the table is full or the sockets can't be created.
+    // onIdle is called from the relay thread when the association is evicted for inactivity.
+    uint64_t open(const sockaddr_storage &bindAddr, const sockaddr_storage &clientAddr, uint16_t clientPort,
+                  uint16_t &outBoundPort, IdleCallback onIdle);
+    // After return, the association's sockets are closed and its callback is guaranteed not to be called.
+    void close(uint64_t id);
+
+    size_t count() const;
+
+    static constexpr size_t kMaxAssociations = 256;
+    static constexpr int kIdleTimeoutSec = 120;
+
+private:
+    struct Association
+    {
+        uint64_t id = 0;    // 0 for a free slot
+        int clientSocket = -1;
+        int outSocket = -1;
+        int outFamily = AF_UNSPEC;
+        sockaddr_storage clientAddr = {};
+        socklen_t clientAddrLen = 0;
+        bool isClientPortKnown = false;
+        int64_t lastActivity = 0;
+        IdleCallback onIdle;
+    };
+
+    static constexpr int kBatchSize = 32;
+    static constexpr size_t kMaxDatagramSize = 65536;
+    // RSV(2) FRAG(1) ATYP(1) IPv6(16) PORT(2)
+    static constexpr size_t kMaxHeaderSize = 22;
+    static constexpr int kIdleCheckIntervalSec = 10;
+    static constexpr uint64_t kWakeupTag = UINT64_MAX;
+    static constexpr uint64_t kTimerTag = UINT64_MAX - 1;
+
+    int epollFd_ = -1;
+    int wakeupFd_ = -1;
+    int timerFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> stop_ = false;
+
+    mutable std::mutex mutex_;
+    std::array<Association, kMaxAssociations> table_;
+    uint32_t generation_ = 0;
+    size_t count_ = 0;
+
+    // batch buffers, used only by the relay thread
+    std::vector<uint8_t> buffers_;
+    std::vector<uint8_t> headers_;
+    std::array<mmsghdr, kBatchSize> inMsgs_;
+    std::array<mmsghdr, kBatchSize> outMsgs_;
+    std::array<iovec, kBatchSize> inIov_;
+    std::array<iovec, kBatchSize * 2> outIov_;
+    std::array<sockaddr_storage, kBatchSize> inAddrs_;
+    std::array<sockaddr_storage, kBatchSize> outAddrs_;
+
+    void run();
+    void relayFromClient(Association &a);
+    void relayToClient(Association &a);
+    void sendBatch(int socket, int count);
+    void evictIdle();
+    void prepareReceive();
+    Association *findAssociation(uint64_t id);
+    void releaseAssociation(Association &a);
+    bool isFromClient(Association &a, const sockaddr_storage &from);
+
+    static int64_t now();
+};
+
+} // namespace SocksProxyServer
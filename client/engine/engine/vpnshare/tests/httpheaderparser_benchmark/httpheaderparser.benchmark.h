@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+
+// Compares the block-scanning fast path of the HTTP proxy parsers with the byte-by-byte state machine.
+// It's actually a manual benchmark, run it in the release build.
+class HttpHeaderParser_benchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testSameResult();
+
+    void benchmarkRequests_data();
+    void benchmarkRequests();
+    void benchmarkAnswers_data();
+    void benchmarkAnswers();
+
+private:
+    QList<QByteArray> requests_;
+    QList<QByteArray> answers_;
+
+    static QList<QByteArray> toCrLf(const QList<const char *> &messages);
+};
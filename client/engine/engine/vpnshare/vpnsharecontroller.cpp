@@ -4,6 +4,7 @@
 #include <QSettings>
 
 #include "engine/connectionmanager/availableport.h"
+#include "utils/log/categories.h"
 #include "utils/network_utils/network_utils.h"
 #include "utils/utils.h"
 #include "utils/ws_assert.h"
@@ -23,6 +24,8 @@ VpnShareController::VpnShareController(QObject *parent, IHelper *helper) : QObje
     connect(wifiSharing_, &WifiSharing::usersCountChanged, this, &VpnShareController::onWifiUsersCountChanged);
     connect(wifiSharing_, &WifiSharing::failed, this, &VpnShareController::wifiSharingFailed);
 #endif
+    connect(&statsTimer_, &QTimer::timeout, this, &VpnShareController::onStatsTimer);
+    statsTimer_.start(STATS_INTERVAL);
 }
 
 VpnShareController::~VpnShareController()
@@ -116,9 +119,9 @@ QString VpnShareController::getProxySharingAddress()
 {
     QMutexLocker locker(&mutex_);
     if (httpProxyServer_) {
-        return NetworkUtils::getLocalIP() + ":" + QString::number(httpProxyServer_->serverPort());
+        return NetworkUtils::getLocalIP() + ":" + QString::number(httpProxyServer_->getServerPort());
     } else if (socksProxyServer_) {
-        return NetworkUtils::getLocalIP() + ":" + QString::number(socksProxyServer_->serverPort());
+        return NetworkUtils::getLocalIP() + ":" + QString::number(socksProxyServer_->getServerPort());
     }
 
     // Server not started yet, most likely because whileConnected is true and VPN is not connected
@@ -157,6 +160,25 @@ void VpnShareController::onProxyUsersCountChanged()
     }
 }
 
+void VpnShareController::onStatsTimer()
+{
+    QMutexLocker locker(&mutex_);
+
+    // the per-thread load is only known with the multi-reactor engine, it's empty otherwise
+    if (httpProxyServer_ && httpProxyServer_->getConnectionsCount() > 0)
+    {
+        qCInfo(LOG_HTTP_SERVER) << "Http proxy server users:" << httpProxyServer_->getConnectedUsersCount()
+                                << "connections:" << httpProxyServer_->getConnectionsCount()
+                                << "per thread:" << httpProxyServer_->getThreadLoads();
+    }
+    else if (socksProxyServer_ && socksProxyServer_->getConnectionsCount() > 0)
+    {
+        qCInfo(LOG_SOCKS_SERVER) << "Socks proxy server users:" << socksProxyServer_->getConnectedUsersCount()
+                                 << "connections:" << socksProxyServer_->getConnectionsCount()
+                                 << "per thread:" << socksProxyServer_->getThreadLoads();
+    }
+}
+
 void VpnShareController::startWifiSharing(const QString &ssid, const QString &password)
 {
     QMutexLocker locker(&mutex_);
@@ -2,6 +2,7 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QTimer>
 #include "httpproxyserver/httpproxyserver.h"
 #include "socksproxyserver/socksproxyserver.h"
 #include "engine/helper/ihelper.h"
@@ -42,6 +43,7 @@ signals:
 private slots:
     void onWifiUsersCountChanged();
     void onProxyUsersCountChanged();
+    void onStatsTimer();
 
 private:
     QRecursiveMutex mutex_;
@@ -52,10 +54,13 @@ private:
     uint port_;
     HttpProxyServer::HttpProxyServer *httpProxyServer_;
     SocksProxyServer::SocksProxyServer *socksProxyServer_;
+    QTimer statsTimer_;
 #ifdef Q_OS_WIN
     WifiSharing *wifiSharing_;
 #endif
 
+    enum { STATS_INTERVAL = 5 * 60 * 1000 };
+
     bool getLastSavedPort(uint &outPort);
     void saveLastPort(uint port);
     uint findPort(uint userPort);
@@ -2,9 +2,6 @@
 
 #include <iostream>
 #include <QTimer>
-#ifdef CLI_ONLY
-#include <unistd.h>
-#endif
 
 #include "ipc/clicommands.h"
 #include "ipc/connection.h"
@@ -41,10 +38,10 @@ void BackendCommander::initAndSend()
 
 void BackendCommander::onConnectionNewCommand(IPC::Command *command, IPC::Connection * /*connection*/)
 {
-    if (command->getStringId() == IPC::CliCommands::Acknowledge::getCommandStringId()) {
+    if (command->getId() == IPC::CliCommands::Acknowledge::kId) {
         // There are currently no commands that return a real value we need to parse here
         onAcknowledge();
-    } else if (command->getStringId() == IPC::CliCommands::State::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::State::kId) {
         if (cliArgs_.cliCommand() == CLI_COMMAND_STATUS) {
             // If we explicitly requested status, print it.
             onStateResponse(command);
@@ -56,7 +53,7 @@ void BackendCommander::onConnectionNewCommand(IPC::Command *command, IPC::Connec
             // Otherwise, this is an ongoing command in blocking mode.
             onStateUpdated(command);
         }
-    } else if (command->getStringId() == IPC::CliCommands::LocationsList::getCommandStringId()) {
+    } else if (command->getId() == IPC::CliCommands::LocationsList::kId) {
         IPC::CliCommands::LocationsList *cmd = static_cast<IPC::CliCommands::LocationsList *>(command);
 
         if (cliArgs_.cliCommand() == CLI_COMMAND_LOCATIONS_STATIC) {
@@ -232,9 +229,34 @@ void BackendCommander::sendCommand(IPC::CliCommands::State *state)
 void BackendCommander::sendStateCommand()
 {
     IPC::CliCommands::GetState cmd;
+    // the app replies with the binary frames if it supports them, the following commands are sent the same way
+    cmd.protocolVersion_ = IPC::PROTOCOL_VERSION_2;
     connection_->sendCommand(cmd);
 }
 
+// The app pushes the state changes to a subscribed CLI. The apps before the binary IPC frames do not know the subscription,
+// they are polled with GetState.
+void BackendCommander::waitForStateUpdate()
+{
+    if (bSubscribedToState_) {
+        return;
+    }
+
+    if (connection_->protocolVersion() >= IPC::PROTOCOL_VERSION_2) {
+        IPC::CliCommands::SubscribeState cmd;
+        connection_->sendCommand(cmd);
+        bSubscribedToState_ = true;
+        return;
+    }
+
+    if (cliArgs_.cliCommand() == CLI_COMMAND_UPDATE) {
+        // do not flood the app while the update is downloading
+        QTimer::singleShot(1000, this, &BackendCommander::sendStateCommand);
+        return;
+    }
+    sendStateCommand();
+}
+
 void BackendCommander::onStateResponse(IPC::Command *command)
 {
     IPC::CliCommands::State *cmd = static_cast<IPC::CliCommands::State *>(command);
@@ -307,9 +329,8 @@ void BackendCommander::onUpdateStateResponse(IPC::Command *command)
         return;
     }
 
-    // If still in progress, wait 1 second and then request state again.
-    sleep(1);
-    sendStateCommand();
+    // If still in progress, wait for the next progress update.
+    waitForStateUpdate();
 #endif
 }
 
@@ -322,7 +343,7 @@ void BackendCommander::onAcknowledge()
     }
 
     if (!cliArgs_.nonBlocking()) {
-        sendStateCommand();
+        waitForStateUpdate();
         return;
     }
 
@@ -379,7 +400,7 @@ void BackendCommander::onStateUpdated(IPC::Command *command)
                 std::cout << str << std::endl;
                 prevStr = str;
             }
-            sendStateCommand();
+            waitForStateUpdate();
         }
     } else if (cliArgs_.cliCommand() == CLI_COMMAND_DISCONNECT) {
         if (connectId_.isEmpty()) {
@@ -397,7 +418,7 @@ void BackendCommander::onStateUpdated(IPC::Command *command)
                 std::cout << str << std::endl;
                 prevStr = str;
             }
-            sendStateCommand();
+            waitForStateUpdate();
         }
     } else if (cliArgs_.cliCommand() == CLI_COMMAND_LOGIN) {
         if (cmd->loginState_ == LOGIN_STATE_LOGIN_ERROR && cmd->loginError_ == wsnet::LoginResult::kMissingCode2fa) {
@@ -411,7 +432,7 @@ void BackendCommander::onStateUpdated(IPC::Command *command)
                 std::cout << str << std::endl;
                 prevStr = str;
             }
-            sendStateCommand();
+            waitForStateUpdate();
         }
     } else if (cliArgs_.cliCommand() == CLI_COMMAND_LOGOUT) {
         if (cmd->loginState_ == LOGIN_STATE_LOGGED_OUT) {
@@ -422,7 +443,7 @@ void BackendCommander::onStateUpdated(IPC::Command *command)
                 std::cout << str << std::endl;
                 prevStr = str;
             }
-            sendStateCommand();
+            waitForStateUpdate();
         }
     } else if (cliArgs_.cliCommand() == CLI_COMMAND_UPDATE) {
         onUpdateStateResponse(command);
@@ -28,6 +28,7 @@ private slots:
 
     void sendCommand(IPC::CliCommands::State *state);
     void sendStateCommand();
+    void waitForStateUpdate();
 
 private:
     const CliArguments &cliArgs_;
@@ -41,6 +42,7 @@ private:
     QElapsedTimer loggedInTimer_;
     bool bCommandSent_ = false;
     bool bLoggingInMessageShown_ = false;
+    bool bSubscribedToState_ = false;
     QString connectId_ = "";
     QString code2fa_ = "";
 
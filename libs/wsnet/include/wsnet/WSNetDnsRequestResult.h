@@ -18,6 +18,9 @@ public:
     virtual std::vector<std::string> ips() const = 0;
     virtual std::uint32_t elapsedMs() const = 0;
     virtual std::shared_ptr<WSNetRequestError> error() const  = 0;
+    // How long the result can be cached in seconds: the minimum TTL of the returned records,
+    // for the failures it's non-zero only for the definite negative answers (no such name or no records). 0 if unknown.
+    virtual std::uint32_t ttl() const = 0;
 };
 
 } // namespace wsnet
@@ -73,6 +73,11 @@ public:
     // true by default
     virtual void setIsEnableFreshConnect(bool bEnabled) = 0;
     virtual bool isEnableFreshConnect() const = 0;
+
+    // Write the response body directly to the file (UTF-8 path, created or truncated), the data callbacks get nothing then
+    // empty by default
+    virtual void setOutputFilePath(const std::string &path) = 0;
+    virtual std::string outputFilePath() const = 0;
 };
 
 } // namespace wsnet
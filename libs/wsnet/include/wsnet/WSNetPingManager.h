@@ -10,9 +10,12 @@
 
 namespace wsnet {
 
-enum class PingType { kHttp = 0, kIcmp };
+enum class PingType { kHttp = 0, kIcmp, kTcp, kTls };
 
-typedef std::function<void(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState)> WSNetPingCallback;
+// connectTimeMs - the TCP connect time of the TCP and TLS pings, handshakeTimeMs - the ClientHello/ServerHello round trip of the TLS ping,
+// -1 if not measured
+typedef std::function<void(const std::string &ip, bool isSuccess, std::int32_t timeMs, bool isFromDisconnectedVpnState,
+                           std::int32_t connectTimeMs, std::int32_t handshakeTimeMs)> WSNetPingCallback;
 
 // Useful for testing and debugging purposes
 class WSNetPingManager : public scapix_object<WSNetPingManager>
@@ -21,8 +24,9 @@ public:
     virtual ~WSNetPingManager() {}
 
     // ip - required
-    // hostname - optional for http ping
-    // pingType: 0 - HTTP, 1 - ICMP
+    // hostname - optional for http ping, used as SNI for TLS ping
+    // pingType: 0 - HTTP, 1 - ICMP, 2 - TCP connect to port 443, 3 - TLS ClientHello/ServerHello on port 443
+    // For TCP and TLS pings timeMs is the network round trip only (connect or handshake time), without DNS, certificate verification and HTTP
     virtual std::shared_ptr<WSNetCancelableCallback> ping(const std::string &ip, const std::string &hostname,
                                                           PingType pingType, WSNetPingCallback callback) = 0;
 };
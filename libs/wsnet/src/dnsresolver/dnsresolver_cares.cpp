@@ -10,7 +10,13 @@
     #include <netinet/in.h>
     #include <arpa/inet.h>
     #include <netdb.h>
-    #include <sys/select.h>
+    #include <poll.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+    #define poll WSAPoll
 #endif
 
 namespace wsnet {
@@ -24,13 +30,20 @@ DnsResolver_cares::~DnsResolver_cares()
     g_logger->info("DnsResolver_cares destructor started");
     finish_ = true;
     condition_.notify_all();
-    thread_.join();
+    wakeup();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    closeWakeupSocket();
     g_logger->info("DnsResolver_cares destructor finished");
 }
 
 bool DnsResolver_cares::init()
 {
     if (aresLibraryInit_.init()) {
+        if (!createWakeupSocket()) {
+            g_logger->error("DnsResolver_cares cannot create the wakeup socket, new requests may wait up to {} ms", kTimeoutMs);
+        }
         thread_ = std::thread(std::bind(&DnsResolver_cares::run, this));
         return true;
     }
@@ -41,9 +54,26 @@ void DnsResolver_cares::setDnsServers(const std::vector<std::string> &dnsServers
 {
     std::lock_guard locker(mutex_);
     dnsServers_ = DnsServers(dnsServers);
+    // if the list is empty, the system DNS-servers might have changed since the last time they were used
+    isReloadSystemDnsServers_ = true;
 }
 
 std::shared_ptr<WSNetCancelableCallback> DnsResolver_cares::lookup(const std::string &hostname, std::uint64_t userDataId, WSNetDnsResolverCallback callback)
+{
+    return addToQueue(hostname, userDataId, callback, false);
+}
+
+std::shared_ptr<WSNetCancelableCallback> DnsResolver_cares::lookupDualStack(const std::string &hostname, std::uint64_t userDataId, WSNetDnsResolverCallback callback)
+{
+    return addToQueue(hostname, userDataId, callback, true);
+}
+
+void DnsResolver_cares::reloadSystemDnsServers()
+{
+    isReloadSystemDnsServers_ = true;
+}
+
+std::shared_ptr<WSNetCancelableCallback> DnsResolver_cares::addToQueue(const std::string &hostname, std::uint64_t userDataId, WSNetDnsResolverCallback callback, bool isDualStack)
 {
     std::lock_guard locker(mutex_);
     auto cancelableCallback = std::make_shared<CancelableCallback<WSNetDnsResolverCallback>>(callback);
@@ -52,11 +82,13 @@ std::shared_ptr<WSNetCancelableCallback> DnsResolver_cares::lookup(const std::st
     qi.hostname = hostname;
     qi.callback = cancelableCallback;
     qi.userDataId = userDataId;
+    qi.isDualStack = isDualStack;
     qi.requestId = curRequestId_++;
 
     activeRequests_.insert(qi.requestId);
     queue_.push(qi);
     condition_.notify_all();
+    wakeup();
 
     return cancelableCallback;
 }
@@ -102,10 +134,12 @@ void DnsResolver_cares::run()
     int optmask;
 
     memset(&options, 0, sizeof(options));
-    optmask = ARES_OPT_TRIES | ARES_OPT_TIMEOUTMS | ARES_OPT_MAXTIMEOUTMS;
+    optmask = ARES_OPT_TRIES | ARES_OPT_TIMEOUTMS | ARES_OPT_MAXTIMEOUTMS | ARES_OPT_SOCK_STATE_CB;
     options.tries = kTries;
     options.timeout = kTimeoutMs;
     options.maxtimeout = kTimeoutMs;
+    options.sock_state_cb = socketStateCallback;
+    options.sock_state_cb_data = this;
 
     [[maybe_unused]] int status = ares_init_options(&channel, &options, optmask);
     assert(status == ARES_SUCCESS);
@@ -132,45 +166,8 @@ void DnsResolver_cares::run()
             }
         }
 
-        // Check if the list of DNS-servers has changed
-        // We must to cancel current requests before installing new DNS-servers
-        if (dnsServersInstalled.isEmpty()) {    // Use default system DNS-servers
-
-            // get the current system DNS-server through a temporary channel
-            ares_channel tempChannel;
-            struct ares_options options;
-            memset(&options, 0, sizeof(options));
-            status = ares_init_options(&tempChannel, &options, 0);
-            assert(status == ARES_SUCCESS);
-
-            char *servers = ares_get_servers_csv(tempChannel);
-            DnsServers dnsServersInTempChannel(servers);
-            if (servers) {
-                ares_free_string(servers);
-            }
-
-            if (dnsServersInChannel != dnsServersInTempChannel) {
-                ares_cancel(channel);
-                status = ares_set_servers_csv(channel, dnsServersInTempChannel.getAsCsv().c_str());
-                assert(status == ARES_SUCCESS);
-                dnsServersInChannel = dnsServersInTempChannel;
-
-                g_logger->info("DNS servers in channel are changed: {}", dnsServersInChannel.getAsCsv());
-            }
-            ares_destroy(tempChannel);
-
-        } else {
-            if (dnsServersInChannel != dnsServersInstalled) {
-                ares_cancel(channel);
-                status = ares_set_servers_csv(channel, dnsServersInstalled.getAsCsv().c_str());
-                if (status != ARES_SUCCESS) {
-                    g_logger->error("Failed to set DNS servers to channel: {}", dnsServersInstalled.getAsCsv());
-                } else {
-                    dnsServersInChannel = dnsServersInstalled;
-                    g_logger->info("DNS servers in channel are changed: {}", dnsServersInChannel.getAsCsv());
-                }
-            }
-        }
+        // the channel already uses the servers read at its creation, so there is nothing to reload in the first iteration
+        updateDnsServers(channel, dnsServersInstalled, isReloadSystemDnsServers_.exchange(false), dnsServersInChannel);
 
         // start new requests from the queue
         while (!localQueue.empty()) {
@@ -180,29 +177,183 @@ void DnsResolver_cares::run()
             arg->qi = qi;
             arg->qi.startTime = std::chrono::steady_clock::now();
 
-            ares_gethostbyname(channel, arg->qi.hostname.c_str(), AF_INET, caresCallback, arg);
+            // ares_getaddrinfo unlike ares_gethostbyname returns the TTL of the records for the DNS cache
+            ares_addrinfo_hints hints;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = qi.isDualStack ? AF_UNSPEC : AF_INET;
+            hints.ai_flags = ARES_AI_NOSORT;
+            ares_getaddrinfo(channel, arg->qi.hostname.c_str(), NULL, &hints, caresCallback, arg);
             localQueue.pop();
         }
 
-        // process
-        fd_set readers, writers;
-        FD_ZERO(&readers);
-        FD_ZERO(&writers);
-        int nfds = ares_fds(channel, &readers, &writers);
-        if (nfds != 0) {
-            // do not block for longer than kTimeoutMs interval
-            timeval tvp;
-            tvp.tv_sec = 0;
-            tvp.tv_usec = kTimeoutMs * 1000;
-            select(nfds, &readers, &writers, NULL, &tvp);
-            ares_process(channel, &readers, &writers);
-        }
+        waitForEvents(channel);
     }
 
     ares_destroy(channel);
 }
 
-void DnsResolver_cares::caresCallback(void *arg, int status, int timeouts, hostent *host)
+void DnsResolver_cares::updateDnsServers(ares_channel channel, const DnsServers &dnsServersInstalled, bool isReloadSystemDnsServers, DnsServers &dnsServersInChannel)
+{
+    // We must to cancel current requests before installing new DNS-servers
+    if (dnsServersInstalled.isEmpty()) {    // Use default system DNS-servers
+        if (!isReloadSystemDnsServers) {
+            return;
+        }
+
+        // get the current system DNS-server through a temporary channel
+        ares_channel tempChannel;
+        struct ares_options options;
+        memset(&options, 0, sizeof(options));
+        [[maybe_unused]] int status = ares_init_options(&tempChannel, &options, 0);
+        assert(status == ARES_SUCCESS);
+
+        char *servers = ares_get_servers_csv(tempChannel);
+        DnsServers dnsServersInTempChannel(servers);
+        if (servers) {
+            ares_free_string(servers);
+        }
+
+        if (dnsServersInChannel != dnsServersInTempChannel) {
+            ares_cancel(channel);
+            status = ares_set_servers_csv(channel, dnsServersInTempChannel.getAsCsv().c_str());
+            assert(status == ARES_SUCCESS);
+            dnsServersInChannel = dnsServersInTempChannel;
+
+            g_logger->info("DNS servers in channel are changed: {}", dnsServersInChannel.getAsCsv());
+        }
+        ares_destroy(tempChannel);
+
+    } else {
+        if (dnsServersInChannel != dnsServersInstalled) {
+            ares_cancel(channel);
+            int status = ares_set_servers_csv(channel, dnsServersInstalled.getAsCsv().c_str());
+            if (status != ARES_SUCCESS) {
+                g_logger->error("Failed to set DNS servers to channel: {}", dnsServersInstalled.getAsCsv());
+            } else {
+                dnsServersInChannel = dnsServersInstalled;
+                g_logger->info("DNS servers in channel are changed: {}", dnsServersInChannel.getAsCsv());
+            }
+        }
+    }
+}
+
+void DnsResolver_cares::waitForEvents(ares_channel channel)
+{
+    std::vector<pollfd> fds;
+    fds.reserve(sockets_.size() + 1);
+    for (const auto &it : sockets_) {
+        pollfd pfd;
+        pfd.fd = it.first;
+        pfd.events = it.second;
+        pfd.revents = 0;
+        fds.push_back(pfd);
+    }
+    if (wakeupSocket_ != ARES_SOCKET_BAD) {
+        pollfd pfd;
+        pfd.fd = wakeupSocket_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        fds.push_back(pfd);
+    }
+
+    // sleep until the next c-ares timeout, but not longer than kTimeoutMs
+    timeval maxtv;
+    maxtv.tv_sec = kTimeoutMs / 1000;
+    maxtv.tv_usec = (kTimeoutMs % 1000) * 1000;
+    timeval tv;
+    timeval *tvp = ares_timeout(channel, &maxtv, &tv);
+    int timeoutMs = (int)(tvp->tv_sec * 1000 + (tvp->tv_usec + 999) / 1000);
+    if (wakeupSocket_ == ARES_SOCKET_BAD) {
+        // without the wakeup socket a new request can only be noticed after the poll
+        timeoutMs = std::min(timeoutMs, 100);
+    }
+
+    int ret = poll(fds.data(), (unsigned long)fds.size(), timeoutMs);
+    if (ret > 0) {
+        for (const auto &pfd : fds) {
+            if (pfd.revents == 0) {
+                continue;
+            }
+            if (pfd.fd == wakeupSocket_) {
+                // drain the wakeup datagrams
+                char buf[64];
+                while (recv(wakeupSocket_, buf, sizeof(buf), 0) > 0) {}
+                continue;
+            }
+            const bool isReadable = pfd.revents & (POLLIN | POLLERR | POLLHUP);
+            const bool isWritable = pfd.revents & (POLLOUT | POLLERR | POLLHUP);
+            ares_process_fd(channel, isReadable ? pfd.fd : ARES_SOCKET_BAD, isWritable ? pfd.fd : ARES_SOCKET_BAD);
+        }
+    }
+    // handle the timeouts of the queries
+    ares_process_fd(channel, ARES_SOCKET_BAD, ARES_SOCKET_BAD);
+}
+
+void DnsResolver_cares::socketStateCallback(void *data, ares_socket_t socket, int readable, int writable)
+{
+    DnsResolver_cares *this_ = (DnsResolver_cares *)data;
+    if (!readable && !writable) {
+        this_->sockets_.erase(socket);
+    } else {
+        this_->sockets_[socket] = (readable ? POLLIN : 0) | (writable ? POLLOUT : 0);
+    }
+}
+
+bool DnsResolver_cares::createWakeupSocket()
+{
+    ares_socket_t s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == ARES_SOCKET_BAD) {
+        return false;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    bool isOk = bind(s, (sockaddr *)&addr, sizeof(addr)) == 0 &&
+                getsockname(s, (sockaddr *)&addr, &addrLen) == 0 &&
+                connect(s, (sockaddr *)&addr, sizeof(addr)) == 0;
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    isOk = isOk && ioctlsocket(s, FIONBIO, &nonBlocking) == 0;
+#else
+    isOk = isOk && fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK) == 0;
+    fcntl(s, F_SETFD, FD_CLOEXEC);
+#endif
+    if (!isOk) {
+#ifdef _WIN32
+        closesocket(s);
+#else
+        close(s);
+#endif
+        return false;
+    }
+    wakeupSocket_ = s;
+    return true;
+}
+
+void DnsResolver_cares::closeWakeupSocket()
+{
+    if (wakeupSocket_ != ARES_SOCKET_BAD) {
+#ifdef _WIN32
+        closesocket(wakeupSocket_);
+#else
+        close(wakeupSocket_);
+#endif
+        wakeupSocket_ = ARES_SOCKET_BAD;
+    }
+}
+
+void DnsResolver_cares::wakeup()
+{
+    if (wakeupSocket_ != ARES_SOCKET_BAD) {
+        const char byte = 0;
+        send(wakeupSocket_, &byte, 1, 0);
+    }
+}
+
+void DnsResolver_cares::caresCallback(void *arg, int status, int timeouts, ares_addrinfo *aresResult)
 {
     ArgToCaresCallback *pars = (ArgToCaresCallback *)arg;
 
@@ -217,13 +368,54 @@ void DnsResolver_cares::caresCallback(void *arg, int status, int timeouts, hoste
     }
 
     std::shared_ptr<DnsRequestResult> result = std::make_shared<DnsRequestResult>();
-    if (status == ARES_SUCCESS) {
-        for (char **p = host->h_addr_list; *p; p++) {
+    if (status == ARES_SUCCESS && aresResult) {
+        std::vector<std::string> ipv4, ipv6;
+        bool isFirst = true;
+        for (ares_addrinfo_node *node = aresResult->nodes; node; node = node->ai_next) {
             char addr_buf[46] = "??";
-            ares_inet_ntop(host->h_addrtype, *p, addr_buf, sizeof(addr_buf));
-            result->ips_.push_back(addr_buf);
+            std::vector<std::string> *ips;
+            if (node->ai_family == AF_INET) {
+                ares_inet_ntop(AF_INET, &((sockaddr_in *)node->ai_addr)->sin_addr, addr_buf, sizeof(addr_buf));
+                ips = &ipv4;
+            } else if (node->ai_family == AF_INET6) {
+                ares_inet_ntop(AF_INET6, &((sockaddr_in6 *)node->ai_addr)->sin6_addr, addr_buf, sizeof(addr_buf));
+                ips = &ipv6;
+            } else {
+                continue;
+            }
+            if (std::find(ips->begin(), ips->end(), addr_buf) != ips->end()) {
+                continue;
+            }
+            ips->push_back(addr_buf);
+
+            const std::uint32_t ttl = node->ai_ttl > 0 ? (std::uint32_t)node->ai_ttl : 0;
+            result->ttl_ = isFirst ? ttl : std::min(result->ttl_, ttl);
+            isFirst = false;
+        }
+
+        // interleave the families, so a connection racing them (happy eyeballs) gets the other family right after the first address.
+        // IPv4 goes first, IPv6 is often filtered by the firewall or broken on the network.
+        for (size_t i = 0; i < std::max(ipv4.size(), ipv6.size()); ++i) {
+            if (i < ipv4.size()) {
+                result->ips_.push_back(ipv4[i]);
+            }
+            if (i < ipv6.size()) {
+                result->ips_.push_back(ipv6[i]);
+            }
+        }
+        if (result->ips_.empty()) {
+            status = ARES_ENODATA;
         }
     }
+    if (status == ARES_ENOTFOUND || status == ARES_ENODATA) {
+        result->ttl_ = kNegativeTtlSec;
+    } else if (status == ARES_ECONNREFUSED || status == ARES_ETIMEOUT) {
+        // the system DNS-servers may have changed without a notification
+        pars->this_->isReloadSystemDnsServers_ = true;
+    }
+    if (aresResult) {
+        ares_freeaddrinfo(aresResult);
+    }
 
     result->elapsedMs_ = (unsigned int)utils::since(pars->qi.startTime).count();
     result->error_ = std::make_shared<RequestError>(status, RequestErrorType::kCares);
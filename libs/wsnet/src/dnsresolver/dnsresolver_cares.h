@@ -4,6 +4,7 @@
 #include <atomic>
 #include <mutex>
 #include <queue>
+#include <map>
 #include <set>
 #include <condition_variable>
 
@@ -15,6 +16,8 @@
 namespace wsnet {
 
 // DnsResolver implementation based on the cares library
+// The resolver thread sleeps until a socket of the channel is ready, the next c-ares timeout or a new request,
+// the sockets are tracked through the c-ares socket state callback.
 // Thread safe
 class DnsResolver_cares : public WSNetDnsResolver
 {
@@ -30,12 +33,28 @@ public:
     std::shared_ptr<WSNetCancelableCallback> lookup(const std::string &hostname, std::uint64_t userDataId, WSNetDnsResolverCallback callback) override;
     std::shared_ptr<WSNetDnsRequestResult> lookupBlocked(const std::string &hostname) override;
 
+    // Resolves both A and AAAA records, the result contains IPv4 and IPv6 addresses interleaved (IPv4 first)
+    std::shared_ptr<WSNetCancelableCallback> lookupDualStack(const std::string &hostname, std::uint64_t userDataId, WSNetDnsResolverCallback callback);
+
+    // The system DNS-servers are read again before the next request, should be called when the network changes
+    void reloadSystemDnsServers();
+
 private:
     void run();
-    static void caresCallback(void *arg, int status, int timeouts, hostent *host);
+    void updateDnsServers(ares_channel channel, const DnsServers &dnsServersInstalled, bool isReloadSystemDnsServers, DnsServers &dnsServersInChannel);
+    void waitForEvents(ares_channel channel);
+    std::shared_ptr<WSNetCancelableCallback> addToQueue(const std::string &hostname, std::uint64_t userDataId, WSNetDnsResolverCallback callback, bool isDualStack);
+
+    bool createWakeupSocket();
+    void closeWakeupSocket();
+    void wakeup();
+
+    static void caresCallback(void *arg, int status, int timeouts, ares_addrinfo *aresResult);
+    static void socketStateCallback(void *data, ares_socket_t socket, int readable, int writable);
 
     static constexpr int kTimeoutMs = 2000;  // default value in c-ares, let's leave it as it is
     static constexpr int kTries = 2; // the number of tries the resolver will try contacting each name server before giving up.
+    static constexpr std::uint32_t kNegativeTtlSec = 10; // c-ares does not return the SOA record of a negative answer, so its TTL is unknown
 
     struct QueueItem
     {
@@ -43,6 +62,7 @@ private:
         std::string hostname;
         std::chrono::time_point<std::chrono::steady_clock> startTime;
         std::uint64_t userDataId;
+        bool isDualStack;
         std::shared_ptr<CancelableCallback<WSNetDnsResolverCallback>> callback;
     };
 
@@ -58,10 +78,12 @@ private:
         std::vector<std::string> ips() const override { return ips_; }
         std::uint32_t elapsedMs() const override { return elapsedMs_; }
         std::shared_ptr<WSNetRequestError> error() const  override { return error_; }
+        std::uint32_t ttl() const override { return ttl_; }
 
         std::vector<std::string> ips_;
         unsigned int elapsedMs_;
         std::shared_ptr<WSNetRequestError> error_;
+        std::uint32_t ttl_ = 0;
     };
     AresLibraryInit aresLibraryInit_;
     std::thread thread_;
@@ -72,6 +94,12 @@ private:
     std::set<std::uint64_t> activeRequests_;
     DnsServers dnsServers_;
     std::uint64_t curRequestId_;
+    std::atomic_bool isReloadSystemDnsServers_ = false;
+
+    // only used in the resolver thread
+    std::map<ares_socket_t, short> sockets_;    // socket -> poll events
+    // a loopback UDP socket connected to itself, a datagram sent to it interrupts the waiting for the c-ares sockets
+    ares_socket_t wakeupSocket_ = ARES_SOCKET_BAD;
 };
 
 } // namespace wsnet
@@ -22,21 +22,24 @@ CertManager::CertManager()
     parseCertsBundle(std::string(fdCert.begin(), fdCert.end()));
 
     g_logger->debug("CertManager number of certificates : {}", certs_.size());
-}
 
-CertManager::~CertManager()
-{
+    // the store takes its own references to the certificates
+    store_ = X509_STORE_new();
+    assert(store_);
+    for (const auto &it : certs_) {
+        X509_STORE_add_cert(store_, it.cert);
+    }
     cleanCerts();
 }
 
-int CertManager::count()
+CertManager::~CertManager()
 {
-    return (int)certs_.size();
+    X509_STORE_free(store_);
 }
 
-X509 *CertManager::getCert(int ind)
+X509_STORE *CertManager::store() const
 {
-    return certs_[ind].cert;
+    return store_;
 }
 
 void CertManager::parseCertsBundle(const std::string &arr)
@@ -6,14 +6,14 @@
 
 namespace wsnet {
 
+// Builds the certificate store once, it is shared by all the SSL contexts of curl (read only, reference counted).
 class CertManager
 {
 public:
     CertManager();
     ~CertManager();
 
-    int count();
-    X509 *getCert(int ind);
+    X509_STORE *store() const;
 
 private:
     struct CertDescr
@@ -23,6 +23,7 @@ private:
     };
 
     std::vector<CertDescr> certs_;
+    X509_STORE *store_ = nullptr;
 
     void parseCertsBundle(const std::string &arr);
     CertDescr loadCert(const std::string_view &data);
@@ -1,10 +1,10 @@
 #include "curlnetworkmanager.h"
-#include <regex>
 #include "utils/wsnet_logger.h"
 #include "utils/utils.h"
 #include "utils/crypto_utils.h"
 #include "utils/requesterror.h"
 #include "settings.h"
+#include "filedatasink.h"
 
 #include <openssl/opensslv.h>
 #include <openssl/ssl.h>
@@ -12,12 +12,13 @@
 #ifdef _WIN32
 #else
     #include <unistd.h>
+    #include <sys/socket.h>
 #endif
 namespace wsnet {
 
 CurlNetworkManager::CurlNetworkManager(CurlFinishedCallback finishedCallback, CurlProgressCallback progressCallback, CurlReadyDataCallback readyDataCallback) :
     finishedCallback_(finishedCallback), progressCallback_(progressCallback), readyDataCallback_(readyDataCallback),
-    finish_(false), multiHandle_(nullptr)
+    finish_(false), isResetConnections_(false), multiHandle_(nullptr), shareHandle_(nullptr)
 {
 }
 
@@ -26,7 +27,18 @@ CurlNetworkManager::~CurlNetworkManager()
     g_logger->info("CurlNetworkManager destructor started");
     finish_ = true;
     condition_.notify_all();
-    thread_.join();
+    if (thread_.joinable())
+        thread_.join();
+
+    // all the easy handles are freed at this point
+    if (multiHandle_)
+        curl_multi_cleanup(multiHandle_);
+    for (auto handle : freeEasyHandles_)
+        curl_easy_cleanup(handle);
+    if (shareHandle_)
+        curl_share_cleanup(shareHandle_);
+    for (auto handle : oldShareHandles_)
+        curl_share_cleanup(handle);
 
     if (isCurlGlobalInitialized_)
         curl_global_cleanup();
@@ -50,6 +62,10 @@ bool CurlNetworkManager::init()
         isCurlGlobalInitialized_ = true;
 
         multiHandle_ = curl_multi_init();
+        curl_multi_setopt(multiHandle_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+        shareHandle_ = createShareHandle();
+
         thread_ = std::thread(std::bind(&CurlNetworkManager::run, this));
     }
     return true;
@@ -60,17 +76,26 @@ void CurlNetworkManager::executeRequest(std::uint64_t requestId, const std::shar
     RequestInfo *requestInfo = new RequestInfo();
     requestInfo->id = requestId;
     requestInfo->curlNetworkManager = this;
-    requestInfo->curlEasyHandle = curl_easy_init();
+    requestInfo->curlEasyHandle = acquireEasyHandle();
     requestInfo->isDebugLogCurlError = request->isDebugLogCurlError();
+    requestInfo->isFreshConnect = request->isEnableFreshConnect();
+    if (!request->outputFilePath().empty()) {
+        requestInfo->isWriteToSink = true;
+        auto sink = std::make_unique<FileDataSink>(request->outputFilePath());
+        if (sink->isOpen())
+            requestInfo->sink = std::move(sink);
+        else
+            g_logger->error("CurlNetworkManager cannot open the output file");  // the request will fail on the first write
+    }
 
     // Prepare data for debug log privacy
     if (requestInfo->isDebugLogCurlError) {
         requestInfo->domain = utils::topDomain(request->hostname());
-        requestInfo->domainMd5 = crypto_utils::md5(requestInfo->domain);
-        requestInfo->ips = ips;
-        for (const auto &it : requestInfo->ips) {
-            requestInfo->ipsMd5.push_back(crypto_utils::md5(it));
+        requestInfo->redactor.addPattern(requestInfo->domain, crypto_utils::md5(requestInfo->domain));
+        for (const auto &it : ips) {
+            requestInfo->redactor.addPattern(it, crypto_utils::md5(it));
         }
+        requestInfo->redactor.build();
     }
 
     if (requestInfo->curlEasyHandle)  {
@@ -109,6 +134,14 @@ void CurlNetworkManager::setWhitelistSocketsCallback(std::shared_ptr<CancelableC
     whitelistSocketsCallback_ = callback;
 }
 
+void CurlNetworkManager::resetConnections()
+{
+    std::lock_guard locker(mutex_);
+    isResetConnections_ = true;
+    condition_.notify_all();
+    curl_multi_wakeup(multiHandle_);
+}
+
 void CurlNetworkManager::run()
 {
     // To reduce the frequency of logs, only once per domain unless errors happen
@@ -118,13 +151,20 @@ void CurlNetworkManager::run()
 
         {
             std::unique_lock<std::mutex> locker(mutex_);
-            while (activeRequests_.empty() && !finish_)
+            while (activeRequests_.empty() && !finish_ && !isResetConnections_)
                 condition_.wait(locker);
         }
 
         if (finish_)
             break;
 
+        if (isResetConnections_.exchange(false)) {
+            closeIdleConnections();
+            resetSslSessions();
+        }
+        if (!oldShareHandles_.empty())
+            freeOldShareHandles();
+
         {
             std::lock_guard locker(mutex_);
             // add curl handles for requests which have not been added
@@ -165,12 +205,24 @@ void CurlNetworkManager::run()
                 curl_off_t totalTime;
                 curl_easy_getinfo(curlEasyHandle, CURLINFO_TOTAL_TIME_T, &totalTime);
 
-                curl_multi_remove_handle(multiHandle_, curlEasyHandle);
-
                 CURLcode result = curlMsg->data.result;
 
+                // remember the connection left open in the pool
+                curl_socket_t socket;
+                if (result == CURLE_OK && curl_easy_getinfo(curlEasyHandle, CURLINFO_ACTIVESOCKET, &socket) == CURLE_OK && socket != CURL_SOCKET_BAD) {
+                    std::lock_guard locker(mutex_);
+                    auto it = activeRequests_.find(*pointerId);
+                    if (it != activeRequests_.end() && !it->second->isFreshConnect) {
+                        std::lock_guard lockerSockets(mutexForWhiteListSockets_);
+                        pooledSockets_.insert(socket);
+                    }
+                }
+
+                curl_multi_remove_handle(multiHandle_, curlEasyHandle);
+
                 std::uint64_t id;
                 long osErrno;
+                std::shared_ptr<DataSegment> lastSegment;
 
                 //remove request from activeRequests
                 {
@@ -180,6 +232,12 @@ void CurlNetworkManager::run()
                     assert(it != activeRequests_.end());
                     assert(it->second->curlEasyHandle == curlEasyHandle);
 
+                    lastSegment = std::move(it->second->segment);
+                    if (it->second->sink && !it->second->sink->close() && result == CURLE_OK) {
+                        g_logger->error("CurlNetworkManager cannot write the output file");
+                        result = CURLE_WRITE_ERROR;
+                    }
+
                     if (result != CURLE_OK) {
                         g_logger->debug("Curl request error: {}", curl_easy_strerror(result));
                         loggedSuccessDomains.erase(it->second->domain);
@@ -209,6 +267,9 @@ void CurlNetworkManager::run()
                     activeRequests_.erase(id);
                 }
 
+                if (lastSegment)
+                    readyDataCallback_(id, lastSegment);
+
                 if (result != CURLE_OK) {
                     finishedCallback_(id, std::make_shared<RequestError>(result, RequestErrorType::kCurl, osErrno));
                 } else {
@@ -223,26 +284,144 @@ void CurlNetworkManager::run()
         curl_multi_poll(multiHandle_, NULL, 0, 1000, &numfds);
     }
 
-    for (auto it = activeRequests_.begin(); it != activeRequests_.end(); ++it)
+    for (auto it = activeRequests_.begin(); it != activeRequests_.end(); ++it) {
+        if (it->second->isAddedToMultiHandle)
+            curl_multi_remove_handle(multiHandle_, it->second->curlEasyHandle);
         delete it->second;
+    }
     activeRequests_.clear();
 }
 
+void CurlNetworkManager::closeIdleConnections()
+{
+    // the connections of the running requests are left alone
+    std::set<curl_socket_t> activeSockets;
+    {
+        std::lock_guard locker(mutex_);
+        for (const auto &it : activeRequests_) {
+            curl_socket_t socket;
+            if (it.second->isAddedToMultiHandle && curl_easy_getinfo(it.second->curlEasyHandle, CURLINFO_ACTIVESOCKET, &socket) == CURLE_OK && socket != CURL_SOCKET_BAD)
+                activeSockets.insert(socket);
+        }
+    }
+
+    // Curl closes the connection itself when it finds it dead on the next reuse attempt,
+    // so it is enough to shutdown the socket. The socket is removed from pooledSockets_ in curlCloseSocketCallback.
+    std::lock_guard locker(mutexForWhiteListSockets_);
+    int count = 0;
+    for (auto socket : pooledSockets_) {
+        if (activeSockets.find(socket) == activeSockets.end()) {
+#ifdef _WIN32
+            shutdown(socket, SD_BOTH);
+#else
+            shutdown(socket, SHUT_RDWR);
+#endif
+            count++;
+        }
+    }
+    g_logger->debug("CurlNetworkManager closed {} idle connections", count);
+}
+
+CURL *CurlNetworkManager::acquireEasyHandle()
+{
+    {
+        std::lock_guard locker(easyHandlesMutex_);
+        if (!freeEasyHandles_.empty()) {
+            CURL *handle = freeEasyHandles_.back();
+            freeEasyHandles_.pop_back();
+            return handle;
+        }
+    }
+    return curl_easy_init();
+}
+
+void CurlNetworkManager::resetSslSessions()
+{
+    // The TLS sessions negotiated on the old network are not resumed by the new requests.
+    // The running requests keep the old share, it is freed once they are finished.
+    std::lock_guard locker(mutex_);
+    oldShareHandles_.push_back(shareHandle_);
+    shareHandle_ = createShareHandle();
+}
+
+void CurlNetworkManager::freeOldShareHandles()
+{
+    // curl_share_cleanup fails while an easy handle still uses the share
+    for (auto it = oldShareHandles_.begin(); it != oldShareHandles_.end(); /*++it*/) {
+        if (curl_share_cleanup(*it) == CURLSHE_OK)
+            it = oldShareHandles_.erase(it);
+        else
+            ++it;
+    }
+}
+
+CURLSH *CurlNetworkManager::createShareHandle()
+{
+    CURLSH *handle = curl_share_init();
+    curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, shareLockCallback);
+    curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, shareUnlockCallback);
+    curl_share_setopt(handle, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    return handle;
+}
+
+void CurlNetworkManager::releaseEasyHandle(CURL *handle)
+{
+    // a free handle must not keep an old share in use, setupOptions sets the current one
+    curl_easy_setopt(handle, CURLOPT_SHARE, nullptr);
+    // curl_easy_reset keeps the caches of the handle, but resets all the options
+    curl_easy_reset(handle);
+    std::lock_guard locker(easyHandlesMutex_);
+    if (freeEasyHandles_.size() < kMaxFreeEasyHandles)
+        freeEasyHandles_.push_back(handle);
+    else
+        curl_easy_cleanup(handle);
+}
+
 CURLcode CurlNetworkManager::sslctx_function(CURL *curl, void *sslctx, void *parm)
 {
-    X509_STORE *store = SSL_CTX_get_cert_store((SSL_CTX *)sslctx);
+    // replaces the empty default store, only the reference count is incremented
     CertManager *certManager = static_cast<CertManager *>(parm);
-    for (int i = 0; i < certManager->count(); ++i)
-        X509_STORE_add_cert(store, certManager->getCert(i));
-
+    SSL_CTX_set1_cert_store((SSL_CTX *)sslctx, certManager->store());
     return CURLE_OK;
 }
 
+void CurlNetworkManager::shareLockCallback(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    (void)handle;
+    (void)access;
+    CurlNetworkManager *this_ = static_cast<CurlNetworkManager *>(userptr);
+    this_->shareMutexes_[data].lock();
+}
+
+void CurlNetworkManager::shareUnlockCallback(CURL *handle, curl_lock_data data, void *userptr)
+{
+    (void)handle;
+    CurlNetworkManager *this_ = static_cast<CurlNetworkManager *>(userptr);
+    this_->shareMutexes_[data].unlock();
+}
+
 size_t CurlNetworkManager::writeDataCallback(void *ptr, size_t size, size_t count, void *ri)
 {
     RequestInfo *requestInfo = static_cast<RequestInfo *>(ri);
-    std::string data((char *)ptr, (char *)ptr + size * count);
-    requestInfo->curlNetworkManager->readyDataCallback_(requestInfo->id, data);
+    const char *data = (const char *)ptr;
+    size_t left = size * count;
+
+    if (requestInfo->isWriteToSink) {
+        // returning less than requested aborts the transfer with CURLE_WRITE_ERROR
+        return (requestInfo->sink && requestInfo->sink->write(data, left)) ? left : 0;
+    }
+
+    // accumulate the small curl chunks in a segment, a full segment is passed on without copying
+    while (left > 0) {
+        if (!requestInfo->segment)
+            requestInfo->segment = requestInfo->curlNetworkManager->segmentPool_.acquire();
+        size_t n = requestInfo->segment->append(data, left);
+        data += n;
+        left -= n;
+        if (requestInfo->segment->isFull())
+            requestInfo->curlNetworkManager->readyDataCallback_(requestInfo->id, std::move(requestInfo->segment));
+    }
     return size*count;
 }
 
@@ -279,6 +458,7 @@ int CurlNetworkManager::curlCloseSocketCallback(void *clientp, curl_socket_t cur
     close(curlfd);
 #endif
     std::lock_guard locker(this_->mutexForWhiteListSockets_);
+    this_->pooledSockets_.erase(curlfd);
     // whitelist the deleted socket descriptor
     if (this_->whitelistSockets_.find(curlfd) != this_->whitelistSockets_.end()) {
         this_->whitelistSockets_.erase(curlfd);
@@ -295,18 +475,10 @@ int CurlNetworkManager::curlTrace(CURL *handle, curl_infotype type, char *data,
     RequestInfo *requestInfo = static_cast<RequestInfo *>(clientp);
 
     if (type == CURLINFO_TEXT) {
-        // replace all domains in the string with their md5 for privacy.
-        std::string src = std::string(data, size);
-        std::regex reg(requestInfo->domain);
-        std::string res = regex_replace(src, reg, requestInfo->domainMd5);
-
-        // replace all IPv4 addresses in the string with their md5 for privacy.
-        for (size_t i = 0; i < requestInfo->ips.size(); ++i) {
-            std::regex reg(requestInfo->ips[i]);
-            res = regex_replace(res, reg, requestInfo->ipsMd5[i]);
-        }
-
-        requestInfo->debugLogs.push_back(res);
+        // replace the domain and the IP addresses in the string with their md5 for privacy.
+        if (requestInfo->debugLogs.size() >= kMaxDebugLogs)
+            requestInfo->debugLogs.pop_front();
+        requestInfo->debugLogs.push_back(requestInfo->redactor.redact(data, size));
     }
     return 0;
 }
@@ -317,6 +489,7 @@ bool CurlNetworkManager::setupOptions(RequestInfo *requestInfo, const std::share
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_WRITEDATA, requestInfo) != CURLE_OK) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_ACCEPT_ENCODING, "") != CURLE_OK) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_URL, request->url().c_str()) != CURLE_OK) return false;
+    if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_SHARE, shareHandle_) != CURLE_OK) return false;
 
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_SOCKOPTFUNCTION, curlSocketCallback) != CURLE_OK) return false;
     if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_SOCKOPTDATA, this) != CURLE_OK) return false;
@@ -329,7 +502,12 @@ bool CurlNetworkManager::setupOptions(RequestInfo *requestInfo, const std::share
         if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_FRESH_CONNECT, 1L) != CURLE_OK) return false;
         // make connection get closed at once after use
         if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_FORBID_REUSE, 1L) != CURLE_OK) return false;
+    } else {
+        // wait for a connection being established to the same host to multiplex over it instead of opening a new one
+        if (curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_PIPEWAIT, 1L) != CURLE_OK) return false;
     }
+    // falls back to HTTP/1.1 if the server does not support HTTP/2, the error is ignored for the curl builds without HTTP/2
+    curl_easy_setopt(requestInfo->curlEasyHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
 
     // timeout for the connect phase, this timeout only limits the connection phase, it has no impact once libcurl has connected
     // I noticed that this time curl distributes equally between all IP addresses of the domain,
@@ -412,7 +590,13 @@ bool CurlNetworkManager::setupResolveHosts(RequestInfo *requestInfo, const std::
         if (port == 0) //  use 443 by default
             port = 443;
 
-        std::string strResolve = request->hostname() + ":" + std::to_string(port) + ":" + utils::join(ips, ",");
+        // IPv6 addresses must be in brackets, curl races the families itself (happy eyeballs)
+        std::vector<std::string> addresses;
+        addresses.reserve(ips.size());
+        for (const auto &ip : ips) {
+            addresses.push_back(ip.find(':') != std::string::npos ? "[" + ip + "]" : ip);
+        }
+        std::string strResolve = request->hostname() + ":" + std::to_string(port) + ":" + utils::join(addresses, ",");
         struct curl_slist *hosts = curl_slist_append(NULL, strResolve.c_str());
         if (hosts == NULL) return false;
         requestInfo->curlLists.push_back(hosts);
@@ -4,21 +4,29 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <deque>
 #include <map>
+#include <set>
 #include <condition_variable>
 #include "WSNetHttpRequest.h"
 #include "WSNetHttpNetworkManager.h"
 #include "WSNetRequestError.h"
 #include "certmanager.h"
+#include "datasegment.h"
+#include "idatasink.h"
 #include "utils/cancelablecallback.h"
+#include "utils/stringredactor.h"
 
 namespace wsnet {
 
 typedef std::function<void(std::uint64_t requestId, std::shared_ptr<WSNetRequestError> error)> CurlFinishedCallback;
 typedef std::function<void(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal)> CurlProgressCallback;
-typedef std::function<void(std::uint64_t requestId, const std::string &data)> CurlReadyDataCallback;
+// the segment is full, except the last one of the request
+typedef std::function<void(std::uint64_t requestId, std::shared_ptr<DataSegment> segment)> CurlReadyDataCallback;
 
 // Implementing queries with curl library.
+// The requests without the fresh connect option reuse the connections (HTTP/2 multiplexed when the server supports it),
+// the easy handles are pooled too.
 class CurlNetworkManager
 {
 public:
@@ -35,8 +43,20 @@ public:
 
     void setWhitelistSocketsCallback(std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > callback);
 
+    // Drops the idle connections kept for reuse and the cached TLS sessions, they may go over the old route after the VPN state changes
+    void resetConnections();
+
 private:
+    static constexpr size_t kMaxFreeEasyHandles = 8;
+    static constexpr size_t kMaxDebugLogs = 100;    // the last lines of the curl trace kept per request
+
     void run();
+    void closeIdleConnections();
+    void resetSslSessions();
+    void freeOldShareHandles();
+    CURLSH *createShareHandle();
+    CURL *acquireEasyHandle();
+    void releaseEasyHandle(CURL *handle);
 
 private:
     bool isCurlGlobalInitialized_ = false;
@@ -45,11 +65,13 @@ private:
     CurlReadyDataCallback readyDataCallback_;
 
     CertManager certManager_;
+    DataSegmentPool segmentPool_;
 
     std::mutex mutex_;
     std::condition_variable condition_;
     std::thread thread_;
     std::atomic<bool> finish_;
+    std::atomic<bool> isResetConnections_;
 
     struct ProxySettings {
         std::string address;
@@ -66,11 +88,13 @@ private:
         bool isAddedToMultiHandle = false;
         bool isNeedRemoveFromMultiHandle = false;
         bool isDebugLogCurlError = false;
+        bool isFreshConnect = true;
+        bool isWriteToSink = false;
         std::string domain;
-        std::string domainMd5;
-        std::vector<std::string> ips;
-        std::vector<std::string> ipsMd5;
-        std::vector<std::string> debugLogs;
+        StringRedactor redactor;        // replaces the domain and the IPs with their md5 in the debug logs
+        std::deque<std::string> debugLogs;
+        std::shared_ptr<DataSegment> segment;   // the segment being filled
+        std::unique_ptr<IDataSink> sink;
 
         // free all curl handles and data
         ~RequestInfo() {
@@ -79,7 +103,7 @@ private:
                 std::uint64_t *id;
                 if (curl_easy_getinfo(curlEasyHandle, CURLINFO_PRIVATE, &id) == CURLE_OK && id != nullptr)
                     delete id;
-                curl_easy_cleanup(curlEasyHandle);
+                curlNetworkManager->releaseEasyHandle(curlEasyHandle);
             }
             for (struct curl_slist *list : curlLists)
                 curl_slist_free_all(list);
@@ -89,11 +113,22 @@ private:
     CURLM *multiHandle_;
     std::map<std::uint64_t, RequestInfo *> activeRequests_;
 
+    // TLS sessions are shared between the requests, so a new connection to the same host resumes the session
+    CURLSH *shareHandle_;
+    std::vector<CURLSH *> oldShareHandles_;     // replaced by resetSslSessions(), used only by the curl thread
+    std::mutex shareMutexes_[CURL_LOCK_DATA_LAST];
+
+    std::mutex easyHandlesMutex_;
+    std::vector<CURL *> freeEasyHandles_;
+
     std::mutex mutexForWhiteListSockets_; // this socket protects whitelistSocketsCallback_ variable
     std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > whitelistSocketsCallback_;
     std::set<int> whitelistSockets_;
+    std::set<curl_socket_t> pooledSockets_;   // the sockets of the connections left open for reuse, also protected by mutexForWhiteListSockets_
 
     static CURLcode sslctx_function(CURL *curl, void *sslctx, void *parm);
+    static void shareLockCallback(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+    static void shareUnlockCallback(CURL *handle, curl_lock_data data, void *userptr);
     static size_t writeDataCallback(void *ptr, size_t size, size_t count, void *ri);
     static int progressCallback(void *ri,   curl_off_t dltotal,   curl_off_t dlnow,   curl_off_t ultotal,   curl_off_t ulnow);
     static int curlSocketCallback(void *clientp, curl_socket_t curlfd, curlsocktype purpose);
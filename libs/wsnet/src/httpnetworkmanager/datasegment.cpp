@@ -0,0 +1,45 @@
+#include "datasegment.h"
+#include <algorithm>
+#include <cstring>
+
+namespace wsnet {
+
+size_t DataSegment::append(const char *data, size_t size)
+{
+    const size_t n = std::min(size, kCapacity - size_);
+    memcpy(data_.get() + size_, data, n);
+    size_ += n;
+    return n;
+}
+
+DataSegmentPool::DataSegmentPool() : freeList_(std::make_shared<FreeList>())
+{
+}
+
+std::shared_ptr<DataSegment> DataSegmentPool::acquire()
+{
+    std::unique_ptr<DataSegment> segment;
+    {
+        std::lock_guard locker(freeList_->mutex);
+        if (!freeList_->segments.empty()) {
+            segment = std::move(freeList_->segments.back());
+            freeList_->segments.pop_back();
+        }
+    }
+    if (!segment)
+        segment = std::make_unique<DataSegment>();
+
+    std::weak_ptr<FreeList> weakFreeList = freeList_;
+    return std::shared_ptr<DataSegment>(segment.release(), [weakFreeList](DataSegment *segment) {
+        std::unique_ptr<DataSegment> ptr(segment);
+        auto freeList = weakFreeList.lock();
+        if (!freeList)
+            return;
+        ptr->clear();
+        std::lock_guard locker(freeList->mutex);
+        if (freeList->segments.size() < kMaxFreeSegments)
+            freeList->segments.push_back(std::move(ptr));
+    });
+}
+
+} // namespace wsnet
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace wsnet {
+
+// A fixed capacity buffer for a part of the response body.
+// The segments are passed between the threads by std::shared_ptr, the data itself is never copied on the way.
+class DataSegment
+{
+public:
+    static constexpr size_t kCapacity = 64 * 1024;
+
+    DataSegment() : data_(new char[kCapacity]) {}
+
+    const char *data() const { return data_.get(); }
+    size_t size() const { return size_; }
+    bool isFull() const { return size_ == kCapacity; }
+
+    // returns the number of bytes copied, less than size if the segment is full
+    size_t append(const char *data, size_t size);
+    void clear() { size_ = 0; }
+
+private:
+    std::unique_ptr<char[]> data_;
+    size_t size_ = 0;
+};
+
+// The segments go back to the pool when the last reference to them is released (even after the pool is deleted).
+// Thread safe
+class DataSegmentPool
+{
+public:
+    DataSegmentPool();
+
+    std::shared_ptr<DataSegment> acquire();
+
+private:
+    static constexpr size_t kMaxFreeSegments = 32;
+
+    struct FreeList
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<DataSegment>> segments;
+    };
+    std::shared_ptr<FreeList> freeList_;
+};
+
+} // namespace wsnet
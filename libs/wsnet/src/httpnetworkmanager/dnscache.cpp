@@ -7,7 +7,7 @@
 
 namespace wsnet {
 
-DnsCache::DnsCache(WSNetDnsResolver *dnsResolver, DnsCacheCallback callback) :
+DnsCache::DnsCache(DnsResolver_cares *dnsResolver, DnsCacheCallback callback) :
     dnsResolver_(dnsResolver), callback_(callback)
 {
 }
@@ -18,6 +18,10 @@ DnsCache::~DnsCache()
     for (auto &it : activeRequests_) {
         it.second->cancel();
     }
+    for (auto &it : prefetchRequests_) {
+        it.second->cancel();
+    }
+    logStats();
 }
 
 DnsCacheResult DnsCache::resolve(std::uint64_t id, const std::string &hostname, bool bypassCache)
@@ -28,19 +32,52 @@ DnsCacheResult DnsCache::resolve(std::uint64_t id, const std::string &hostname,
     if (!bypassCache) {
         auto it = cache_.find(hostname);
         if (it != cache_.end()) {
-            return DnsCacheResult { id, true, it->second, 0, RequestError::createCaresSuccess() };
+            const auto now = std::chrono::steady_clock::now();
+            if (now < it->second.expireTime) {
+                lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+                if (it->second.error) {
+                    stats_.negativeHits++;
+                    return DnsCacheResult { id, true, std::vector<std::string>(), 0, it->second.error };
+                }
+
+                stats_.hits++;
+                if (now >= it->second.prefetchTime && prefetchRequests_.find(hostname) == prefetchRequests_.end()) {
+                    stats_.prefetches++;
+                    prefetchRequests_[hostname] = dnsResolver_->lookupDualStack(hostname, 0, std::bind(&DnsCache::onPrefetchResolved, this, std::placeholders::_2, std::placeholders::_3));
+                }
+                return DnsCacheResult { id, true, it->second.ips, 0, RequestError::createCaresSuccess() };
+            }
+            removeEntry(it);
         }
+        stats_.misses++;
     }
-    auto asyncRequest = dnsResolver_->lookup(hostname, id, std::bind(&DnsCache::onDnsResolved, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    auto asyncRequest = dnsResolver_->lookupDualStack(hostname, id, std::bind(&DnsCache::onDnsResolved, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
     activeRequests_[id] = asyncRequest;
     return DnsCacheResult { id, false, std::vector<std::string>(), 0, RequestError::createCaresSuccess() };
 }
 
 void DnsCache::clear()
+{
+    // the results of the prefetches started before are no longer valid
+    std::map<std::string, std::shared_ptr<WSNetCancelableCallback> > prefetchRequests;
+    {
+        std::lock_guard locker(mutex_);
+        cache_.clear();
+        lru_.clear();
+        prefetchRequests.swap(prefetchRequests_);
+        g_logger->info("Clear DNS cache");
+        logStats();
+    }
+    // cancel outside the lock, a callback may be waiting for the lock in the resolver thread right now
+    for (auto &it : prefetchRequests) {
+        it.second->cancel();
+    }
+}
+
+DnsCacheStats DnsCache::stats()
 {
     std::lock_guard locker(mutex_);
-    cache_.clear();
-    g_logger->info("Clear DNS cache");
+    return stats_;
 }
 
 void DnsCache::onDnsResolved(std::uint64_t id, const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result)
@@ -61,15 +98,69 @@ void DnsCache::onDnsResolved(std::uint64_t id, const std::string &hostname, std:
         tunnelTestLastLogTime_ = std::chrono::steady_clock::now();
     }
 
+    stats_.missesElapsedMs += result->elapsedMs();
+    updateEntry(hostname, result);
+    callback_(DnsCacheResult { id, false, result->ips(), result->elapsedMs(), result->error() } );
+
+    activeRequests_.erase(it);
+}
+
+void DnsCache::onPrefetchResolved(const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result)
+{
+    std::lock_guard locker(mutex_);
+    if (prefetchRequests_.erase(hostname) == 0) {
+        return;     // the cache has been cleared in the meantime
+    }
+    // keep serving the previous answer until it expires if the refresh fails
     if (result->error()->isSuccess()) {
-        cache_[hostname] = result->ips();
+        updateEntry(hostname, result);
+    }
+}
+
+void DnsCache::updateEntry(const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result)
+{
+    const bool isSuccess = result->error()->isSuccess();
+    if (!isSuccess && result->ttl() == 0) {
+        // a transient failure like a timeout, it's not an answer about the name
+        auto it = cache_.find(hostname);
+        if (it != cache_.end()) {
+            removeEntry(it);
+        }
+        return;
+    }
+
+    auto it = cache_.find(hostname);
+    if (it == cache_.end()) {
+        if (cache_.size() >= kMaxEntries) {
+            removeEntry(cache_.find(lru_.back()));
+            stats_.evictions++;
+        }
+        lru_.push_front(hostname);
+        it = cache_.emplace(hostname, CacheEntry()).first;
+        it->second.lruIt = lru_.begin();
     } else {
-        cache_.erase(hostname);
+        lru_.splice(lru_.begin(), lru_, it->second.lruIt);
     }
-    callback_(DnsCacheResult { id, false, result->ips(), result->elapsedMs(), result->error() } );
 
-    activeRequests_.erase(it);
+    const std::uint32_t ttlSec = isSuccess ? std::clamp(result->ttl(), kMinTtlSec, kMaxTtlSec) : std::min(result->ttl(), kMaxTtlSec);
+    const std::chrono::milliseconds ttl(ttlSec * 1000);
+    CacheEntry &entry = it->second;
+    entry.ips = isSuccess ? result->ips() : std::vector<std::string>();
+    entry.error = isSuccess ? nullptr : result->error();
+    entry.expireTime = std::chrono::steady_clock::now() + ttl;
+    entry.prefetchTime = entry.expireTime - ttl * kPrefetchPercent / 100;
 }
 
-} // namespace wsnet
+void DnsCache::removeEntry(std::unordered_map<std::string, CacheEntry>::iterator it)
+{
+    lru_.erase(it->second.lruIt);
+    cache_.erase(it);
+}
 
+void DnsCache::logStats() const
+{
+    g_logger->info("DNS cache stats: entries: {}, hits: {}, negative hits: {}, misses: {} ({} ms in total), prefetches: {}, evictions: {}",
+                   cache_.size(), stats_.hits, stats_.negativeHits, stats_.misses, stats_.missesElapsedMs, stats_.prefetches, stats_.evictions);
+}
+
+} // namespace wsnet
@@ -1,9 +1,11 @@
 #pragma once
 #include <string>
+#include <list>
 #include <map>
+#include <unordered_map>
 #include <mutex>
 #include <optional>
-#include "WSNetDnsResolver.h"
+#include "dnsresolver/dnsresolver_cares.h"
 
 namespace wsnet {
 
@@ -16,28 +18,67 @@ struct DnsCacheResult
     std::shared_ptr<WSNetRequestError> error;
 };
 
+struct DnsCacheStats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t negativeHits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t prefetches = 0;
+    std::uint64_t evictions = 0;
+    // the total time of the DNS-resolutions the requests waited for, to compare with the number of hits
+    std::uint64_t missesElapsedMs = 0;
+};
+
 typedef std::function<void(const DnsCacheResult &result)> DnsCacheCallback;
 
-// TODO: add TTL support, remove from cache + whitelist ips handler
+// The entries live for the TTL of the records (clamped to [kMinTtlSec, kMaxTtlSec]),
+// the definite negative answers are cached too, for the TTL given by the resolver.
+// A name requested during the last part of its TTL is resolved again in the background, so hot names never expire.
+// The number of entries is bounded, the least recently used ones are evicted.
+// TODO: remove from cache + whitelist ips handler
 class DnsCache final
 {
 public:
-    explicit DnsCache(WSNetDnsResolver *dnsResolver, DnsCacheCallback callback);
+    explicit DnsCache(DnsResolver_cares *dnsResolver, DnsCacheCallback callback);
     ~DnsCache();
 
     DnsCacheResult resolve(std::uint64_t id, const std::string &hostname, bool bypassCache = false);
     void clear();
 
+    DnsCacheStats stats();
+
 private:
-    WSNetDnsResolver *dnsResolver_;
+    static constexpr size_t kMaxEntries = 256;
+    static constexpr std::uint32_t kMinTtlSec = 5;
+    static constexpr std::uint32_t kMaxTtlSec = 3600;
+    // prefetch when a name is requested within the last 10% of its TTL
+    static constexpr int kPrefetchPercent = 10;
+
+    struct CacheEntry
+    {
+        std::vector<std::string> ips;
+        std::shared_ptr<WSNetRequestError> error;   // is set for the negative entries only
+        std::chrono::steady_clock::time_point expireTime;
+        std::chrono::steady_clock::time_point prefetchTime;
+        std::list<std::string>::iterator lruIt;
+    };
+
+    DnsResolver_cares *dnsResolver_;
     DnsCacheCallback callback_;
     std::mutex mutex_;
-    std::map<std::string, std::vector<std::string> > cache_;
+    std::unordered_map<std::string, CacheEntry> cache_;
+    std::list<std::string> lru_;    // the most recently used first
     std::map<std::uint64_t, std::shared_ptr<WSNetCancelableCallback> > activeRequests_;
+    std::map<std::string, std::shared_ptr<WSNetCancelableCallback> > prefetchRequests_;
+    DnsCacheStats stats_;
 
     std::optional<std::chrono::time_point<std::chrono::steady_clock> > tunnelTestLastLogTime_;
 
     void onDnsResolved(std::uint64_t id, const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result);
+    void onPrefetchResolved(const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result);
+    void updateEntry(const std::string &hostname, std::shared_ptr<WSNetDnsRequestResult> result);
+    void removeEntry(std::unordered_map<std::string, CacheEntry>::iterator it);
+    void logStats() const;
 };
 
 } // namespace wsnet
@@ -0,0 +1,38 @@
+#include "filedatasink.h"
+
+#ifdef _WIN32
+    #include <filesystem>
+#endif
+
+namespace wsnet {
+
+FileDataSink::FileDataSink(const std::string &path)
+{
+#ifdef _WIN32
+    // fopen does not understand UTF-8 paths on Windows
+    file_ = _wfopen(std::filesystem::u8path(path).c_str(), L"wb");
+#else
+    file_ = fopen(path.c_str(), "wb");
+#endif
+}
+
+FileDataSink::~FileDataSink()
+{
+    close();
+}
+
+bool FileDataSink::write(const char *data, size_t size)
+{
+    return file_ && fwrite(data, 1, size, file_) == size;
+}
+
+bool FileDataSink::close()
+{
+    if (!file_)
+        return false;
+    bool isOk = fclose(file_) == 0;
+    file_ = nullptr;
+    return isOk;
+}
+
+} // namespace wsnet
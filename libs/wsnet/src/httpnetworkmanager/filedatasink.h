@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include "idatasink.h"
+
+namespace wsnet {
+
+// Writes the response body to a file, the file is created or truncated
+class FileDataSink : public IDataSink
+{
+public:
+    // path in UTF-8
+    explicit FileDataSink(const std::string &path);
+    virtual ~FileDataSink();
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    bool write(const char *data, size_t size) override;
+    bool close() override;
+
+private:
+    FILE *file_ = nullptr;
+};
+
+} // namespace wsnet
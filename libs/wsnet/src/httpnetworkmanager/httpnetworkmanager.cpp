@@ -4,7 +4,7 @@
 
 namespace wsnet {
 
-HttpNetworkManager::HttpNetworkManager(boost::asio::io_context &io_context, WSNetDnsResolver *dnsResolver) :
+HttpNetworkManager::HttpNetworkManager(boost::asio::io_context &io_context, DnsResolver_cares *dnsResolver) :
     io_context_(io_context), impl_(io_context, dnsResolver)
 {
 }
@@ -90,5 +90,12 @@ void HttpNetworkManager::clearDnsCache()
     });
 }
 
+void HttpNetworkManager::resetConnections()
+{
+    boost::asio::post(io_context_, [this] {
+        impl_.resetConnections();
+    });
+}
+
 } // namespace wsnet
 
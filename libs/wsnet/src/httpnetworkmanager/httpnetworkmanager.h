@@ -10,7 +10,7 @@ namespace wsnet {
 class HttpNetworkManager : public WSNetHttpNetworkManager
 {
 public:
-    HttpNetworkManager(boost::asio::io_context &io_context, WSNetDnsResolver *dnsResolver);
+    HttpNetworkManager(boost::asio::io_context &io_context, DnsResolver_cares *dnsResolver);
 
     bool init();
 
@@ -39,6 +39,7 @@ public:
     std::shared_ptr<WSNetCancelableCallback> setWhitelistSocketsCallback(WSNetHttpNetworkManagerWhitelistSocketsCallback whitelistSocketsCallback) override;
 
     void clearDnsCache();
+    void resetConnections();
 
 private:
     boost::asio::io_context &io_context_;
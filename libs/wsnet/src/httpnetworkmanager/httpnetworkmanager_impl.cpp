@@ -1,11 +1,12 @@
 #include "httpnetworkmanager_impl.h"
+#include <algorithm>
 #include <spdlog/spdlog.h>
 #include "utils/utils.h"
 #include "utils/requesterror.h"
 
 namespace wsnet {
 
-HttpNetworkManager_impl::HttpNetworkManager_impl(boost::asio::io_context &io_context, WSNetDnsResolver *dnsResolver) :
+HttpNetworkManager_impl::HttpNetworkManager_impl(boost::asio::io_context &io_context, DnsResolver_cares *dnsResolver) :
     io_context_(io_context),
     dnsCache_(dnsResolver, std::bind(&HttpNetworkManager_impl::onDnsResolvedCallback, this, std::placeholders::_1)),
     curlNetworkManager_(std::bind(&HttpNetworkManager_impl::onCurlFinishedCallback, this, std::placeholders::_1, std::placeholders::_2),
@@ -72,6 +73,11 @@ void HttpNetworkManager_impl::clearDnsCache()
     dnsCache_.clear();
 }
 
+void HttpNetworkManager_impl::resetConnections()
+{
+    curlNetworkManager_.resetConnections();
+}
+
 void HttpNetworkManager_impl::onDnsResolvedCallback(const DnsCacheResult &result)
 {
     boost::asio::post(io_context_, [this, result] {
@@ -103,10 +109,21 @@ void HttpNetworkManager_impl::onDnsResolvedImpl(const DnsCacheResult &result)
 
     request->second.ips = result.ips;
 
-    if (request->second.request->isWhiteListIps())
-        whitelistIps(result.ips);
+    if (request->second.request->isWhiteListIps()) {
+        // The firewall rules are IPv4-only and IPv6 is blocked entirely while the firewall is on,
+        // so don't let curl waste the happy eyeballs delay on addresses that cannot connect.
+        auto &ips = request->second.ips;
+        ips.erase(std::remove_if(ips.begin(), ips.end(), [](const std::string &ip) { return ip.find(':') != std::string::npos; }), ips.end());
+        if (ips.empty()) {
+            // an IPv6-only host, curl cannot be given an empty address list
+            request->second.callbacks->callFinished(request->second.userDataId, (std::uint32_t)utils::since(request->second.startTime).count(), RequestError::createCaresNoData(), std::string());
+            requestsMap_.erase(request);
+            return;
+        }
+        whitelistIps(ips);
+    }
 
-    curlNetworkManager_.executeRequest(request->first, request->second.request, result.ips, request->second.request->timeoutMs() - result.elapsedMs);
+    curlNetworkManager_.executeRequest(request->first, request->second.request, request->second.ips, request->second.request->timeoutMs() - result.elapsedMs);
 }
 
 void HttpNetworkManager_impl::onCurlFinishedCallback(std::uint64_t requestId, std::shared_ptr<WSNetRequestError> error)
@@ -123,10 +140,10 @@ void HttpNetworkManager_impl::onCurlProgressCallback(std::uint64_t requestId, st
     });
 }
 
-void HttpNetworkManager_impl::onCurlReadyDataCallback(std::uint64_t requestId, const std::string &data)
+void HttpNetworkManager_impl::onCurlReadyDataCallback(std::uint64_t requestId, std::shared_ptr<DataSegment> segment)
 {
-    boost::asio::post(io_context_, [this, requestId, data] {
-        onCurlReadyDataCallbackImpl(requestId, data);
+    boost::asio::post(io_context_, [this, requestId, segment = std::move(segment)] {
+        onCurlReadyDataCallbackImpl(requestId, segment);
     });
 }
 
@@ -135,7 +152,13 @@ void HttpNetworkManager_impl::onCurlFinishedCallbackImpl(std::uint64_t requestId
     auto request = requestsMap_.find(requestId);
     if (request != requestsMap_.end()) {
         RequestData &rd = request->second;
-        rd.callbacks->callFinished(rd.userDataId, utils::since(rd.startTime).count(), error, rd.data);
+        // the only copy of the body, into the string of the exact size
+        std::string data;
+        data.reserve(rd.dataSize);
+        for (const auto &segment : rd.segments)
+            data.append(segment->data(), segment->size());
+        rd.segments.clear();
+        rd.callbacks->callFinished(rd.userDataId, utils::since(rd.startTime).count(), error, data);
         if (rd.request->isRemoveFromWhitelistIpsAfterFinish())
             removeWhitelistIps(rd.ips);
         requestsMap_.erase(requestId);
@@ -155,7 +178,7 @@ void HttpNetworkManager_impl::onCurlProgressCallbackImpl(std::uint64_t requestId
     }
 }
 
-void HttpNetworkManager_impl::onCurlReadyDataCallbackImpl(std::uint64_t requestId, const std::string &data)
+void HttpNetworkManager_impl::onCurlReadyDataCallbackImpl(std::uint64_t requestId, std::shared_ptr<DataSegment> segment)
 {
     auto request = requestsMap_.find(requestId);
     if (request != requestsMap_.end()) {
@@ -165,11 +188,11 @@ void HttpNetworkManager_impl::onCurlReadyDataCallbackImpl(std::uint64_t requestI
         } else {
             if (!rd.callbacks->isDataReadyNull()) {
                 // call callback
-                rd.callbacks->callDataReady(rd.userDataId, data);
+                rd.callbacks->callDataReady(rd.userDataId, std::string(segment->data(), segment->size()));
             } else {
-                // append data to internal data buffer
-                request->second.data.reserve( request->second.data.size() + data.size() );
-                request->second.data.insert( request->second.data.end(), data.begin(), data.end() );
+                // keep the segment until the request is finished
+                rd.dataSize += segment->size();
+                rd.segments.push_back(std::move(segment));
             }
         }
     }
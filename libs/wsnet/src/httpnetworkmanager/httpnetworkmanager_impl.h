@@ -3,7 +3,7 @@
 #include "WSNetHttpNetworkManager.h"
 #include <mutex>
 #include <boost/asio.hpp>
-#include "WSNetDnsResolver.h"
+#include "dnsresolver/dnsresolver_cares.h"
 #include "curlnetworkmanager.h"
 #include "dnscache.h"
 #include "utils/cancelablecallback.h"
@@ -15,7 +15,7 @@ using HttpNetworkManagerCallbacks = CancelableCallback3<WSNetHttpNetworkManagerF
 class HttpNetworkManager_impl
 {
 public:
-    HttpNetworkManager_impl(boost::asio::io_context &io_context, WSNetDnsResolver *dnsResolver);
+    HttpNetworkManager_impl(boost::asio::io_context &io_context, DnsResolver_cares *dnsResolver);
     virtual ~HttpNetworkManager_impl();
 
     bool init();
@@ -30,6 +30,7 @@ public:
     void setWhitelistSocketsCallback(std::shared_ptr<CancelableCallback<WSNetHttpNetworkManagerWhitelistSocketsCallback> > callback);
 
     void clearDnsCache();
+    void resetConnections();
 
 private:
     boost::asio::io_context &io_context_;
@@ -46,7 +47,8 @@ private:
         std::shared_ptr<HttpNetworkManagerCallbacks> callbacks;
         std::chrono::steady_clock::time_point startTime;
         std::vector<std::string> ips;
-        std::string data;
+        std::vector<std::shared_ptr<DataSegment>> segments;     // the response body, if there is no data ready callback
+        size_t dataSize = 0;
     };
 
     std::map<std::uint64_t, RequestData> requestsMap_;
@@ -59,11 +61,11 @@ private:
 
     void onCurlFinishedCallback(std::uint64_t requestId, std::shared_ptr<WSNetRequestError> error);
     void onCurlProgressCallback(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal);
-    void onCurlReadyDataCallback(std::uint64_t requestId, const std::string &data);
+    void onCurlReadyDataCallback(std::uint64_t requestId, std::shared_ptr<DataSegment> segment);
 
     void onCurlFinishedCallbackImpl(std::uint64_t requestId, std::shared_ptr<WSNetRequestError> error);
     void onCurlProgressCallbackImpl(std::uint64_t requestId, std::uint64_t bytesReceived, std::uint64_t bytesTotal);
-    void onCurlReadyDataCallbackImpl(std::uint64_t requestId, const std::string &data);
+    void onCurlReadyDataCallbackImpl(std::uint64_t requestId, std::shared_ptr<DataSegment> segment);
 
     void whitelistIps(const std::vector<std::string> &ips);
     void removeWhitelistIps(const std::vector<std::string> &ips);
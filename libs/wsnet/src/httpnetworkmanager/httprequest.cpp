@@ -20,6 +20,7 @@ struct HttpRequest::Impl
     bool isWhiteListIps = true;
     bool isDebugLogCurlError = false;
     bool isEnableFreshConnect = true;
+    std::string outputFilePath;
     skyr::url skyrUrl;
 };
 
@@ -189,5 +190,15 @@ bool HttpRequest::isEnableFreshConnect() const
     return pImpl_->isEnableFreshConnect;
 }
 
+void HttpRequest::setOutputFilePath(const std::string &path)
+{
+    pImpl_->outputFilePath = path;
+}
+
+std::string HttpRequest::outputFilePath() const
+{
+    return pImpl_->outputFilePath;
+}
+
 } // namespace wsnet
 
@@ -68,6 +68,11 @@ public:
     void setIsEnableFreshConnect(bool bEnabled) override;
     bool isEnableFreshConnect() const override;
 
+    // Write the response body directly to the file (UTF-8 path, created or truncated), the data callbacks get nothing then
+    // empty by default
+    void setOutputFilePath(const std::string &path) override;
+    std::string outputFilePath() const override;
+
 private:
     // internal implementation class (to hide include skyr/url.hpp from this header, there were compilation errors in Windows)
     struct Impl;
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace wsnet {
+
+// Receives the response body directly in the curl thread, instead of the data callbacks
+class IDataSink
+{
+public:
+    virtual ~IDataSink() {}
+
+    virtual bool write(const char *data, size_t size) = 0;
+    // returns false if the buffered data could not be written
+    virtual bool close() = 0;
+};
+
+} // namespace wsnet
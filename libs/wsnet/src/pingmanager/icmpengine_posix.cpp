@@ -0,0 +1,286 @@
+#include "icmpengine_posix.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
+#include <random>
+#include "utils/wsnet_logger.h"
+
+namespace wsnet {
+
+namespace {
+
+// type(1) code(1) checksum(2) identifier(2) sequence(2) nonce(8)
+constexpr size_t kEchoSize = 16;
+constexpr std::uint8_t kIcmpEchoRequest = 8;
+constexpr std::uint8_t kIcmpEchoReply = 0;
+
+} // namespace
+
+IcmpEngine_posix::IcmpEngine_posix(boost::asio::io_context &io_context) :
+    io_context_(io_context),
+    descriptor_(io_context)
+{
+    std::random_device rd;
+    identifier_ = static_cast<std::uint16_t>(rd());
+    nonce_ = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+
+    int fd = openSocket();
+    if (fd < 0) {
+        g_logger->warn("IcmpEngine_posix cannot create an ICMP socket, the ping utility will be used");
+        return;
+    }
+
+    boost::system::error_code ec;
+    descriptor_.assign(fd, ec);
+    if (ec) {
+        g_logger->error("IcmpEngine_posix cannot assign the socket: {}", ec.message());
+        close(fd);
+        return;
+    }
+    isAvailable_ = true;
+    g_logger->info("IcmpEngine_posix started with {} socket", isRawSocket_ ? "a raw" : "an unprivileged datagram");
+    waitForReplies();
+}
+
+IcmpEngine_posix::~IcmpEngine_posix()
+{
+    std::lock_guard locker(mutex_);
+    requests_.clear();
+    sequences_.clear();
+    boost::system::error_code ec;
+    descriptor_.close(ec);
+}
+
+std::uint64_t IcmpEngine_posix::ping(const std::string &ip, IcmpEngineCallback callback)
+{
+    if (!isAvailable_) {
+        return 0;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        return 0;
+    }
+
+    std::lock_guard locker(mutex_);
+    if (sequences_.size() >= 0xFFFF) {
+        return 0;
+    }
+    do {
+        curSequence_++;
+    } while (sequences_.find(curSequence_) != sequences_.end());
+
+    std::uint8_t packet[kEchoSize] = {};
+    packet[0] = kIcmpEchoRequest;
+    // the identifier of a datagram socket is replaced by the kernel
+    packet[4] = identifier_ >> 8;
+    packet[5] = identifier_ & 0xFF;
+    packet[6] = curSequence_ >> 8;
+    packet[7] = curSequence_ & 0xFF;
+    memcpy(packet + 8, &nonce_, sizeof(nonce_));
+    std::uint16_t sum = checksum(packet, kEchoSize);
+    memcpy(packet + 2, &sum, sizeof(sum));
+
+    const std::int64_t sentTimeUs = realtimeUs();
+    if (sendto(descriptor_.native_handle(), packet, kEchoSize, 0, (const sockaddr *)&addr, sizeof(addr)) != (ssize_t)kEchoSize) {
+        g_logger->error("IcmpEngine_posix cannot send an echo request to {}, errno: {}", ip, errno);
+        return 0;
+    }
+
+    std::uint64_t requestId = curRequestId_++;
+    Request &request = requests_[requestId];
+    request.callback = callback;
+    request.sequence = curSequence_;
+    request.addr = addr.sin_addr;
+    request.sentTimeUs = sentTimeUs;
+    request.timer = std::make_unique<boost::asio::steady_timer>(io_context_, std::chrono::milliseconds(kTimeoutMs));
+    request.timer->async_wait([this, requestId](const boost::system::error_code &ec) {
+        if (!ec) {
+            onTimeout(requestId);
+        }
+    });
+    sequences_[curSequence_] = requestId;
+    return requestId;
+}
+
+void IcmpEngine_posix::cancel(std::uint64_t requestId)
+{
+    std::lock_guard locker(mutex_);
+    auto it = requests_.find(requestId);
+    if (it != requests_.end()) {
+        sequences_.erase(it->second.sequence);
+        requests_.erase(it);
+    }
+}
+
+int IcmpEngine_posix::openSocket()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
+    if (fd < 0) {
+        fd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+        if (fd < 0) {
+            return -1;
+        }
+        isRawSocket_ = true;
+    }
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    int on = 1;
+#ifdef SO_TIMESTAMPNS
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+#else
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+#endif
+    return fd;
+}
+
+void IcmpEngine_posix::waitForReplies()
+{
+    descriptor_.async_wait(boost::asio::posix::stream_descriptor::wait_read, [this](const boost::system::error_code &ec) {
+        if (ec) {
+            if (ec != boost::asio::error::operation_aborted) {
+                g_logger->error("IcmpEngine_posix wait error: {}", ec.message());
+            }
+            return;
+        }
+        readReplies();
+        waitForReplies();
+    });
+}
+
+void IcmpEngine_posix::readReplies()
+{
+    std::uint8_t buf[1500];
+    char control[256];
+    sockaddr_in from;
+
+    // drain the socket, replies from a whole batch of requests arrive close to each other
+    for (;;) {
+        iovec iov = { buf, sizeof(buf) };
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &from;
+        msg.msg_namelen = sizeof(from);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t len = recvmsg(descriptor_.native_handle(), &msg, MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        std::int64_t receivedTimeUs = -1;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+#ifdef SO_TIMESTAMPNS
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                receivedTimeUs = (std::int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+            }
+#else
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP) {
+                timeval tv;
+                memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+                receivedTimeUs = (std::int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+            }
+#endif
+        }
+        if (receivedTimeUs < 0) {
+            receivedTimeUs = realtimeUs();
+        }
+
+        // raw sockets (and datagram sockets on macOS) deliver the IP header too
+        const std::uint8_t *p = buf;
+        if (len >= 20 && (p[0] >> 4) == 4) {
+            const size_t headerLen = (p[0] & 0x0F) * 4;
+            if ((size_t)len < headerLen) {
+                continue;
+            }
+            p += headerLen;
+            len -= headerLen;
+        }
+        if ((size_t)len < kEchoSize || p[0] != kIcmpEchoReply) {
+            continue;
+        }
+
+        const std::uint16_t identifier = (p[4] << 8) | p[5];
+        const std::uint16_t sequence = (p[6] << 8) | p[7];
+        if (isRawSocket_ && identifier != identifier_) {
+            continue;   // a reply to another process
+        }
+        if (memcmp(p + 8, &nonce_, sizeof(nonce_)) != 0) {
+            continue;
+        }
+
+        IcmpEngineCallback callback;
+        std::int32_t timeMs = 0;
+        {
+            std::lock_guard locker(mutex_);
+            auto itSeq = sequences_.find(sequence);
+            if (itSeq == sequences_.end()) {
+                continue;   // a late reply to a request that has timed out
+            }
+            auto it = requests_.find(itSeq->second);
+            if (it->second.addr.s_addr != from.sin_addr.s_addr) {
+                continue;
+            }
+            timeMs = (std::int32_t)std::max<std::int64_t>(0, (receivedTimeUs - it->second.sentTimeUs) / 1000);
+            callback = std::move(it->second.callback);
+            requests_.erase(it);
+            sequences_.erase(itSeq);
+        }
+        callback(true, timeMs);
+    }
+}
+
+void IcmpEngine_posix::onTimeout(std::uint64_t requestId)
+{
+    IcmpEngineCallback callback;
+    {
+        std::lock_guard locker(mutex_);
+        auto it = requests_.find(requestId);
+        if (it == requests_.end()) {
+            return;
+        }
+        callback = std::move(it->second.callback);
+        sequences_.erase(it->second.sequence);
+        requests_.erase(it);
+    }
+    callback(false, -1);
+}
+
+std::uint16_t IcmpEngine_posix::checksum(const std::uint8_t *data, size_t size)
+{
+    std::uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        std::uint16_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum += word;
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<std::uint16_t>(~sum);
+}
+
+std::int64_t IcmpEngine_posix::realtimeUs()
+{
+    // the same clock as the kernel receive timestamps
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (std::int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+} // namespace wsnet
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <netinet/in.h>
+#include <boost/asio.hpp>
+
+namespace wsnet {
+
+typedef std::function<void(bool isSuccess, std::int32_t timeMs)> IcmpEngineCallback;
+
+// In-process ICMP echo for posix systems, replaces running the ping utility for every host.
+// All echo requests go through one socket: an unprivileged ICMP datagram socket if the system allows it,
+// otherwise a raw socket. Replies are matched by sequence number (and identifier for raw sockets),
+// the round trip time is measured with kernel receive timestamps.
+// If neither socket can be created, isAvailable() returns false and the caller should use the ping utility.
+// Thread safe
+class IcmpEngine_posix
+{
+public:
+    explicit IcmpEngine_posix(boost::asio::io_context &io_context);
+    virtual ~IcmpEngine_posix();
+
+    bool isAvailable() const { return isAvailable_; }
+
+    // Sends one echo request to an IPv4 address. The callback is called from the io_context thread.
+    // Returns the request id or 0 if the request can't be sent.
+    std::uint64_t ping(const std::string &ip, IcmpEngineCallback callback);
+    // Forgets the request, its callback is not called after return unless it's already running in the io_context thread
+    void cancel(std::uint64_t requestId);
+
+    static constexpr int kTimeoutMs = 2000;
+
+private:
+    struct Request
+    {
+        IcmpEngineCallback callback;
+        std::uint16_t sequence;
+        in_addr addr;
+        std::int64_t sentTimeUs;
+        std::unique_ptr<boost::asio::steady_timer> timer;
+    };
+
+    boost::asio::io_context &io_context_;
+    boost::asio::posix::stream_descriptor descriptor_;
+    bool isAvailable_ = false;
+    bool isRawSocket_ = false;
+    std::uint16_t identifier_;
+    std::uint64_t nonce_;
+
+    std::mutex mutex_;
+    std::uint64_t curRequestId_ = 1;
+    std::uint16_t curSequence_ = 0;
+    std::unordered_map<std::uint64_t, Request> requests_;
+    std::unordered_map<std::uint16_t, std::uint64_t> sequences_;
+
+    int openSocket();
+    void waitForReplies();
+    void readReplies();
+    void onTimeout(std::uint64_t requestId);
+
+    static std::uint16_t checksum(const std::uint8_t *data, size_t size);
+    static std::int64_t realtimeUs();
+};
+
+} // namespace wsnet
@@ -29,7 +29,7 @@ public:
 
     void callCallback()
     {
-        callback_->call(ip_, isSuccess_, timeMs_, isFromDisconnectedVpnState_);
+        callback_->call(ip_, isSuccess_, timeMs_, isFromDisconnectedVpnState_, connectTimeMs_, handshakeTimeMs_);
     }
 
     void callFinished()
@@ -53,6 +53,9 @@ protected:
     bool isFromDisconnectedVpnState_ = true;
     bool isSuccess_ = false;
     std::int32_t timeMs_ = -1;
+    // measured by the TCP and TLS pings only
+    std::int32_t connectTimeMs_ = -1;
+    std::int32_t handshakeTimeMs_ = -1;
     bool isParallelPing_;
 };
 
@@ -1,6 +1,7 @@
 #include "pingmanager.h"
 #include <spdlog/spdlog.h>
 #include "pingmethod_http.h"
+#include "pingmethod_tcp.h"
 #include "utils/wsnet_logger.h"
 
 #ifdef _WIN32
@@ -17,9 +18,16 @@ PingManager::PingManager(boost::asio::io_context &io_context, WSNetHttpNetworkMa
     advancedParameters_(advancedParameters),
     connectState_(connectState)
 {
+    sslContext_ = SSL_CTX_new(TLS_client_method());
+    if (sslContext_) {
+        SSL_CTX_set_min_proto_version(sslContext_, TLS1_2_VERSION);
+    } else {
+        g_logger->error("PingManager cannot create SSL context, TLS pings will only connect");
+    }
 
 #if !defined _WIN32 && !defined IS_TVOS
     processManager_ = std::make_unique<ProcessManager>(io_context);
+    icmpEngine_ = std::make_unique<IcmpEngine_posix>(io_context);
 #endif
 }
 
@@ -33,6 +41,12 @@ PingManager::~PingManager()
     processManager_.reset();
 #endif
     map_.clear();
+#if !defined _WIN32 && !defined IS_TVOS
+    // the ICMP ping methods cancel their requests in the engine when they are destroyed, so it goes after them
+    icmpEngine_.reset();
+#endif
+    if (sslContext_)
+        SSL_CTX_free(sslContext_);
     g_logger->info("PingManager destructor finished");
 }
 
@@ -46,8 +60,8 @@ std::shared_ptr<WSNetCancelableCallback> PingManager::ping(const std::string &ip
     map_[curPingId_] = std::unique_ptr<IPingMethod>(ping);
 
     //TODO: add a delay between pings
-    // We do HTTPS-requests right away
-    if (pingType == PingType::kHttp) {
+    // We do HTTPS-requests, TCP/TLS pings and ICMP pings through the ICMP engine right away
+    if (!ping->isParallelPing()) {
         ping->ping(!connectState_.isVPNConnected());
     }
     // while tcp and icmp are in parallel in queue
@@ -82,6 +96,9 @@ IPingMethod *PingManager::createPingMethod(std::uint64_t id, const std::string &
 {
     if (pingType == PingType::kHttp) {
         return new PingMethodHttp(httpNetworkManager_, id, ip, hostname, false, callback, std::bind(&PingManager::onPingMethodFinished, this, std::placeholders::_1), advancedParameters_);
+    } else if (pingType == PingType::kTcp || pingType == PingType::kTls) {
+        return new PingMethodTcp(io_context_, pingType == PingType::kTls ? sslContext_ : nullptr, id, ip, hostname, false, callback,
+                                 std::bind(&PingManager::onPingMethodFinished, this, std::placeholders::_1));
     } else if (pingType == PingType::kIcmp) {
 
 #ifdef _WIN32
@@ -90,7 +107,9 @@ IPingMethod *PingManager::createPingMethod(std::uint64_t id, const std::string &
     g_logger->error("ICMP pings are not supported on Apple tvOS");
     assert(false);
 #else
-        return new PingMethodIcmp_posix(id, ip, hostname, true, callback, std::bind(&PingManager::onPingMethodFinished, this, std::placeholders::_1), processManager_.get());
+        // the ICMP engine sends all pings from one socket, so they don't need the limit of parallel ping processes
+        return new PingMethodIcmp_posix(id, ip, hostname, !icmpEngine_->isAvailable(), callback, std::bind(&PingManager::onPingMethodFinished, this, std::placeholders::_1),
+                                        processManager_.get(), icmpEngine_.get());
 #endif
     } else {
         assert(false);
@@ -3,6 +3,7 @@
 #include <queue>
 #include <map>
 #include <boost/asio.hpp>
+#include <openssl/ssl.h>
 #include "WSNetPingManager.h"
 #include "WSNetHttpNetworkManager.h"
 #include "WSNetAdvancedParameters.h"
@@ -13,6 +14,7 @@
     #include "eventcallbackmanager_win.h"
 #elif !defined IS_TVOS
     #include "processmanager.h"
+    #include "icmpengine_posix.h"
 #endif
 
 namespace wsnet {
@@ -31,13 +33,16 @@ private:
     boost::asio::io_context &io_context_;
     WSNetHttpNetworkManager *httpNetworkManager_;
     WSNetAdvancedParameters *advancedParameters_;
+    // Only builds ClientHello messages for the TLS pings
+    SSL_CTX *sslContext_ = nullptr;
 
 #ifdef _WIN32
     // Required for ICMP pings for Windows system
     EventCallbackManager_win eventCallbackManager_;
 #elif !defined IS_TVOS
-    // Required for ICMP pings for posix systems
+    // Required for ICMP pings for posix systems, the ping utility is used if the ICMP engine is not available
     std::unique_ptr<ProcessManager> processManager_;
+    std::unique_ptr<IcmpEngine_posix> icmpEngine_;
 #endif
     ConnectState &connectState_;
     std::mutex mutex_;
@@ -5,14 +5,19 @@
 namespace wsnet {
 
 PingMethodIcmp_posix::PingMethodIcmp_posix(std::uint64_t id, const std::string &ip, const std::string &hostname, bool isParallelPing,
-        PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback, ProcessManager *processManager) :
+        PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback, ProcessManager *processManager,
+        IcmpEngine_posix *icmpEngine) :
     IPingMethod(id, ip, hostname, isParallelPing, callback, pingMethodFinishedCallback),
-    processManager_(processManager)
+    processManager_(processManager),
+    icmpEngine_(icmpEngine)
 {
 }
 
 PingMethodIcmp_posix::~PingMethodIcmp_posix()
 {
+    if (icmpRequestId_ != 0) {
+        icmpEngine_->cancel(icmpRequestId_);
+    }
 }
 
 void PingMethodIcmp_posix::ping(bool isFromDisconnectedVpnState)
@@ -26,6 +31,16 @@ void PingMethodIcmp_posix::ping(bool isFromDisconnectedVpnState)
     using namespace std::placeholders;
     isFromDisconnectedVpnState_ = isFromDisconnectedVpnState;
 
+    // The pings of the engine are not limited by the queue of the ping manager, so one that cannot be sent fails.
+    // Falling back to the ping utility here would start a process for every node at once.
+    if (icmpEngine_ && icmpEngine_->isAvailable()) {
+        icmpRequestId_ = icmpEngine_->ping(ip_, std::bind(&PingMethodIcmp_posix::onIcmpEngineFinished, this, _1, _2));
+        if (icmpRequestId_ == 0) {
+            callFinished();
+        }
+        return;
+    }
+
     if (!processManager_->execute("ping", {"-c", "1", "-W", "2000", ip_}, std::bind(&PingMethodIcmp_posix::onProcessFinished, this, _1, _2))) {
         g_logger->error("PingMethodIcmp_posix::ping cannot execute ping command");
         callFinished();
@@ -33,6 +48,14 @@ void PingMethodIcmp_posix::ping(bool isFromDisconnectedVpnState)
     }
 }
 
+void PingMethodIcmp_posix::onIcmpEngineFinished(bool isSuccess, std::int32_t timeMs)
+{
+    icmpRequestId_ = 0;
+    isSuccess_ = isSuccess;
+    timeMs_ = timeMs;
+    callFinished();
+}
+
 void PingMethodIcmp_posix::onProcessFinished(int exitCode, const std::string &output)
 {
     if (exitCode == 0) {
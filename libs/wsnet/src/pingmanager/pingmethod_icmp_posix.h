@@ -2,6 +2,7 @@
 
 #include "ipingmethod.h"
 #include "processmanager.h"
+#include "icmpengine_posix.h"
 
 namespace wsnet {
 
@@ -9,14 +10,18 @@ class PingMethodIcmp_posix : public IPingMethod
 {
 public:
     PingMethodIcmp_posix(std::uint64_t id, const std::string &ip, const std::string &hostname, bool isParallelPing,
-                    PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback, ProcessManager *processManager);
+                    PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback, ProcessManager *processManager,
+                    IcmpEngine_posix *icmpEngine);
 
     virtual ~PingMethodIcmp_posix();
     void ping(bool isFromDisconnectedVpnState) override;
 
 private:
     ProcessManager *processManager_;
+    IcmpEngine_posix *icmpEngine_;
+    std::uint64_t icmpRequestId_ = 0;
 
+    void onIcmpEngineFinished(bool isSuccess, std::int32_t timeMs);
     void onProcessFinished(int exitCode, const std::string &output);
     int extractTimeMs(const std::string &str);
 };
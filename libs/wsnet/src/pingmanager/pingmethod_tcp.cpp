@@ -0,0 +1,247 @@
+#include "pingmethod_tcp.h"
+#include <cmath>
+#include <skyr/url.hpp>
+#include "utils/wsnet_logger.h"
+#include "utils/utils.h"
+
+namespace wsnet {
+
+// Owns the socket and the timer. Kept alive by the asio handlers, so the ping method can be deleted at any time.
+// All the socket operations are done in the io_context thread.
+class PingMethodTcp::Probe : public std::enable_shared_from_this<PingMethodTcp::Probe>
+{
+public:
+    typedef std::function<void(bool isSuccess, std::int64_t connectTimeUs, std::int64_t handshakeTimeUs)> ProbeCallback;
+
+    Probe(boost::asio::io_context &io_context, ProbeCallback callback) :
+        socket_(io_context),
+        timer_(io_context),
+        callback_(callback)
+    {
+    }
+
+    // Let OpenSSL build the ClientHello in advance, so the key generation is not included in the handshake time
+    bool prepareClientHello(SSL_CTX *sslContext, const std::string &serverName)
+    {
+        SSL *ssl = SSL_new(sslContext);
+        if (!ssl) {
+            return false;
+        }
+        SSL_set_bio(ssl, BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+        SSL_set_connect_state(ssl);
+        if (!serverName.empty()) {
+            SSL_set_tlsext_host_name(ssl, serverName.c_str());
+        }
+        SSL_do_handshake(ssl);
+
+        BIO *wbio = SSL_get_wbio(ssl);
+        const int size = BIO_pending(wbio);
+        if (size > 0) {
+            clientHello_.resize(size);
+            BIO_read(wbio, clientHello_.data(), size);
+        }
+        SSL_free(ssl);
+        return !clientHello_.empty();
+    }
+
+    void start(const boost::asio::ip::tcp::endpoint &endpoint, int timeoutMs)
+    {
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this(), endpoint, timeoutMs] {
+            self->connect(endpoint, timeoutMs);
+        });
+    }
+
+    // The callback will not be called after return, a call in progress is waited for
+    void cancel()
+    {
+        {
+            std::lock_guard locker(mutex_);
+            callback_ = nullptr;
+        }
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this()] {
+            self->finish(false);
+        });
+    }
+
+private:
+    // TLS record header(5): content type(1) version(2) length(2), then the handshake message type(1)
+    static constexpr size_t kServerHelloPrefixSize = 6;
+    static constexpr std::uint8_t kHandshakeRecord = 0x16;
+    static constexpr std::uint8_t kServerHello = 0x02;
+
+    boost::asio::ip::tcp::socket socket_;
+    boost::asio::steady_timer timer_;
+    // held while the callback runs, so cancel() can't return in the middle of it
+    std::recursive_mutex mutex_;
+    ProbeCallback callback_;
+
+    std::vector<std::uint8_t> clientHello_;
+    std::uint8_t reply_[kServerHelloPrefixSize];
+    size_t replySize_ = 0;
+    bool isFinished_ = false;
+
+    std::chrono::steady_clock::time_point startTime_;
+    std::int64_t connectTimeUs_ = -1;
+    std::int64_t handshakeTimeUs_ = -1;
+
+    std::int64_t elapsedUs() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime_).count();
+    }
+
+    void connect(const boost::asio::ip::tcp::endpoint &endpoint, int timeoutMs)
+    {
+        if (isFinished_) {
+            return;
+        }
+        timer_.expires_after(std::chrono::milliseconds(timeoutMs));
+        timer_.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+            if (!ec) {
+                self->finish(false);
+            }
+        });
+
+        startTime_ = std::chrono::steady_clock::now();
+        socket_.async_connect(endpoint, [self = shared_from_this()](const boost::system::error_code &ec) {
+            self->onConnected(ec);
+        });
+    }
+
+    void onConnected(const boost::system::error_code &ec)
+    {
+        if (ec || isFinished_) {
+            finish(false);
+            return;
+        }
+        connectTimeUs_ = elapsedUs();
+        if (clientHello_.empty()) {
+            finish(true);
+            return;
+        }
+
+        boost::system::error_code ignored;
+        socket_.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+        startTime_ = std::chrono::steady_clock::now();
+        boost::asio::async_write(socket_, boost::asio::buffer(clientHello_), [self = shared_from_this()](const boost::system::error_code &ec, std::size_t) {
+            if (ec) {
+                self->finish(false);
+                return;
+            }
+            self->readServerHello();
+        });
+    }
+
+    void readServerHello()
+    {
+        socket_.async_read_some(boost::asio::buffer(reply_ + replySize_, sizeof(reply_) - replySize_),
+                                [self = shared_from_this()](const boost::system::error_code &ec, std::size_t bytesTransferred) {
+            self->onRead(ec, bytesTransferred);
+        });
+    }
+
+    void onRead(const boost::system::error_code &ec, std::size_t bytesTransferred)
+    {
+        if (ec || isFinished_) {
+            finish(false);
+            return;
+        }
+        // the round trip ends with the first bytes of the answer
+        if (replySize_ == 0) {
+            handshakeTimeUs_ = elapsedUs();
+        }
+        replySize_ += bytesTransferred;
+        if (replySize_ < kServerHelloPrefixSize) {
+            readServerHello();
+            return;
+        }
+        // anything else, an alert for example, means the server does not talk TLS with us
+        finish(reply_[0] == kHandshakeRecord && reply_[5] == kServerHello);
+    }
+
+    void finish(bool isSuccess)
+    {
+        if (isFinished_) {
+            return;
+        }
+        isFinished_ = true;
+
+        boost::system::error_code ec;
+        timer_.cancel();
+        socket_.close(ec);
+
+        std::lock_guard locker(mutex_);
+        ProbeCallback callback = std::move(callback_);
+        callback_ = nullptr;
+        if (callback) {
+            callback(isSuccess, connectTimeUs_, handshakeTimeUs_);
+        }
+    }
+};
+
+PingMethodTcp::PingMethodTcp(boost::asio::io_context &io_context, SSL_CTX *sslContext, std::uint64_t id, const std::string &ip, const std::string &hostname,
+                             bool isParallelPing, PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback) :
+    IPingMethod(id, ip, hostname, isParallelPing, callback, pingMethodFinishedCallback),
+    io_context_(io_context),
+    sslContext_(sslContext)
+{
+}
+
+PingMethodTcp::~PingMethodTcp()
+{
+    if (probe_)
+        probe_->cancel();
+}
+
+void PingMethodTcp::ping(bool isFromDisconnectedVpnState)
+{
+    boost::system::error_code ec;
+    auto address = boost::asio::ip::make_address(ip_, ec);
+    if (ec) {
+        g_logger->error("PingMethodTcp::ping incorrect IP-address: {}", ip_);
+        callFinished();
+        return;
+    }
+
+    isFromDisconnectedVpnState_ = isFromDisconnectedVpnState;
+    using namespace std::placeholders;
+    probe_ = std::make_shared<Probe>(io_context_, std::bind(&PingMethodTcp::onProbeFinished, this, _1, _2, _3));
+    if (sslContext_ && !probe_->prepareClientHello(sslContext_, serverName())) {
+        g_logger->error("PingMethodTcp::ping cannot create the TLS ClientHello");
+        probe_.reset();
+        callFinished();
+        return;
+    }
+    probe_->start(boost::asio::ip::tcp::endpoint(address, PING_PORT), PING_TIMEOUT);
+}
+
+void PingMethodTcp::onProbeFinished(bool isSuccess, std::int64_t connectTimeUs, std::int64_t handshakeTimeUs)
+{
+    if (isSuccess) {
+        isSuccess_ = true;
+        if (sslContext_) {
+            // for the TLS ping the handshake round trip is the result, both times are reported
+            connectTimeMs_ = (std::int32_t)round(connectTimeUs / 1000.0);
+            handshakeTimeMs_ = (std::int32_t)round(handshakeTimeUs / 1000.0);
+            timeMs_ = handshakeTimeMs_;
+        } else {
+            connectTimeMs_ = (std::int32_t)round(connectTimeUs / 1000.0);
+            timeMs_ = connectTimeMs_;
+        }
+    }
+    callFinished();
+}
+
+std::string PingMethodTcp::serverName() const
+{
+    // the hostname is the URL of the HTTP ping, SNI needs only the host
+    std::string host = hostname_;
+    try {
+        host = skyr::url(hostname_).hostname();
+    }
+    catch(...) {
+    }
+    // SNI must not be an IP-address
+    return utils::isIpAddress(host) ? std::string() : host;
+}
+
+} // namespace wsnet
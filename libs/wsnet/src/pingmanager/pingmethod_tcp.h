@@ -0,0 +1,34 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <openssl/ssl.h>
+#include "ipingmethod.h"
+
+namespace wsnet {
+
+// Lightweight latency probe without curl: times only the TCP connect (SYN/SYN-ACK) and,
+// if sslContext is set, the TLS ClientHello/ServerHello exchange on port 443.
+// The connection is dropped as soon as the ServerHello arrives, the certificate chain is never verified.
+class PingMethodTcp : public IPingMethod
+{
+public:
+    // sslContext - nullptr for the TCP connect only ping
+    PingMethodTcp(boost::asio::io_context &io_context, SSL_CTX *sslContext, std::uint64_t id, const std::string &ip, const std::string &hostname,
+                  bool isParallelPing, PingFinishedCallback callback, PingMethodFinishedCallback pingMethodFinishedCallback);
+
+    virtual ~PingMethodTcp();
+    void ping(bool isFromDisconnectedVpnState) override;
+
+private:
+    enum { PING_TIMEOUT = 2000, PING_PORT = 443 };
+    class Probe;
+
+    boost::asio::io_context &io_context_;
+    SSL_CTX *sslContext_;
+    std::shared_ptr<Probe> probe_;
+
+    void onProbeFinished(bool isSuccess, std::int64_t connectTimeUs, std::int64_t handshakeTimeUs);
+    std::string serverName() const;
+};
+
+} // namespace wsnet
@@ -160,6 +160,9 @@ void ServerAPI_impl::executeRequestImpl(std::unique_ptr<BaseRequest> request, co
     using namespace std::placeholders;
     auto httpRequest = serverapi_utils::createHttpRequestWithFailoverParameters(httpNetworkManager_, failoverData, request.get(), bIgnoreSslErrors_, advancedParameters_->isAPIExtraTLSPadding());
     httpRequest->setIsDebugLogCurlError(true);
+    // The failover is already known to work here, so the requests can share a connection.
+    // RequestExecuterViaFailover keeps the fresh connect, a reused connection would hide a failing failover.
+    httpRequest->setIsEnableFreshConnect(false);
     std::uint64_t requestId = curUniqueId_++;
     auto asyncCallback_ = httpNetworkManager_->executeRequestEx(httpRequest, requestId, std::bind(&ServerAPI_impl::onHttpNetworkRequestFinished, this, _1, _2, _3, _4),
                                                            std::bind(&ServerAPI_impl::onHttpNetworkRequestProgressCallback, this, _1, _2, _3));
@@ -79,6 +79,11 @@ std::shared_ptr<WSNetRequestError> RequestError::createCaresTimeout()
     return std::make_shared<RequestError>(ARES_ETIMEOUT, RequestErrorType::kCurl);
 }
 
+std::shared_ptr<WSNetRequestError> RequestError::createCaresNoData()
+{
+    return std::make_shared<RequestError>(ARES_ENODATA, RequestErrorType::kCares);
+}
+
 
 } // namespace wsnet
 
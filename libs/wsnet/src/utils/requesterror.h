@@ -22,6 +22,8 @@ public:
 
     static std::shared_ptr<WSNetRequestError> createCaresSuccess();
     static std::shared_ptr<WSNetRequestError> createCaresTimeout();
+    // the name was resolved, but to no address the request can use
+    static std::shared_ptr<WSNetRequestError> createCaresNoData();
 
 private:
     int errorCode_;
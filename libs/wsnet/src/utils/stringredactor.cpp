@@ -0,0 +1,106 @@
+#include "stringredactor.h"
+#include <algorithm>
+#include <queue>
+
+namespace wsnet {
+
+void StringRedactor::addPattern(const std::string &pattern, const std::string &replacement)
+{
+    if (!pattern.empty())
+        patterns_.push_back(std::make_pair(pattern, replacement));
+}
+
+void StringRedactor::build()
+{
+    nodes_.clear();
+    nodes_.emplace_back();
+
+    // trie
+    for (int i = 0; i < (int)patterns_.size(); ++i) {
+        int cur = 0;
+        for (unsigned char c : patterns_[i].first) {
+            int next = findNext(cur, c);
+            if (next < 0) {
+                next = (int)nodes_.size();
+                nodes_[cur].next.push_back(std::make_pair(c, next));
+                nodes_.emplace_back();
+            }
+            cur = next;
+        }
+        if (nodes_[cur].pattern < 0)
+            nodes_[cur].pattern = i;
+    }
+
+    // fail links in BFS order, so the fail node is always processed before
+    std::queue<int> queue;
+    for (const auto &it : nodes_[0].next)
+        queue.push(it.second);
+    while (!queue.empty()) {
+        int cur = queue.front();
+        queue.pop();
+        for (const auto &it : nodes_[cur].next) {
+            int child = it.second;
+            int f = nodes_[cur].fail;
+            while (f > 0 && findNext(f, it.first) < 0)
+                f = nodes_[f].fail;
+            int failNext = findNext(f, it.first);
+            nodes_[child].fail = (failNext >= 0 && failNext != child) ? failNext : 0;
+            const int fail = nodes_[child].fail;
+            nodes_[child].dict = nodes_[fail].pattern >= 0 ? fail : nodes_[fail].dict;
+            queue.push(child);
+        }
+    }
+}
+
+std::string StringRedactor::redact(const char *data, size_t size) const
+{
+    if (nodes_.empty())
+        return std::string(data, size);
+
+    // (start, length, pattern) of every match
+    struct Match { size_t start; size_t length; int pattern; };
+    std::vector<Match> matches;
+    int cur = 0;
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = data[i];
+        int next;
+        while ((next = findNext(cur, c)) < 0 && cur > 0)
+            cur = nodes_[cur].fail;
+        cur = next < 0 ? 0 : next;
+        for (int node = nodes_[cur].pattern >= 0 ? cur : nodes_[cur].dict; node >= 0; node = nodes_[node].dict) {
+            const int pattern = nodes_[node].pattern;
+            const size_t length = patterns_[pattern].first.size();
+            matches.push_back(Match { i + 1 - length, length, pattern });
+        }
+    }
+    if (matches.empty())
+        return std::string(data, size);
+
+    std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+        return a.start < b.start || (a.start == b.start && a.length > b.length);
+    });
+
+    std::string result;
+    result.reserve(size);
+    size_t pos = 0;
+    for (const auto &m : matches) {
+        if (m.start < pos)
+            continue;   // overlaps the previous replacement
+        result.append(data + pos, m.start - pos);
+        result.append(patterns_[m.pattern].second);
+        pos = m.start + m.length;
+    }
+    result.append(data + pos, size - pos);
+    return result;
+}
+
+int StringRedactor::findNext(int node, unsigned char c) const
+{
+    for (const auto &it : nodes_[node].next) {
+        if (it.first == c)
+            return it.second;
+    }
+    return -1;
+}
+
+} // namespace wsnet
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wsnet {
+
+// Replaces several literal patterns in one pass over the text (Aho-Corasick automaton).
+// Overlapping matches are resolved leftmost first, then the longest one.
+// Build once with addPattern() + build(), after that redact() can be called any number of times.
+class StringRedactor
+{
+public:
+    void addPattern(const std::string &pattern, const std::string &replacement);
+    void build();
+
+    std::string redact(const char *data, size_t size) const;
+    bool isEmpty() const { return patterns_.empty(); }
+
+private:
+    struct Node
+    {
+        std::vector<std::pair<unsigned char, int>> next;    // usually a few transitions, a linear search is faster than a map
+        int fail = 0;
+        int pattern = -1;       // the pattern ending exactly in this node
+        int dict = -1;          // the nearest node on the fail chain with a pattern, to find the shorter matches
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<std::pair<std::string, std::string>> patterns_;   // pattern -> replacement
+
+    int findNext(int node, unsigned char c) const;
+};
+
+} // namespace wsnet
@@ -101,13 +101,19 @@ public:
     void setConnectivityState(bool isOnline) override
     {
         connectState_.setConnectivityState(isOnline);
+        // the network has changed, the system DNS-servers may be different now
+        dnsResolver_->reloadSystemDnsServers();
+        // and the pooled connections may be bound to an interface that is gone, the requests multiplexed on them would wait until the timeout
+        httpNetworkManager_->resetConnections();
     }
     void setIsConnectedToVpnState(bool isConnected) override
     {
         if (connectState_.isVPNConnected() != isConnected) {
             connectState_.setIsConnectedToVpnState(isConnected);
-            // When connecting/disconnecting the VPN clear the DNS cache.
+            // When connecting/disconnecting the VPN clear the DNS cache and drop the connections kept for reuse.
             httpNetworkManager_->clearDnsCache();
+            httpNetworkManager_->resetConnections();
+            dnsResolver_->reloadSystemDnsServers();
         }
     }
 